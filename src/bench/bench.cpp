@@ -0,0 +1,419 @@
+#include "bench/bench.h"
+
+#include "game/game.h"
+#include "game/move.h"
+#include "game/turn.h"
+#include "engine/engine.h"
+#include "engine/batch_analysis.h"
+#include "engine/resumable_search.h"
+#include "engine/evaluation.h"
+#include "engine/nnue.h"
+#include "engine/conversion.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/compact_move.h"
+
+#include <algorithm> // for std::min
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+
+static constexpr int NUM_POSITIONS = 100'000;
+static constexpr int EVALUATION_REPETITIONS = 20;
+static constexpr std::size_t EVALUATION_SLICE_SIZE = 5000; // positions timed at a time, short enough to rarely be interrupted
+static constexpr int NUM_SEARCH_POSITIONS = 32;
+static constexpr int MAX_PLAYOUT_LENGTH = 120;
+static constexpr unsigned int SEED = 12345;
+
+// the first positions of the list, which come from a handful of games, are analysed as one batch
+static constexpr int NUM_BATCH_POSITIONS = 480;
+static constexpr int BATCH_DEPTH = 9;
+
+// the resumable search is checked against the recursive one to this depth, a few hundred nodes at a time
+static constexpr int COMPARISON_DEPTH = 7;
+static constexpr std::uint64_t COMPARISON_STEP_NODES = 500;
+
+// the most a single static evaluation may cost, as a multiple of the cost of counting the material,
+// which is timed alongside it so the budget holds on fast and slow machines alike
+static constexpr double DEFAULT_EVALUATION_BUDGET = 40.0;
+
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+// the cheapest evaluation there is, used to measure the speed of the machine the benchmark runs on
+static int countMaterial(const Bitboard &board) {
+	const u32 men = ~board.king_pieces;
+
+	return (popcount(board.black_pieces & men) - popcount(board.white_pieces & men)) * 100
+		+ (popcount(board.black_pieces & board.king_pieces) - popcount(board.white_pieces & board.king_pieces)) * 140;
+}
+
+
+/**
+ * Runs a fixed set of benchmarks and prints the results.
+ * The positions used are generated from a fixed seed, so results are comparable between builds.
+ * The evaluation budget can be changed with --eval-budget followed by a multiple of the time taken to count
+ * the material of a position. --random-net followed by a file name writes a network of random weights
+ * to the file instead of running the benchmarks.
+ * @return Zero if the evaluation stayed within its budget, every way of evaluating the network gave the
+ *         same scores and the resumable search agreed with the recursive one, one otherwise.
+ */
+int Bench::run(int argc, char *argv[]) {
+	double evaluation_budget = DEFAULT_EVALUATION_BUDGET;
+
+	for (int i = 1; i < argc - 1; i++) {
+		if (std::strcmp(argv[i], "--eval-budget") == 0) {
+			evaluation_budget = std::atof(argv[i + 1]);
+		} else if (std::strcmp(argv[i], "--random-net") == 0) {
+			return writeRandomNetwork(argv[i + 1]);
+		}
+	}
+
+	generatePositions(NUM_POSITIONS);
+
+	std::cout << "Generated " << m_positions.size() << " positions\n";
+
+	double evaluation_cost = benchmarkEvaluation();
+	benchmarkNetwork();
+	bool network_paths_agree = checkNetworkPaths();
+	benchmarkSearch();
+	benchmarkBatchAnalysis();
+	bool searches_agree = compareResumableSearch();
+
+	if (evaluation_cost > evaluation_budget) {
+		std::cout << "Evaluation is over its budget of " << evaluation_budget << " times the material count\n";
+		return 1;
+	}
+
+	return (network_paths_agree && searches_agree) ? 0 : 1;
+}
+
+
+/**
+ * Fills the position list by playing random games from the starting position.
+ * @param count The number of positions to generate.
+ */
+void Bench::generatePositions(int count) {
+	std::mt19937 rng(SEED);
+
+	Game game;
+	game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+	const Bitboard start_board = convertBoardToBitboard(game.getBoard());
+
+	m_positions.clear();
+
+	while (static_cast<int>(m_positions.size()) < count) {
+		Bitboard board = start_board;
+		bool is_whites_turn = false;
+
+		for (int ply = 0; ply < MAX_PLAYOUT_LENGTH && static_cast<int>(m_positions.size()) < count; ply++) {
+			Bitboard next_positions[MAX_MOVES];
+			int moves_found = generateMoves(board, is_whites_turn, next_positions, nullptr);
+
+			if (moves_found == 0) {
+				break;
+			}
+
+			m_positions.push_back({board, is_whites_turn});
+
+			board = next_positions[std::uniform_int_distribution<int>(0, moves_found - 1)(rng)];
+			is_whites_turn = !is_whites_turn;
+		}
+	}
+}
+
+
+/**
+ * Times the static evaluation over the whole position list, and counting the material for comparison.
+ * The list is timed a slice at a time, each slice several times over with the two taking turns, and only
+ * the fastest time of each slice counts, so the result doesn't depend on what else the machine is doing.
+ * @return The time taken per evaluation as a multiple of the time taken to count the material.
+ */
+double Bench::benchmarkEvaluation() const {
+	const EvalWeights weights = EvalWeights::defaults();
+
+	std::int64_t checksum = 0;
+	std::int64_t material_checksum = 0;
+
+	// returns the time taken to evaluate the positions from begin to end in seconds
+	auto timeSlice = [this](std::size_t begin, std::size_t end, auto evaluate_position, std::int64_t *sum) {
+		auto start_time = std::chrono::steady_clock::now();
+
+		for (std::size_t i = begin; i < end; i++) {
+			*sum += evaluate_position(m_positions[i].board);
+		}
+
+		return secondsSince(start_time);
+	};
+
+	auto evaluatePosition = [&weights](const Bitboard &board) { return evaluate(board, weights); };
+
+	// called through a volatile pointer, as the evaluation is called in another file, otherwise a build
+	// for a machine with vector instructions counts the material of many positions at once
+	int (*volatile count_material)(const Bitboard &board) = countMaterial;
+	auto countPosition = [&count_material](const Bitboard &board) { return count_material(board); };
+
+	double evaluation_seconds = 0;
+	double material_seconds = 0;
+
+	for (std::size_t begin = 0; begin < m_positions.size(); begin += EVALUATION_SLICE_SIZE) {
+		std::size_t end = std::min(begin + EVALUATION_SLICE_SIZE, m_positions.size());
+		double fastest_evaluation = 0;
+		double fastest_material = 0;
+
+		for (int repetition = 0; repetition < EVALUATION_REPETITIONS; repetition++) {
+			double material = timeSlice(begin, end, countPosition, &material_checksum);
+			double evaluation = timeSlice(begin, end, evaluatePosition, &checksum);
+
+			fastest_material = (repetition == 0) ? material : std::min(fastest_material, material);
+			fastest_evaluation = (repetition == 0) ? evaluation : std::min(fastest_evaluation, evaluation);
+		}
+
+		material_seconds += fastest_material;
+		evaluation_seconds += fastest_evaluation;
+	}
+
+	double evaluation_ns = evaluation_seconds * 1e9 / m_positions.size();
+	double material_ns = material_seconds * 1e9 / m_positions.size();
+	double cost = evaluation_ns / material_ns;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Evaluation: " << evaluation_ns << " ns per position, " << cost << " times counting the material ("
+		<< material_ns << " ns) (checksums " << checksum << ", " << material_checksum << ")\n";
+
+	return cost;
+}
+
+
+/**
+ * Times the neural network evaluation, if a network was given on the command line.
+ * Consecutive positions in the list are mostly one move apart, so the incremental
+ * timing is close to what the search sees.
+ */
+void Bench::benchmarkNetwork() const {
+	const std::string &network_file = Engine::getDefaultOptions().network_file;
+
+	if (network_file.empty()) {
+		return;
+	}
+
+	std::shared_ptr<const NnueNetwork> network = NnueNetwork::loadFromFile(network_file);
+
+	if (network == nullptr) {
+		std::cout << "Network: could not load " << network_file << '\n';
+		return;
+	}
+
+	NnueNetwork::Accumulator accumulators[2];
+	std::int64_t checksum = 0;
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	for (const BenchPosition &position : m_positions) {
+		network->refreshAccumulator(position.board, &accumulators[0]);
+		checksum += network->evaluate(accumulators[0]);
+	}
+
+	double refresh_ns = secondsSince(start_time) * 1e9 / m_positions.size();
+
+	network->refreshAccumulator(m_positions[0].board, &accumulators[0]);
+
+	start_time = std::chrono::steady_clock::now();
+
+	for (size_t i = 1; i < m_positions.size(); i++) {
+		network->updateAccumulator(accumulators[(i - 1) % 2], m_positions[i - 1].board,
+			m_positions[i].board, &accumulators[i % 2]);
+		checksum += network->evaluate(accumulators[i % 2]);
+	}
+
+	double update_ns = secondsSince(start_time) * 1e9 / (m_positions.size() - 1);
+
+	std::cout << "Network: " << refresh_ns << " ns per position from scratch, "
+		<< update_ns << " ns per position incrementally (checksum " << checksum << ")\n";
+}
+
+
+/**
+ * Evaluates every position with each way of computing the network that the build includes,
+ * and checks they all give the same score. The network given on the command line is used,
+ * or a random one if there isn't one.
+ * @return True if every path gave the same score for every position.
+ */
+bool Bench::checkNetworkPaths() const {
+	const std::string &network_file = Engine::getDefaultOptions().network_file;
+	std::shared_ptr<const NnueNetwork> network = network_file.empty()
+		? NnueNetwork::createRandom(SEED) : NnueNetwork::loadFromFile(network_file);
+
+	if (network == nullptr) {
+		return true; // already reported by benchmarkNetwork()
+	}
+
+	const NnueNetwork::Path paths[] = {NnueNetwork::SCALAR_PATH, NnueNetwork::SSE2_PATH, NnueNetwork::AVX2_PATH};
+	const char *path_names[] = {"scalar", "SSE2", "AVX2"};
+	std::string checked_paths;
+	int num_different = 0;
+
+	for (int path = 1; path < 3; path++) {
+		if (!NnueNetwork::isPathAvailable(paths[path])) {
+			continue;
+		}
+
+		checked_paths += std::string(", ") + path_names[path];
+
+		for (const BenchPosition &position : m_positions) {
+			NnueNetwork::Accumulator accumulator;
+			network->refreshAccumulator(position.board, &accumulator);
+
+			if (network->evaluate(accumulator, paths[path]) != network->evaluate(accumulator, NnueNetwork::SCALAR_PATH)) {
+				num_different++;
+			}
+		}
+	}
+
+	if (checked_paths.empty()) {
+		std::cout << "Network paths: only scalar is built, nothing to compare\n";
+	} else if (num_different > 0) {
+		std::cout << "Network paths: " << num_different << " scores differ between scalar" << checked_paths << '\n';
+	} else {
+		std::cout << "Network paths: scalar" << checked_paths << " agree on " << m_positions.size() << " positions\n";
+	}
+
+	return num_different == 0;
+}
+
+
+/**
+ * Writes a network of random weights, always the same ones, for trying out the network evaluation
+ * without a trained network.
+ * @param path The file to write.
+ * @return Zero if the file was written, one otherwise.
+ */
+int Bench::writeRandomNetwork(const char *path) {
+	if (!NnueNetwork::createRandom(SEED)->saveToFile(path)) {
+		std::cout << "Could not write " << path << '\n';
+		return 1;
+	}
+
+	std::cout << "Wrote a network of random weights to " << path << '\n';
+	return 0;
+}
+
+
+/**
+ * Runs a full search on positions spread evenly through the position list.
+ */
+void Bench::benchmarkSearch() const {
+	Engine engine;
+	Game game;
+	game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+
+	std::uint64_t total_nodes = 0;
+	double total_seconds = 0;
+
+	const int stride = static_cast<int>(m_positions.size()) / NUM_SEARCH_POSITIONS;
+
+	for (int i = 0; i < NUM_SEARCH_POSITIONS; i++) {
+		const BenchPosition &position = m_positions[i * stride];
+
+		game.setBoard(convertBitboardToBoard(position.board));
+		game.setTurn(position.is_whites_turn ? Turn::WHITE : Turn::BLACK);
+
+		auto start_time = std::chrono::steady_clock::now();
+		engine.findBestMove(game);
+		total_seconds += secondsSince(start_time);
+		total_nodes += engine.getNodesSearched();
+	}
+
+	std::cout << "Search: " << total_nodes << " nodes in " << total_seconds << " s, "
+		<< static_cast<std::uint64_t>(total_nodes / total_seconds) << " nodes per second\n";
+
+	// only when there were tablebases, given with --tablebases or compiled in, and the positions got down to them
+	TablebaseProbeStats tablebase_stats = engine.getTablebaseStats();
+	if (tablebase_stats.probes > 0) {
+		std::uint64_t blocks = tablebase_stats.cache_hits + tablebase_stats.cache_misses;
+
+		std::cout << "Tablebases: " << tablebase_stats.probes << " probes, " << tablebase_stats.hits << " hits, "
+			<< (blocks > 0 ? tablebase_stats.cache_hits * 100.0 / blocks : 0.0) << "% of blocks cached\n";
+	}
+}
+
+
+/**
+ * Analyses the positions of a few whole games as one batch with a BatchAnalyser on every core.
+ */
+void Bench::benchmarkBatchAnalysis() const {
+	std::vector<AnalysisRequest> requests;
+
+	for (int i = 0; i < NUM_BATCH_POSITIONS && i < static_cast<int>(m_positions.size()); i++) {
+		AnalysisRequest request;
+		request.board = m_positions[i].board;
+		request.is_whites_turn = m_positions[i].is_whites_turn;
+		request.limits.depth = BATCH_DEPTH;
+		requests.push_back(request);
+	}
+
+	BatchAnalyser analyser(Engine::getDefaultOptions());
+
+	auto start_time = std::chrono::steady_clock::now();
+	analyser.analyse(requests);
+	double seconds = secondsSince(start_time);
+
+	std::cout << "Batch analysis: " << requests.size() << " positions to depth " << BATCH_DEPTH << " in "
+		<< seconds << " s on " << analyser.getNumThreads() << " threads, "
+		<< requests.size() / seconds << " positions per second\n";
+}
+
+/**
+ * Searches positions spread through the position list with both Engine::search() and a
+ * ResumableSearch, which keeps its own copy of the search, and checks they find the same
+ * score and best move after visiting the same number of nodes.
+ * Each search starts from an empty transposition table so neither benefits from the other.
+ * @return True if every position agreed.
+ */
+bool Bench::compareResumableSearch() const {
+	Engine engine;
+	const int hash_size_mb = Engine::getDefaultOptions().hash_size_mb;
+
+	SearchLimits limits;
+	limits.depth = COMPARISON_DEPTH;
+
+	const int stride = static_cast<int>(m_positions.size()) / NUM_SEARCH_POSITIONS;
+	int num_different = 0;
+
+	for (int i = 0; i < NUM_SEARCH_POSITIONS; i++) {
+		const BenchPosition &position = m_positions[i * stride];
+
+		engine.setHashSize(hash_size_mb);
+		SearchInfo expected = engine.search(position.board, position.is_whites_turn, limits);
+		std::uint64_t expected_nodes = engine.getNodesSearched();
+
+		engine.setHashSize(hash_size_mb);
+		std::unique_ptr<ResumableSearch> search = engine.createResumableSearch(position.board,
+			position.is_whites_turn, COMPARISON_DEPTH);
+		while (!search->step(COMPARISON_STEP_NODES)) {
+		}
+		SearchInfo actual = search->getResult();
+
+		if (actual.score != expected.score || !(actual.best_move == expected.best_move)
+				|| search->getNodesSearched() != expected_nodes) {
+			std::cout << "Resumable search differs on position " << i << ": score " << actual.score
+				<< " instead of " << expected.score << ", " << search->getNodesSearched() << " nodes instead of "
+				<< expected_nodes << (actual.best_move == expected.best_move ? "" : ", another best move") << '\n';
+			num_different++;
+		}
+	}
+
+	std::cout << "Resumable search: " << NUM_SEARCH_POSITIONS - num_different << " of " << NUM_SEARCH_POSITIONS
+		<< " positions match the recursive search to depth " << COMPARISON_DEPTH << '\n';
+
+	return num_different == 0;
+}
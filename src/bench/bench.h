@@ -0,0 +1,33 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+
+#include "engine/bitboard.h"
+
+#include <vector>
+
+
+class Bench {
+public:
+	int run(int argc, char *argv[]);
+
+private:
+	struct BenchPosition {
+		Bitboard board;
+		bool is_whites_turn;
+	};
+
+	void generatePositions(int count);
+	double benchmarkEvaluation() const;
+	void benchmarkNetwork() const;
+	bool checkNetworkPaths() const;
+	static int writeRandomNetwork(const char *path);
+	void benchmarkSearch() const;
+	void benchmarkBatchAnalysis() const;
+	bool compareResumableSearch() const;
+
+	std::vector<BenchPosition> m_positions;
+};
+
+
+#endif // BENCH_H
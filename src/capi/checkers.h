@@ -0,0 +1,88 @@
+#ifndef CHECKERS_C_H
+#define CHECKERS_C_H
+
+/*
+ * C interface to the checkers engine, for calling it in-process from other languages.
+ *
+ * Each engine is an opaque handle. Calls on one handle are serialised by a lock inside it,
+ * so a handle may be shared between threads, but for searches to run in parallel give each
+ * thread its own handle. checkers_stop() is the exception: it doesn't wait for the lock,
+ * so it can end a search running on another thread. It also ends searches whose calls are
+ * still waiting for the lock, but not those called after it.
+ *
+ * Squares are numbered 1 to 32 in move strings and FEN, and as bits 0 to 31 in board masks.
+ * Black starts on squares 1 to 12 and moves first.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(CHECKERS_CAPI_BUILD)
+#define CHECKERS_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define CHECKERS_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define CHECKERS_API __attribute__((visibility("default")))
+#else
+#define CHECKERS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct checkers_engine checkers_engine;
+
+typedef enum checkers_status {
+	CHECKERS_OK = 0,
+	CHECKERS_INVALID_ARGUMENT, /* a null pointer or out of range value */
+	CHECKERS_INVALID_POSITION, /* overlapping masks or unparsable FEN */
+	CHECKERS_NO_RESULT, /* no search has been run since the position was set, or there was no move */
+	CHECKERS_BUFFER_TOO_SMALL,
+	CHECKERS_ERROR, /* anything else, such as running out of memory */
+} checkers_status;
+
+/* settings of the engine when it is created, a zeroed struct gives the defaults */
+typedef struct checkers_options {
+	const char *weights_file; /* evaluation weights written by the tuner, or null */
+	const char *network_file; /* neural network evaluation, or null */
+	int hash_size_mb; /* transposition table size in MiB, zero for the default of 16 */
+} checkers_options;
+
+/* zero means no limit, with no limits at all the engine's normal depth is used */
+typedef struct checkers_limits {
+	int depth;
+	uint64_t nodes;
+	int time_ms;
+} checkers_limits;
+
+
+/* returns null on failure, which includes a file given in options that can't be loaded
+   and a negative hash size; options may be null for the defaults */
+CHECKERS_API checkers_engine* checkers_create(const checkers_options *options);
+CHECKERS_API void checkers_free(checkers_engine *engine);
+
+/* the position is only changed if it is valid */
+CHECKERS_API checkers_status checkers_set_position(checkers_engine *engine,
+	uint32_t black_pieces, uint32_t white_pieces, uint32_t king_pieces, int is_whites_turn);
+CHECKERS_API checkers_status checkers_set_position_fen(checkers_engine *engine, const char *fen);
+
+/* limits may be null for the defaults; blocks until the search ends */
+CHECKERS_API checkers_status checkers_search(checkers_engine *engine, const checkers_limits *limits);
+CHECKERS_API void checkers_stop(checkers_engine *engine);
+
+/* results of the last search, moves are written as null terminated strings like "11-15" or "15x24x31"
+   the score is for the side to move, a won game scores 30000 less the plies to its end and a lost one the negative
+   the pv is the moves of the line expected separated by spaces */
+CHECKERS_API checkers_status checkers_get_best_move(checkers_engine *engine, char *buffer, size_t size);
+CHECKERS_API checkers_status checkers_get_score(checkers_engine *engine, int *score);
+CHECKERS_API checkers_status checkers_get_pv(checkers_engine *engine, char *buffer, size_t size);
+CHECKERS_API checkers_status checkers_get_stats(checkers_engine *engine, int *depth, uint64_t *nodes);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHECKERS_C_H */
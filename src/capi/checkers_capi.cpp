@@ -0,0 +1,254 @@
+#include "capi/checkers.h"
+
+#include "game/board.h"
+#include "game/move.h"
+#include "game/notation.h"
+#include "game/turn.h"
+#include "engine/bitboard.h"
+#include "engine/conversion.h"
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/search_limits.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+
+
+struct checkers_engine {
+	explicit checkers_engine(const EngineOptions &options) :
+		engine(options)
+	{
+	}
+
+	std::mutex mutex; // held for every call except checkers_stop()
+	std::atomic<bool> stop {false};
+	std::atomic<std::uint64_t> num_searches {0}; // checkers_search() calls made, each one's ticket
+	std::atomic<std::uint64_t> stopped_through {0}; // the searches with tickets up to this are to stop
+
+	Engine engine;
+	Bitboard board {0x0000'0fffu, 0xfff0'0000u, 0};
+	bool is_whites_turn = false;
+
+	bool has_result = false;
+	SearchInfo result {};
+};
+
+
+// copies text and its terminator into buffer if it fits
+static checkers_status copyString(const std::string &text, char *buffer, size_t size) {
+	if (buffer == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+	if (text.size() + 1 > size) {
+		return CHECKERS_BUFFER_TOO_SMALL;
+	}
+
+	std::memcpy(buffer, text.c_str(), text.size() + 1);
+
+	return CHECKERS_OK;
+}
+
+
+checkers_engine* checkers_create(const checkers_options *options) {
+	EngineOptions engine_options;
+
+	if (options != nullptr && options->hash_size_mb < 0) {
+		return nullptr;
+	} else if (options != nullptr && options->hash_size_mb > 0) {
+		engine_options.hash_size_mb = options->hash_size_mb;
+	}
+
+	checkers_engine *engine;
+
+	try {
+		engine = new checkers_engine(engine_options);
+	} catch (...) {
+		return nullptr;
+	}
+
+	// the files are loaded here rather than through the options, which would only print a warning
+	// and carry on with the built in evaluation if one couldn't be loaded
+	if (options != nullptr
+			&& ((options->weights_file != nullptr && !engine->engine.loadEvalWeights(options->weights_file))
+			|| (options->network_file != nullptr && !engine->engine.loadNetwork(options->network_file)))) {
+		delete engine;
+		return nullptr;
+	}
+
+	return engine;
+}
+
+
+void checkers_free(checkers_engine *engine) {
+	delete engine;
+}
+
+
+checkers_status checkers_set_position(checkers_engine *engine,
+		uint32_t black_pieces, uint32_t white_pieces, uint32_t king_pieces, int is_whites_turn) {
+	if (engine == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	if ((black_pieces & white_pieces) != 0 || (king_pieces & ~(black_pieces | white_pieces)) != 0) {
+		return CHECKERS_INVALID_POSITION;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	engine->board = {black_pieces, white_pieces, king_pieces};
+	engine->is_whites_turn = (is_whites_turn != 0);
+	engine->has_result = false;
+
+	return CHECKERS_OK;
+}
+
+
+checkers_status checkers_set_position_fen(checkers_engine *engine, const char *fen) {
+	if (engine == nullptr || fen == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	Board board;
+	Turn turn;
+
+	if (!Notation::parseFen(fen, &board, &turn)) {
+		return CHECKERS_INVALID_POSITION;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	engine->board = convertBoardToBitboard(board);
+	engine->is_whites_turn = (turn == Turn::WHITE);
+	engine->has_result = false;
+
+	return CHECKERS_OK;
+}
+
+
+checkers_status checkers_search(checkers_engine *engine, const checkers_limits *limits) {
+	if (engine == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	SearchLimits search_limits;
+
+	if (limits != nullptr) {
+		if (limits->depth < 0 || limits->time_ms < 0) {
+			return CHECKERS_INVALID_ARGUMENT;
+		}
+		search_limits.depth = limits->depth;
+		search_limits.nodes = limits->nodes;
+		search_limits.time_ms = limits->time_ms;
+	}
+
+	search_limits.stop = &engine->stop;
+
+	// taken before waiting for the lock, so that a stop made while this call waits still applies to it
+	const std::uint64_t ticket = ++engine->num_searches;
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	engine->stop = (engine->stopped_through >= ticket);
+
+	try {
+		engine->result = engine->engine.search(engine->board, engine->is_whites_turn, search_limits);
+	} catch (...) {
+		engine->has_result = false;
+		return CHECKERS_ERROR;
+	}
+
+	engine->has_result = engine->result.best_move.exists();
+
+	return engine->has_result ? CHECKERS_OK : CHECKERS_NO_RESULT;
+}
+
+
+// ends the search running on engine and any waiting to run, if there are any
+void checkers_stop(checkers_engine *engine) {
+	if (engine != nullptr) {
+		engine->stopped_through = engine->num_searches.load();
+		engine->stop = true;
+	}
+}
+
+
+checkers_status checkers_get_best_move(checkers_engine *engine, char *buffer, size_t size) {
+	if (engine == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	if (!engine->has_result) {
+		return CHECKERS_NO_RESULT;
+	}
+
+	return copyString(Notation::getMoveString(convertCompactMoveToNormalMove(engine->result.best_move)), buffer, size);
+}
+
+
+checkers_status checkers_get_score(checkers_engine *engine, int *score) {
+	if (engine == nullptr || score == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	if (!engine->has_result) {
+		return CHECKERS_NO_RESULT;
+	}
+
+	*score = engine->result.score;
+
+	return CHECKERS_OK;
+}
+
+
+checkers_status checkers_get_pv(checkers_engine *engine, char *buffer, size_t size) {
+	if (engine == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	if (!engine->has_result) {
+		return CHECKERS_NO_RESULT;
+	}
+
+	std::string pv;
+	for (int i = 0; i < engine->result.pv_length; i++) {
+		if (i > 0) {
+			pv += ' ';
+		}
+		pv += Notation::getMoveString(convertCompactMoveToNormalMove(engine->result.pv[i]));
+	}
+
+	return copyString(pv, buffer, size);
+}
+
+
+checkers_status checkers_get_stats(checkers_engine *engine, int *depth, uint64_t *nodes) {
+	if (engine == nullptr) {
+		return CHECKERS_INVALID_ARGUMENT;
+	}
+
+	std::lock_guard<std::mutex> lock(engine->mutex);
+
+	if (!engine->has_result) {
+		return CHECKERS_NO_RESULT;
+	}
+
+	if (depth != nullptr) {
+		*depth = engine->result.depth;
+	}
+	if (nodes != nullptr) {
+		*nodes = engine->engine.getNodesSearched();
+	}
+
+	return CHECKERS_OK;
+}
@@ -0,0 +1,131 @@
+#include "cli/command_line.h"
+
+#include "tui/tui.h"
+#include "bench/bench.h"
+#include "perft/perft.h"
+#include "protocol/protocol.h"
+#include "server/server.h"
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+
+#include <cstring>
+#include <iostream>
+
+
+// an option read by one of the frontends, which each read their own options from the arguments again
+struct FrontendOption {
+	const char *name;
+	bool takes_value;
+};
+
+
+static const FrontendOption FRONTEND_OPTIONS[] = {
+	{"--eval-budget", true},
+	{"--random-net", true},
+	{"--fen", true},
+	{"--divide", false},
+	{"--unmoves", false},
+	{"--threads", true},
+	{"--min-depth", true},
+};
+
+
+static void printUsage(std::ostream &out, const char *program, bool has_gui) {
+	out << "usage: " << program << " [--tui | --bench | --perft [DEPTH] | --engine | --serve [SOCKET]] [OPTIONS]\n"
+		<< "with none of these, the " << (has_gui ? "graphical" : "text") << " game is played\n"
+		<< (has_gui ? "  --tui              play in the terminal\n" : "")
+		<< "  --bench            time the engine, with --eval-budget X, or --random-net FILE to write a network\n"
+		<< "  --perft [DEPTH]    count the positions to each depth, with --fen FEN, --divide and --unmoves\n"
+		<< "  --engine           read commands from stdin and reply on stdout\n"
+		<< "  --serve [SOCKET]   serve searches on a local socket, with --threads N and --min-depth D\n"
+		<< "engine options: --hash MB, --weights FILE, --nnue FILE, --book FILE, --tablebases DIR,\n"
+		<< "  --tb-cache MB, --no-bitbases, --no-exchange-pruning, --record-tree FILE, --record-ply N\n";
+}
+
+
+// reads the frontend option at argv[*index], if it is one, moving *index past its value
+// returns false if argv[*index] isn't a frontend option or its value is missing
+static bool parseFrontendOption(int argc, char *argv[], int *index) {
+	for (const FrontendOption &option : FRONTEND_OPTIONS) {
+		if (std::strcmp(argv[*index], option.name) != 0) {
+			continue;
+		}
+
+		if (option.takes_value) {
+			if (*index + 1 >= argc) {
+				return false;
+			}
+			++*index;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * Picks the frontend from the arguments, sets the engine options they give, and runs it.
+ * Used by both the Qt build and checkers_cli, which passes no GUI and plays in the terminal by default.
+ * @param run_gui Runs the graphical frontend, or null if the build doesn't have one.
+ * @return The frontend's exit status, zero after --help, or one if an argument isn't known
+ *         or is missing its value, after printing the usage.
+ */
+int runCommandLine(int argc, char *argv[], GuiFunction run_gui) {
+	const bool has_gui = (run_gui != nullptr);
+	bool run_tui = false;
+	bool run_bench = false;
+	bool run_perft = false;
+	bool run_protocol = false;
+	bool run_server = false;
+	EngineOptions engine_options;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+			printUsage(std::cout, argv[0], has_gui);
+			return 0;
+		} else if (std::strcmp(argv[i], "--tui") == 0) {
+			run_tui = true;
+		} else if (std::strcmp(argv[i], "--bench") == 0) {
+			run_bench = true;
+		} else if (std::strcmp(argv[i], "--perft") == 0) {
+			run_perft = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				i++; // the depth
+			}
+		} else if (std::strcmp(argv[i], "--engine") == 0) {
+			run_protocol = true;
+		} else if (std::strcmp(argv[i], "--serve") == 0) {
+			run_server = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				i++; // the socket path
+			}
+		} else if (!parseEngineOption(argc, argv, &i, &engine_options) && !parseFrontendOption(argc, argv, &i)) {
+			std::cerr << "Unknown argument or missing value: " << argv[i] << '\n';
+			printUsage(std::cerr, argv[0], has_gui);
+			return 1;
+		}
+	}
+
+	Engine::setDefaultOptions(engine_options);
+
+	if (run_server) {
+		Server server;
+		return server.run(argc, argv);
+	} else if (run_protocol) {
+		Protocol protocol;
+		return protocol.run(argc, argv);
+	} else if (run_bench) {
+		Bench bench;
+		return bench.run(argc, argv);
+	} else if (run_perft) {
+		Perft perft;
+		return perft.run(argc, argv);
+	} else if (run_tui || !has_gui) {
+		Tui tui;
+		return tui.run(argc, argv);
+	} else {
+		return run_gui(argc, argv);
+	}
+}
@@ -0,0 +1,11 @@
+#ifndef COMMAND_LINE_H
+#define COMMAND_LINE_H
+
+
+// the function that runs the graphical frontend, which only the Qt build has
+typedef int (*GuiFunction)(int argc, char *argv[]);
+
+int runCommandLine(int argc, char *argv[], GuiFunction run_gui);
+
+
+#endif // COMMAND_LINE_H
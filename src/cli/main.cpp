@@ -0,0 +1,9 @@
+// entry point of the headless build, which has every frontend except the GUI
+// and so doesn't need Qt
+
+#include "cli/command_line.h"
+
+
+int main(int argc, char *argv[]) {
+	return runCommandLine(argc, argv, nullptr);
+}
@@ -0,0 +1,95 @@
+#include "engine/analysis.h"
+
+#include "engine/conversion.h"
+#include "game/game.h"
+#include "game/turn.h"
+
+#include <chrono>
+
+
+static std::int64_t currentTimeUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+Analysis::Analysis(Engine *engine, int update_interval_ms) :
+	m_engine(engine),
+	m_update_interval_us(update_interval_ms * 1000LL)
+{
+}
+
+
+Analysis::~Analysis() {
+	stop();
+}
+
+
+// starts analysing the game's current position, after stopping any analysis already running
+// the positions the game has already been through are scored as draws, as in a normal search
+// updates left over from an earlier position are thrown away
+void Analysis::start(const Game &game) {
+	stop();
+
+	SearchInfo stale;
+	while (poll(&stale)) {
+	}
+
+	m_board = convertBoardToBitboard(game.getBoard());
+	m_is_whites_turn = (game.getTurn() == Turn::WHITE);
+	m_history = Engine::getHistoryKeys(game);
+	if (!m_history.empty()) {
+		m_history.pop_back(); // the position being analysed
+	}
+	m_stop = false;
+	m_limits = SearchLimits();
+	m_limits.infinite = true;
+	m_limits.stop = &m_stop;
+	m_last_partial_time_us = 0;
+
+	m_thread = std::thread([this]() {
+		m_engine->setInfoCallback([this](const SearchInfo &info) { publish(info); });
+		m_engine->search(m_board, m_is_whites_turn, m_limits, m_history);
+		m_engine->setInfoCallback(nullptr);
+	});
+}
+
+
+// stops the search and waits for it to end, the updates it published can still be polled
+void Analysis::stop() {
+	m_stop = true;
+
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+
+bool Analysis::isRunning() const {
+	return m_thread.joinable() && !m_stop;
+}
+
+
+// takes the oldest update not yet seen, returning false if there isn't one
+// must always be called from the same thread
+bool Analysis::poll(SearchInfo *update) {
+	return m_updates.pop(update) || m_overflow.take(update);
+}
+
+
+// called on the search thread
+void Analysis::publish(const SearchInfo &info) {
+	if (info.partial) {
+		std::int64_t now_us = currentTimeUs();
+
+		if (now_us - m_last_partial_time_us < m_update_interval_us) {
+			return;
+		}
+		m_last_partial_time_us = now_us;
+	}
+
+	// once an update has overflowed the later ones go the same way until it is taken, so they stay in order
+	if (m_overflow.isPending() || !m_updates.push(info)) {
+		m_overflow.store(info);
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+
+#include "engine/engine.h"
+#include "engine/search_limits.h"
+#include "engine/spsc_queue.h"
+#include "engine/latest_value.h"
+#include "engine/bitboard.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+class Game;
+
+
+// searches a position on its own thread until stopped, publishing its progress for a user interface
+//
+// every finished depth is published, and new best moves found partway through a depth at most
+// once per update interval. updates go through a lock-free queue which the interface polls from
+// one thread of its own, so however slowly it reads them the search is never held up:
+// when the queue is full, updates are merged into a single slot holding the newest of them until
+// the interface has caught up, so it always ends up with the latest line even if it misses some
+//
+// the engine mustn't be used for anything else while the analysis is running
+class Analysis {
+public:
+	explicit Analysis(Engine *engine, int update_interval_ms = 100);
+	~Analysis();
+
+	void start(const Game &game);
+	void stop();
+	bool isRunning() const;
+
+	bool poll(SearchInfo *update);
+
+private:
+	void publish(const SearchInfo &info);
+
+	static constexpr std::size_t QUEUE_SIZE = 64;
+
+	Engine *m_engine;
+	const std::int64_t m_update_interval_us;
+
+	std::thread m_thread;
+	std::atomic<bool> m_stop {false};
+	SearchLimits m_limits;
+	Bitboard m_board;
+	bool m_is_whites_turn = false;
+	std::vector<u64> m_history;
+
+	SpscQueue<SearchInfo, QUEUE_SIZE> m_updates;
+	LatestValue<SearchInfo> m_overflow; // newer than everything in m_updates while it holds an update
+	std::int64_t m_last_partial_time_us = 0; // only used by the search thread
+};
+
+
+#endif // ANALYSIS_H
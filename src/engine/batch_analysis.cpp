@@ -0,0 +1,75 @@
+#include "engine/batch_analysis.h"
+
+#include <algorithm> // for std::min, std::max
+#include <atomic>
+#include <thread>
+
+
+// num_threads defaults to the number of cores
+// options.hash_size_mb is the size of the one table shared by every engine
+// the engines never record their search trees, whatever options.record_tree_file says
+BatchAnalyser::BatchAnalyser(const EngineOptions &options, int num_threads) {
+	if (num_threads <= 0) {
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	EngineOptions engine_options = options;
+	engine_options.hash_size_mb = 0; // the engines use the shared table instead of their own
+	engine_options.record_tree_file.clear(); // the engines would all truncate and write the same file
+
+	if (options.hash_size_mb > 0) {
+		m_transposition_table = std::make_shared<TranspositionTable>(options.hash_size_mb);
+	}
+
+	for (int i = 0; i < num_threads; i++) {
+		m_engines.emplace_back(new Engine(engine_options));
+		m_engines.back()->setTranspositionTable(m_transposition_table);
+	}
+}
+
+
+// searches every request and returns the results in the same order
+// blocks until all of them are done
+std::vector<SearchInfo> BatchAnalyser::analyse(const std::vector<AnalysisRequest> &requests) {
+	std::vector<SearchInfo> results(requests.size());
+	std::atomic<std::size_t> next_chunk(0);
+
+	auto work = [&](Engine *engine) {
+		std::size_t begin;
+		while ((begin = next_chunk.fetch_add(CHUNK_SIZE)) < requests.size()) {
+			std::size_t end = std::min(begin + CHUNK_SIZE, requests.size());
+
+			for (std::size_t i = begin; i < end; i++) {
+				const AnalysisRequest &request = requests[i];
+				results[i] = engine->search(request.board, request.is_whites_turn, request.limits);
+			}
+		}
+	};
+
+	// the calling thread does a share of the work too
+	std::vector<std::thread> workers;
+	for (std::size_t i = 1; i < m_engines.size(); i++) {
+		workers.emplace_back(work, m_engines[i].get());
+	}
+
+	work(m_engines[0].get());
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	return results;
+}
+
+
+// forgets everything learnt from earlier positions, not safe to call during analyse()
+void BatchAnalyser::clearHash() {
+	if (m_transposition_table != nullptr) {
+		m_transposition_table->clear();
+	}
+}
+
+
+int BatchAnalyser::getNumThreads() const {
+	return static_cast<int>(m_engines.size());
+}
@@ -0,0 +1,44 @@
+#ifndef BATCH_ANALYSIS_H
+#define BATCH_ANALYSIS_H
+
+
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/search_limits.h"
+#include "engine/transposition_table.h"
+#include "engine/bitboard.h"
+
+#include <memory>
+#include <vector>
+
+
+struct AnalysisRequest {
+	Bitboard board;
+	bool is_whites_turn;
+	SearchLimits limits;
+};
+
+
+// searches many positions at once on a pool of engines, one per thread, which share a
+// transposition table so work done on one position helps with related ones
+// the table is kept between calls to analyse(), so a game can be passed in several batches
+class BatchAnalyser {
+public:
+	explicit BatchAnalyser(const EngineOptions &options, int num_threads = 0);
+
+	std::vector<SearchInfo> analyse(const std::vector<AnalysisRequest> &requests);
+	void clearHash();
+
+	int getNumThreads() const;
+
+private:
+	// consecutive requests handed to a worker at a time, so positions that follow each other
+	// in a game are usually searched in order by the same engine
+	static constexpr int CHUNK_SIZE = 8;
+
+	std::shared_ptr<TranspositionTable> m_transposition_table;
+	std::vector<std::unique_ptr<Engine>> m_engines;
+};
+
+
+#endif // BATCH_ANALYSIS_H
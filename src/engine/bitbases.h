@@ -0,0 +1,22 @@
+#ifndef BITBASES_H
+#define BITBASES_H
+
+
+#include <cstddef>
+
+
+// the tables of every material signature with up to a few pieces, which checkers_bitbase_gen solves while
+// the engine is built so they are compiled into it and there from the start without reading any files
+// each holds what checkers_tbgen would write to the signature's file, see src/engine/tablebase.cpp
+struct BuiltInTable {
+	const char *name; // the signature's name, see getSignatureName()
+	const unsigned char *file;
+	std::size_t file_size;
+};
+
+
+extern const BuiltInTable *const built_in_tables;
+extern const int num_built_in_tables;
+
+
+#endif // BITBASES_H
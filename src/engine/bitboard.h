@@ -6,6 +6,7 @@
 
 
 using u32 = std::uint32_t;
+using u64 = std::uint64_t;
 
 
 struct Bitboard {
@@ -15,4 +16,35 @@ struct Bitboard {
 };
 
 
+// returns the number of bits set in bits
+// the builtin is only used when it compiles to a single instruction, otherwise
+// it becomes a library call which is slower than counting the bits in parallel
+inline int popcount(u32 bits) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || defined(__aarch64__))
+	return __builtin_popcount(bits);
+#else
+	bits = bits - ((bits >> 1) & 0x5555'5555);
+	bits = (bits & 0x3333'3333) + ((bits >> 2) & 0x3333'3333);
+	bits = (bits + (bits >> 4)) & 0x0f0f'0f0f;
+	return static_cast<int>((bits * 0x0101'0101) >> 24);
+#endif
+}
+
+
+// returns the index of the least significant bit set in bits
+// expects bits to be non-zero
+inline int lsbIndex(u32 bits) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctz(bits);
+#else
+	int index = 0;
+	while (!(bits & 1)) {
+		bits >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+
 #endif
@@ -0,0 +1,65 @@
+#ifndef BITBOARD_MASKS_H
+#define BITBOARD_MASKS_H
+
+
+#include "engine/bitboard.h"
+
+
+// board geometry shared by the bitboard move generator and the evaluation
+// bit n of each mask corresponds to position n on the board
+
+
+// these masks stop moves near the edges of the board being made if
+// the landing square of the move is outside the boards boundaries
+static constexpr u32 move_mask[4] = { // where normal moves are allowed
+	0b1110'1111'1110'1111'1110'1111'1110'0000, // up left
+	0b1111'0111'1111'0111'1111'0111'1111'0000, // up right
+	0b0000'0111'1111'0111'1111'0111'1111'0111, // down right
+	0b0000'1111'1110'1111'1110'1111'1110'1111, // down left
+};
+static constexpr u32 jump_mask[4] = { // where jumping moves are allowed
+	0b1110'1110'1110'1110'1110'1110'0000'0000, // up left
+	0b0111'0111'0111'0111'0111'0111'0000'0000, // up right
+	0b0000'0000'0111'0111'0111'0111'0111'0111, // down right
+	0b0000'0000'1110'1110'1110'1110'1110'1110, // down left
+};
+
+// the left shift to get the adjacent square for each direction:
+static constexpr int even_shift[4] = {4, 3, -5, -4}; // on even rows
+static constexpr int odd_shift[4] = {5, 4, -4, -3}; // on odd rows
+
+// the left shift to get the square beyond the adjacent square:
+static constexpr int jump_shift[4] = {9, 7, -9, -7}; // on even and odd rows
+
+// these masks are used because finding an adjacent square requires
+// combining two different bit shifted boards by even and odd rows
+static constexpr u32 even_row = 0b0000'1111'0000'1111'0000'1111'0000'1111;
+static constexpr u32 odd_row = 0b1111'0000'1111'0000'1111'0000'1111'0000;
+
+// masks for the crowning row of each side that makes a piece a king
+static constexpr u32 black_crown_row = 0b1111'0000'0000'0000'0000'0000'0000'0000;
+static constexpr u32 white_crown_row = 0b0000'0000'0000'0000'0000'0000'0000'1111;
+
+// directions are: up left, up right, down right, down left
+static constexpr int NUM_DIRECTIONS = 4;
+
+
+// shifts left if shift value is positive, otherwise right
+inline u32 signedBitshift(u32 bits, int shift) {
+	if (shift >= 0) {
+		return bits << shift;
+	} else {
+		return bits >> -shift;
+	}
+}
+
+
+// returns the squares whose adjacent square in direction is one of squares
+// (this ignores the board edges, mask the result with move_mask where that matters)
+inline u32 squaresAdjacentTo(u32 squares, int direction) {
+	return (signedBitshift(squares, even_shift[direction]) & even_row)
+		| (signedBitshift(squares, odd_shift[direction]) & odd_row);
+}
+
+
+#endif // BITBOARD_MASKS_H
@@ -1,54 +1,10 @@
 #include "engine/bitboard_movegen.h"
 
 #include "engine/bitboard.h"
+#include "engine/bitboard_masks.h"
 #include "engine/compact_move.h"
 
 
-// these masks stop moves near the edges of the board being made if
-// the landing square of the move is outside the boards boundaries
-static constexpr u32 move_mask[4] = { // where normal moves are allowed
-	0b1110'1111'1110'1111'1110'1111'1110'0000, // up left
-	0b1111'0111'1111'0111'1111'0111'1111'0000, // up right
-	0b0000'0111'1111'0111'1111'0111'1111'0111, // down right
-	0b0000'1111'1110'1111'1110'1111'1110'1111, // down left
-};
-static constexpr u32 jump_mask[4] = { // where jumping moves are allowed
-	0b1110'1110'1110'1110'1110'1110'0000'0000, // up left
-	0b0111'0111'0111'0111'0111'0111'0000'0000, // up right
-	0b0000'0000'0111'0111'0111'0111'0111'0111, // down right
-	0b0000'0000'1110'1110'1110'1110'1110'1110, // down left
-};
-
-// the left shift to get the adjacent square for each direction:
-static constexpr int even_shift[4] = {4, 3, -5, -4}; // on even rows
-static constexpr int odd_shift[4] = {5, 4, -4, -3}; // on odd rows
-
-// the left shift to get the square beyond the adjacent square:
-static constexpr int jump_shift[4] = {9, 7, -9, -7}; // on even and odd rows
-
-// these masks are used because finding an adjacent square requires
-// combining two different bit shifted boards by even and odd rows
-static constexpr u32 even_row = 0b0000'1111'0000'1111'0000'1111'0000'1111;
-static constexpr u32 odd_row = 0b1111'0000'1111'0000'1111'0000'1111'0000;
-
-// masks for the crowning row of each side that makes a piece a king
-static constexpr u32 black_crown_row = 0b1111'0000'0000'0000'0000'0000'0000'0000;
-static constexpr u32 white_crown_row = 0b0000'0000'0000'0000'0000'0000'0000'1111;
-
-// directions are: up left, up right, down right, down left
-static constexpr int NUM_DIRECTIONS = 4;
-
-
-// shifts left if shift value is positive, otherwise right
-static uint32_t signedBitshift(uint32_t bits, int shift) {
-	if (shift >= 0) {
-		return bits << shift;
-	} else {
-		return bits >> -shift;
-	}
-}
-
-
 // returns the index of the most significant bit set in value
 // expects value to be non-zero
 // the lowest bit has index zero
@@ -180,51 +136,91 @@ static int findDoubleJumps(const Bitboard &board, const u32 piece_position, Bitb
 }
 
 
+// returns the pieces out of movers that can jump in direction
+static inline u32 findJumpers(u32 movers, u32 their_pieces, u32 empty_squares, int direction) {
+	return movers
+		& jump_mask[direction] // don't allow moving outside of board
+		& squaresAdjacentTo(their_pieces, direction) // their piece is adjacent
+		& signedBitshift(empty_squares, jump_shift[direction]); // square beyond is empty
+}
+
+
+// returns the pieces out of movers that can make a normal move in direction
+static inline u32 findSteppers(u32 movers, u32 empty_squares, int direction) {
+	return movers
+		& move_mask[direction] // don't allow moving outside of board
+		& squaresAdjacentTo(empty_squares, direction); // adjacent square is empty
+}
+
+
+// finds which of the given player's pieces can move in each direction
+// movables is an out parameter with one mask per direction, each bit marking a piece that can move that way
+// returns true if the moves found are jumps (in which case only jumps are reported, since they are compulsory)
+// this runs at every node and in the evaluation, so each direction is written out with a constant
+// direction index, which lets the compiler turn the table lookups and shifts into immediates
+bool findMovablePieces(const Bitboard &board, bool is_whites_turn, u32 *movables) {
+	// get piece types from perspective of player to move
+	const u32 my_pieces = is_whites_turn ? board.white_pieces : board.black_pieces;
+	const u32 their_pieces = is_whites_turn ? board.black_pieces : board.white_pieces;
+	const u32 empty_squares = ~(my_pieces | their_pieces);
+
+	// only kings can move backwards, white moves up the board and black moves down
+	const u32 my_kings = my_pieces & board.king_pieces;
+	const u32 up_movers = is_whites_turn ? my_pieces : my_kings;
+	const u32 down_movers = is_whites_turn ? my_kings : my_pieces;
+
+	movables[0] = findJumpers(up_movers, their_pieces, empty_squares, 0);
+	movables[1] = findJumpers(up_movers, their_pieces, empty_squares, 1);
+	movables[2] = findJumpers(down_movers, their_pieces, empty_squares, 2);
+	movables[3] = findJumpers(down_movers, their_pieces, empty_squares, 3);
+
+	if (movables[0] | movables[1] | movables[2] | movables[3]) {
+		return true;
+	}
+
+	movables[0] = findSteppers(up_movers, empty_squares, 0);
+	movables[1] = findSteppers(up_movers, empty_squares, 1);
+	movables[2] = findSteppers(down_movers, empty_squares, 2);
+	movables[3] = findSteppers(down_movers, empty_squares, 3);
+
+	return false;
+}
+
+
+// returns true if the side to move has a jump, which is quicker to find out than which pieces can move
+bool canJump(const Bitboard &board, bool is_whites_turn) {
+	const u32 my_pieces = is_whites_turn ? board.white_pieces : board.black_pieces;
+	const u32 their_pieces = is_whites_turn ? board.black_pieces : board.white_pieces;
+	const u32 empty_squares = ~(my_pieces | their_pieces);
+
+	const u32 my_kings = my_pieces & board.king_pieces;
+	const u32 up_movers = is_whites_turn ? my_pieces : my_kings;
+	const u32 down_movers = is_whites_turn ? my_kings : my_pieces;
+
+	return (findJumpers(up_movers, their_pieces, empty_squares, 0)
+		| findJumpers(up_movers, their_pieces, empty_squares, 1)
+		| findJumpers(down_movers, their_pieces, empty_squares, 2)
+		| findJumpers(down_movers, their_pieces, empty_squares, 3)) != 0;
+}
+
+
+// returns true if the side to move has any move, without generating them
+bool canMove(const Bitboard &board, bool is_whites_turn) {
+	u32 movables[NUM_DIRECTIONS];
+	findMovablePieces(board, is_whites_turn, movables);
+
+	return (movables[0] | movables[1] | movables[2] | movables[3]) != 0;
+}
+
+
 // returns number of moves found
 // next_positions is an out parameter pointing to an array to populate
 // moves is an out parameter pointing to a moves list to populate (can be null if not needed)
 // assumes output arrays are large enough to hold result
 int generateMoves(const Bitboard &board, bool is_whites_turn, Bitboard *next_positions, CompactMove *moves) {
-	// get piece types from perspective of player to move
-	const u32 my_pieces = is_whites_turn ? board.white_pieces : board.black_pieces;
-	const u32 their_pieces = is_whites_turn ? board.black_pieces : board.white_pieces;
-	const u32 empty_squares = ~(my_pieces | their_pieces);
-	
 	u32 movables[NUM_DIRECTIONS];
-	bool found_moves = false;
-	bool is_jumping_move = false;
-
-	for (int checking_for_jumps = 1; checking_for_jumps >= 0; checking_for_jumps--) {
-		for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
-			movables[direction] = my_pieces; // only my pieces can move
-			if (is_whites_turn != (direction < NUM_DIRECTIONS / 2)) { // checking for moves in backwards direction
-				movables[direction] &= board.king_pieces; // only kings can go this way
-				if (!movables[direction]) {
-					continue;
-				}
-			}
-			if (checking_for_jumps) {
-				movables[direction] &= jump_mask[direction]; // don't allow moving outside of board
-				movables[direction] &= // their piece is adjacent
-					(signedBitshift(their_pieces, even_shift[direction]) & even_row)
-					| (signedBitshift(their_pieces, odd_shift[direction]) & odd_row);
-				movables[direction] &= // square beyond is empty
-					signedBitshift(empty_squares, jump_shift[direction]);
-			} else { // not checking for jumps
-				movables[direction] &= move_mask[direction]; // don't allow moving outside of board
-				movables[direction] &= // adjacent square is empty
-					(signedBitshift(empty_squares, even_shift[direction]) & even_row)
-					| (signedBitshift(empty_squares, odd_shift[direction]) & odd_row);
-			}
-			if (movables[direction]) {
-				found_moves = true;
-			}
-		}
-		if (checking_for_jumps && found_moves) {
-			is_jumping_move = true;
-			break;
-		}
-	}
+
+	const bool is_jumping_move = findMovablePieces(board, is_whites_turn, movables);
 
 	int moves_found = 0;
 
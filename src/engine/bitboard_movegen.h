@@ -2,14 +2,34 @@
 #define BITBOARD_MOVEGEN_H
 
 
-struct Bitboard;
+#include "engine/bitboard.h"
+
+
 class CompactMove;
 
 
 constexpr int MAX_MOVES = 49;
 
+// a position can only come round again this many plies after the last capture or man move
+constexpr int MIN_REPETITION_PLIES = 4;
+
 
+bool findMovablePieces(const Bitboard &board, bool is_whites_turn, u32 *movables);
+bool canJump(const Bitboard &board, bool is_whites_turn);
+bool canMove(const Bitboard &board, bool is_whites_turn);
 int generateMoves(const Bitboard &board, bool is_whites_turn, Bitboard *next_positions, CompactMove *moves);
 
 
+// returns false if the move from before to after captured or moved a man, neither of which can be undone,
+// so that no position before it can be reached again
+inline bool isReversibleMove(const Bitboard &before, const Bitboard &after) {
+	const u32 men_before = ~before.king_pieces;
+	const u32 men_after = ~after.king_pieces;
+
+	return (before.black_pieces & men_before) == (after.black_pieces & men_after)
+		&& (before.white_pieces & men_before) == (after.white_pieces & men_after)
+		&& popcount(before.black_pieces | before.white_pieces) == popcount(after.black_pieces | after.white_pieces);
+}
+
+
 #endif // BITBOARD_MOVEGEN_H
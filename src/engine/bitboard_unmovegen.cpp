@@ -0,0 +1,168 @@
+#include "engine/bitboard_unmovegen.h"
+
+#include "engine/bitboard.h"
+#include "engine/bitboard_masks.h"
+#include "engine/bitboard_movegen.h"
+
+
+// each side starts with this many pieces and can never have more
+static constexpr int MAX_PIECES_PER_SIDE = 12;
+
+
+// returns the direction that takes a piece back to where a move in direction started
+static inline int getOppositeDirection(int direction) {
+	return (direction + NUM_DIRECTIONS / 2) % NUM_DIRECTIONS;
+}
+
+
+// returns true if men of the given side move in direction, white moves up the board and black moves down
+static inline bool isForwards(int direction, bool is_white) {
+	return is_white == (direction < NUM_DIRECTIONS / 2);
+}
+
+
+// square should have a single bit set, and a square next to it in direction
+static inline u32 getAdjacentSquare(u32 square, int direction) {
+	return signedBitshift(square, square & even_row ? -even_shift[direction] : -odd_shift[direction]);
+}
+
+
+// adds the positions that a move without a capture by the given side can have led to board from
+// a move like that can only have been made when there was nothing to capture
+static void findQuietUnmoves(const Bitboard &board, bool is_white, std::vector<Bitboard> *previous_positions) {
+	const u32 my_pieces = is_white ? board.white_pieces : board.black_pieces;
+	const u32 my_kings = my_pieces & board.king_pieces;
+	const u32 my_crown_row = is_white ? white_crown_row : black_crown_row;
+	const u32 empty_squares = ~(board.black_pieces | board.white_pieces);
+
+	for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+		const int back = getOppositeDirection(direction);
+		const bool is_forwards = isForwards(direction, is_white);
+
+		// the pieces that can have come in direction from an empty square
+		u32 returners = (is_forwards ? my_pieces : my_kings)
+			& move_mask[back] // don't allow moving outside of board
+			& squaresAdjacentTo(empty_squares, back); // square it came from is empty
+
+		for (; returners; returners &= returners - 1) {
+			const u32 piece_position = returners & (~returners + 1); // get least significant bit of returners
+			const u32 start_position = getAdjacentSquare(piece_position, back);
+
+			Bitboard before = board;
+			(is_white ? before.white_pieces : before.black_pieces) ^= piece_position | start_position;
+			before.king_pieces &= ~piece_position;
+
+			if (piece_position & my_kings) {
+				before.king_pieces |= start_position;
+				if (!canJump(before, is_white)) {
+					previous_positions->push_back(before);
+				}
+
+				// it may also have been a man that was crowned by the move
+				if (!is_forwards || !(piece_position & my_crown_row)) {
+					continue;
+				}
+				before.king_pieces &= ~start_position;
+			}
+
+			if (!canJump(before, is_white)) {
+				previous_positions->push_back(before);
+			}
+		}
+	}
+}
+
+
+// adds the positions before each sequence of up to captures_left jumps that ends with the piece on
+// piece_position where it is on board, is_king being whether it was a king while it jumped
+// the captured pieces are put back as men, unless they would be on the row that crowns them, and as kings
+static void findUncaptures(const Bitboard &board, u32 piece_position, bool is_king, int captures_left,
+		std::vector<Bitboard> *previous_positions) {
+	const bool is_white = board.white_pieces & piece_position;
+	const u32 their_crown_row = is_white ? black_crown_row : white_crown_row;
+	const u32 empty_squares = ~(board.black_pieces | board.white_pieces);
+
+	if (popcount(is_white ? board.black_pieces : board.white_pieces) >= MAX_PIECES_PER_SIDE) {
+		return; // there is no room to put back another of their pieces
+	}
+
+	for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+		if (!is_king && !isForwards(direction, is_white)) {
+			continue; // non kings cannot move backwards
+		}
+
+		const int back = getOppositeDirection(direction);
+		if (!(piece_position & jump_mask[back])) {
+			continue; // the jump would have started outside of the board
+		}
+
+		const u32 jumped_position = getAdjacentSquare(piece_position, back);
+		const u32 start_position = signedBitshift(piece_position, jump_shift[direction]);
+
+		if (!(empty_squares & jumped_position) || !(empty_squares & start_position)) {
+			continue; // the piece jumped or the square the jump started from is still occupied
+		}
+
+		Bitboard before = board;
+		(is_white ? before.white_pieces : before.black_pieces) ^= piece_position | start_position;
+		(is_white ? before.black_pieces : before.white_pieces) |= jumped_position;
+		before.king_pieces &= ~piece_position;
+		if (is_king) {
+			before.king_pieces |= start_position;
+		}
+
+		if (!(jumped_position & their_crown_row)) {
+			previous_positions->push_back(before);
+			if (captures_left > 1) {
+				findUncaptures(before, start_position, is_king, captures_left - 1, previous_positions);
+			}
+		}
+
+		before.king_pieces |= jumped_position;
+		previous_positions->push_back(before);
+		if (captures_left > 1) {
+			findUncaptures(before, start_position, is_king, captures_left - 1, previous_positions);
+		}
+	}
+}
+
+
+// finds the positions that one move by the side that isn't to move leads to board from, the reverse of generateMoves()
+// a position is listed once for every move from it that leads to board, so the lists agree with those of generateMoves()
+// captures are only undone for moves that capture at most max_captures pieces, as kings can have
+// come a very long way round, zero leaves out every capture
+// returns number of positions found
+// previous_positions is an out parameter that is cleared and then populated, reusing it saves allocating memory
+int generateUnmoves(const Bitboard &board, bool is_whites_turn, int max_captures, std::vector<Bitboard> *previous_positions) {
+	const bool is_white = !is_whites_turn;
+
+	previous_positions->clear();
+	findQuietUnmoves(board, is_white, previous_positions);
+
+	if (max_captures <= 0) {
+		return static_cast<int>(previous_positions->size());
+	}
+
+	// a sequence of jumps only ends when there are no more jumps for the piece, or it was just crowned
+	u32 movables[NUM_DIRECTIONS];
+	const u32 jumpers = findMovablePieces(board, is_white, movables)
+		? movables[0] | movables[1] | movables[2] | movables[3] : 0;
+
+	const u32 my_pieces = is_white ? board.white_pieces : board.black_pieces;
+	const u32 my_crown_row = is_white ? white_crown_row : black_crown_row;
+
+	for (u32 pieces = my_pieces; pieces; pieces &= pieces - 1) {
+		const u32 piece_position = pieces & (~pieces + 1); // get least significant bit of pieces
+		const bool is_king = piece_position & board.king_pieces;
+
+		if (!(piece_position & jumpers)) {
+			findUncaptures(board, piece_position, is_king, max_captures, previous_positions);
+		}
+
+		if (is_king && (piece_position & my_crown_row)) {
+			findUncaptures(board, piece_position, false, max_captures, previous_positions);
+		}
+	}
+
+	return static_cast<int>(previous_positions->size());
+}
@@ -0,0 +1,13 @@
+#ifndef BITBOARD_UNMOVEGEN_H
+#define BITBOARD_UNMOVEGEN_H
+
+
+#include "engine/bitboard.h"
+
+#include <vector>
+
+
+int generateUnmoves(const Bitboard &board, bool is_whites_turn, int max_captures, std::vector<Bitboard> *previous_positions);
+
+
+#endif // BITBOARD_UNMOVEGEN_H
@@ -0,0 +1,28 @@
+#ifndef BYTE_ORDER_H
+#define BYTE_ORDER_H
+
+
+#include "engine/bitboard.h"
+
+
+// the engine's binary files store integers in little endian order so that
+// they can be moved between machines, these helpers convert to and from that order
+
+
+inline void writeLittleEndian(unsigned char *buffer, u64 value, int num_bytes) {
+	for (int i = 0; i < num_bytes; i++) {
+		buffer[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+}
+
+
+inline u64 readLittleEndian(const unsigned char *buffer, int num_bytes) {
+	u64 value = 0;
+	for (int i = 0; i < num_bytes; i++) {
+		value |= static_cast<u64>(buffer[i]) << (8 * i);
+	}
+	return value;
+}
+
+
+#endif // BYTE_ORDER_H
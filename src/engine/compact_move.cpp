@@ -35,6 +35,11 @@ void CompactMove::addJumpDirection(int direction) {
 }
 
 
+bool CompactMove::operator==(const CompactMove &move) const {
+	return m_data == move.m_data;
+}
+
+
 bool CompactMove::exists() const {
 	return getField(EXISTS_SHIFT, EXISTS_WIDTH);
 }
@@ -69,6 +74,20 @@ bool CompactMove::isJump() const {
 }
 
 
+// returns the raw encoding of the move, used when storing moves in files
+uint32_t CompactMove::toBits() const {
+	return m_data;
+}
+
+
+// rebuilds a move from the raw encoding returned by toBits()
+CompactMove CompactMove::fromBits(uint32_t bits) {
+	CompactMove move;
+	move.m_data = bits;
+	return move;
+}
+
+
 int CompactMove::getField(int shift, int width) const {
 	return (m_data >> shift) & ((1 << width) - 1);
 }
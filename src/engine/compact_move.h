@@ -12,12 +12,16 @@ public:
 
 	void addJumpDirection(int direction);
 
+	bool operator==(const CompactMove &move) const;
 	bool exists() const;
 	int getStartingPosition() const;
 	int getNumberOfJumps() const;
 	int getDirection(int index) const;
 	bool isJump() const;
 
+	uint32_t toBits() const;
+	static CompactMove fromBits(uint32_t bits);
+
 	static constexpr int MAX_JUMPS = 9;
 
 private:
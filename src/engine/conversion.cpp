@@ -0,0 +1,95 @@
+#include "engine/conversion.h"
+
+#include "game/board.h"
+#include "game/move.h"
+#include "game/turn.h"
+#include "game/piece.h"
+#include "game/position.h"
+#include "game/direction.h"
+#include "engine/bitboard.h"
+#include "engine/compact_move.h"
+
+#include <algorithm> // for std::max
+
+
+Bitboard convertBoardToBitboard(const Board &board) {
+	Bitboard bitboard;
+
+	bitboard.black_pieces = 0;
+	bitboard.white_pieces = 0;
+	bitboard.king_pieces = 0;
+
+	for (int position = 0; position < 32; position++) {
+		Piece piece = board.pieceAt(position);
+
+		if (piece.exists()) {
+			u32 mask = 1u << position;
+
+			if (piece.belongsTo(Turn::BLACK)) {
+				bitboard.black_pieces |= mask;
+			} else {
+				bitboard.white_pieces |= mask;
+			}
+
+			if (piece.isCrowned()) {
+				bitboard.king_pieces |= mask;
+			}
+		}
+	}
+
+	return bitboard;
+}
+
+
+Board convertBitboardToBoard(const Bitboard &bitboard) {
+	Board board;
+
+	for (int position = 0; position < 32; position++) {
+		u32 mask = 1u << position;
+
+		if (bitboard.black_pieces & mask) {
+			board.pieceAt(position) = Piece::BLACK_MAN;
+		} else if (bitboard.white_pieces & mask) {
+			board.pieceAt(position) = Piece::WHITE_MAN;
+		} else {
+			continue;
+		}
+
+		if (bitboard.king_pieces & mask) {
+			board.pieceAt(position).crown();
+		}
+	}
+
+	return board;
+}
+
+
+Move convertCompactMoveToNormalMove(const CompactMove compact_move) {
+	if (!compact_move.exists()) {
+		return Move();
+	}
+
+	Move normal_move;
+
+	Position position = compact_move.getStartingPosition();
+
+	normal_move.addPosition(position);
+
+	int num_hops = std::max(1, compact_move.getNumberOfJumps());
+	bool is_jumping_move = compact_move.isJump();
+
+	for (int i = 0; i < num_hops; i++) {
+		Direction direction = Direction::ALL_DIRECTIONS[compact_move.getDirection(i)];
+
+		// record jumped piece of applicable
+		if (is_jumping_move) {
+			normal_move.addJumpedPiecePosition(position.getOffset(direction, false));
+		}
+
+		// add next position
+		position = position.getOffset(direction, is_jumping_move);
+		normal_move.addPosition(position);
+	}
+
+	return normal_move;
+}
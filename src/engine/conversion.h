@@ -0,0 +1,16 @@
+#ifndef CONVERSION_H
+#define CONVERSION_H
+
+
+class Board;
+class Move;
+struct Bitboard;
+class CompactMove;
+
+
+Bitboard convertBoardToBitboard(const Board &board);
+Board convertBitboardToBoard(const Bitboard &bitboard);
+Move convertCompactMoveToNormalMove(CompactMove compact_move);
+
+
+#endif // CONVERSION_H
@@ -0,0 +1,137 @@
+#include "engine/endgame.h"
+
+#include "engine/tablebase.h"
+
+#include <algorithm> // for std::min, std::max
+#include <cstdlib> // for std::abs
+#include <unordered_map>
+
+
+// the squares along the edges of the board, where a king has fewer ways out
+static constexpr u32 edge_squares = 0b1111'1000'0001'1000'0001'1000'0001'1111;
+
+// the pairs of squares in two opposite corners, which a lone king can shuttle between
+// without ever being trapped against the edge
+static constexpr u32 double_corners = 0b1000'1000'0000'0000'0000'0000'0001'0001;
+
+// in the units of the evaluation, where a man is worth about 100
+static constexpr int CLOSING_IN_WEIGHT = 6; // for each king, per square closer to the nearest of the other side
+static constexpr int EDGE_WEIGHT = 10; // for each king of the weaker side on the edge
+static constexpr int DOUBLE_CORNER_WEIGHT = 20; // for each king of the weaker side in a double corner
+static constexpr int RUNAWAY_WEIGHT = 12; // per row a man that can't be caught has come
+
+
+// the rows are numbered from black's side, and the columns from the left with the
+// squares of the even rows in the odd columns
+static int getRow(int square) {
+	return square / 4;
+}
+
+
+static int getColumn(int square) {
+	return 2 * (square % 4) + (getRow(square) % 2 == 0 ? 1 : 0);
+}
+
+
+// returns the moves a king needs to get from one square to the other on an empty board
+static int getDistance(int from, int to) {
+	return std::max(std::abs(getRow(from) - getRow(to)), std::abs(getColumn(from) - getColumn(to)));
+}
+
+
+// returns the distance from square to the nearest of pieces, which must not be empty
+static int getDistanceToNearest(int square, u32 pieces) {
+	int distance = 7;
+	for (; pieces; pieces &= pieces - 1) {
+		distance = std::min(distance, getDistance(square, lsbIndex(pieces)));
+	}
+	return distance;
+}
+
+
+// a few kings against fewer win by closing in on the weaker side's kings and driving them out
+// of the double corners to the edge, where they can be trapped
+static int evaluateMoreKings(const Bitboard &board, int evaluation) {
+	const bool black_is_stronger = popcount(board.black_pieces) > popcount(board.white_pieces);
+	const u32 strong_kings = black_is_stronger ? board.black_pieces : board.white_pieces;
+	const u32 weak_kings = black_is_stronger ? board.white_pieces : board.black_pieces;
+
+	int bonus = 0;
+
+	for (u32 kings = strong_kings; kings; kings &= kings - 1) {
+		bonus += CLOSING_IN_WEIGHT * (7 - getDistanceToNearest(lsbIndex(kings), weak_kings));
+	}
+
+	bonus += EDGE_WEIGHT * popcount(weak_kings & edge_squares);
+	bonus -= DOUBLE_CORNER_WEIGHT * popcount(weak_kings & double_corners);
+
+	return evaluation + (black_is_stronger ? bonus : -bonus);
+}
+
+
+// kings against men win by hunting the men down before they crown, unless one of them is out of reach
+// and runs through to make a king of its own
+static int evaluateKingsAgainstMen(const Bitboard &board, int evaluation) {
+	const bool black_has_kings = (board.black_pieces & board.king_pieces) != 0;
+	const u32 kings = black_has_kings ? board.black_pieces : board.white_pieces;
+	const u32 men = black_has_kings ? board.white_pieces : board.black_pieces;
+
+	int bonus = 0;
+
+	for (u32 remaining = kings; remaining; remaining &= remaining - 1) {
+		bonus += CLOSING_IN_WEIGHT * (7 - getDistanceToNearest(lsbIndex(remaining), men));
+	}
+
+	for (u32 remaining = men; remaining; remaining &= remaining - 1) {
+		const int square = lsbIndex(remaining);
+		const int rows_to_go = black_has_kings ? getRow(square) : 7 - getRow(square);
+
+		if (getDistanceToNearest(square, kings) > rows_to_go) {
+			bonus -= RUNAWAY_WEIGHT * (7 - rows_to_go);
+		}
+	}
+
+	return evaluation + (black_has_kings ? bonus : -bonus);
+}
+
+
+// returns the evaluators by signature key
+static std::unordered_map<int, EndgameEvaluator> createEvaluators() {
+	std::unordered_map<int, EndgameEvaluator> evaluators;
+
+	for (const MaterialSignature &signature : getSignaturesInOrder(MAX_ENDGAME_PIECES)) {
+		const int black_pieces = signature.black_men + signature.black_kings;
+		const int white_pieces = signature.white_men + signature.white_kings;
+
+		if (black_pieces == 0 || white_pieces == 0) {
+			continue;
+		}
+
+		const bool black_has_only_kings = signature.black_men == 0;
+		const bool white_has_only_kings = signature.white_men == 0;
+		const bool black_has_only_men = signature.black_kings == 0;
+		const bool white_has_only_men = signature.white_kings == 0;
+
+		if (black_has_only_kings && white_has_only_kings && black_pieces != white_pieces) {
+			evaluators[getSignatureKey(signature)] = evaluateMoreKings;
+		} else if ((black_has_only_kings && white_has_only_men && black_pieces >= white_pieces)
+				|| (white_has_only_kings && black_has_only_men && white_pieces >= black_pieces)) {
+			evaluators[getSignatureKey(signature)] = evaluateKingsAgainstMen;
+		}
+	}
+
+	return evaluators;
+}
+
+
+// returns the evaluator for the material on board, or nullptr if it has none
+EndgameEvaluator findEndgameEvaluator(const Bitboard &board) {
+	if (popcount(board.black_pieces | board.white_pieces) > MAX_ENDGAME_PIECES) {
+		return nullptr;
+	}
+
+	static const std::unordered_map<int, EndgameEvaluator> evaluators = createEvaluators();
+
+	auto found = evaluators.find(getSignatureKey(getMaterialSignature(board)));
+	return found != evaluators.end() ? found->second : nullptr;
+}
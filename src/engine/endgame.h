@@ -0,0 +1,20 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+
+#include "engine/bitboard.h"
+
+
+// improves on the ordinary evaluation of the positions of one material signature, which doesn't know how
+// to make progress in endgames like a few kings against fewer, where the search otherwise goes round in circles
+// takes the position and its ordinary evaluation, both for black, and returns the better evaluation for black
+using EndgameEvaluator = int (*)(const Bitboard &board, int evaluation);
+
+// no signature with more pieces has an evaluator, so the positions before the endgame only cost a popcount
+constexpr int MAX_ENDGAME_PIECES = 6;
+
+
+EndgameEvaluator findEndgameEvaluator(const Bitboard &board);
+
+
+#endif // ENDGAME_H
@@ -1,121 +1,753 @@
 #include "engine/engine.h"
 
 #include "game/game.h"
-#include "game/board.h"
 #include "game/move.h"
 #include "game/turn.h"
-#include "game/piece.h"
-#include "game/position.h"
-#include "game/direction.h"
 #include "engine/bitboard.h"
 #include "engine/bitboard_movegen.h"
 #include "engine/compact_move.h"
-
-#include <algorithm> // for std::max
+#include "engine/conversion.h"
+#include "engine/endgame.h"
+#include "engine/evaluation.h"
+#include "engine/opening_book.h"
+#include "engine/resumable_search.h"
+#include "engine/score.h"
+#include "engine/static_exchange.h"
+#include "engine/tablebase_probe.h"
+#include "engine/transposition_table.h"
+#include "engine/zobrist.h"
+
+#include <algorithm> // for std::max, std::min, std::find
+#include <chrono>
 #include <climits>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility> // for std::swap
 
 
-static Bitboard convertBoardToBitboard(const Board &board) {
-	Bitboard bitboard;
+static EngineOptions default_options;
 
-	bitboard.black_pieces = 0;
-	bitboard.white_pieces = 0;
-	bitboard.king_pieces = 0;
 
-	for (int position = 0; position < 32; position++) {
-		Piece piece = board.pieceAt(position);
+// values exposed to the tuners, the names match the evaluation terms they control
+// the man weight is left out as it sets the units of everything else
+static const EngineParameter tunable_parameters[] = {
+	{"king", 100, 250, 10},
+	{"trade", 0, 10, 1},
+	{"back_rank", 0, 40, 4},
+	{"centre", 0, 30, 3},
+	{"runaway", 0, 120, 10},
+	{"tempo", 0, 10, 1},
+	{"mobility", 0, 15, 2},
+};
 
-		if (piece.exists()) {
-			u32 mask = 1u << position;
+static constexpr int NUM_TUNABLE_PARAMETERS = sizeof(tunable_parameters) / sizeof(tunable_parameters[0]);
 
-			if (piece.belongsTo(Turn::BLACK)) {
-				bitboard.black_pieces |= mask;
-			} else {
-				bitboard.white_pieces |= mask;
-			}
 
-			if (piece.isCrowned()) {
-				bitboard.king_pieces |= mask;
-			}
+// returns the tablebases in directory, shared by every engine that loads them so the files are only
+// mapped once and the cache budget holds for the whole program, or nullptr if there are none
+// the tables compiled into the engine fill in the signatures the directory has no table for, and an
+// empty directory gives just those
+static std::shared_ptr<TablebaseProber> openTablebases(const std::string &directory, int cache_size_mb) {
+	static std::mutex mutex;
+	static std::map<std::string, std::weak_ptr<TablebaseProber>> open_tablebases;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::shared_ptr<TablebaseProber> tablebases = open_tablebases[directory].lock();
+
+	if (tablebases == nullptr) {
+		tablebases = std::make_shared<TablebaseProber>(cache_size_mb);
+
+		if (!directory.empty() && tablebases->load(directory) == 0) {
+			return nullptr;
+		}
+
+		if (tablebases->loadBuiltIn() == 0 && directory.empty()) {
+			return nullptr;
 		}
+
+		open_tablebases[directory] = tablebases;
 	}
 
-	return bitboard;
+	return tablebases;
 }
 
 
-static Move convertCompactMovetoNormalMove(const CompactMove compact_move) {
-	if (!compact_move.exists()) {
-		return Move();
+// returns the book at path, shared by every engine that opens it so the file is only mapped once,
+// or nullptr if it can't be opened
+static std::shared_ptr<const OpeningBook> openBook(const std::string &path) {
+	static std::mutex mutex;
+	static std::map<std::string, std::weak_ptr<const OpeningBook>> open_books;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::shared_ptr<const OpeningBook> book = open_books[path].lock();
+
+	if (book == nullptr) {
+		std::shared_ptr<OpeningBook> opened = std::make_shared<OpeningBook>();
+
+		if (!opened->open(path)) {
+			return nullptr;
+		}
+
+		book = opened;
+		open_books[path] = book;
 	}
 
-	Move normal_move;
+	return book;
+}
+
 
-	Position position = compact_move.getStartingPosition();
+// returns a monotonic timestamp in microseconds, used to time recorded subtrees
+static std::int64_t currentTimeUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-	normal_move.addPosition(position);
 
-	int num_hops = std::max(1, compact_move.getNumberOfJumps());
-	bool is_jumping_move = compact_move.isJump();
+Engine::Engine() :
+	Engine(default_options)
+{
+}
 
-	for (int i = 0; i < num_hops; i++) {
-		Direction direction = Direction::ALL_DIRECTIONS[compact_move.getDirection(i)];
 
-		// record jumped piece of applicable
-		if (is_jumping_move) {
-			normal_move.addJumpedPiecePosition(position.getOffset(direction, false));
+Engine::Engine(const EngineOptions &options) :
+	m_exchange_pruning(options.exchange_pruning)
+{
+	if (!options.record_tree_file.empty()) {
+		int max_ply = std::min(options.record_max_ply, MAX_PLY - 1);
+		if (!m_recorder.open(options.record_tree_file, max_ply)) {
+			std::cerr << "Could not open search tree file " << options.record_tree_file << '\n';
 		}
+	}
+
+	if (!options.weights_file.empty() && !loadEvalWeights(options.weights_file)) {
+		std::cerr << "Could not load evaluation weights " << options.weights_file
+			<< ", using the built in weights instead\n";
+	}
+
+	if (!options.network_file.empty() && !loadNetwork(options.network_file)) {
+		std::cerr << "Could not load network " << options.network_file
+			<< ", using the standard evaluation instead\n";
+	}
+
+	if (!options.tablebase_directory.empty() && !loadTablebases(options.tablebase_directory, options.tablebase_cache_mb)) {
+		std::cerr << "Could not load tablebases from " << options.tablebase_directory << '\n';
+	}
+
+	if (m_tablebases == nullptr && options.built_in_tablebases) {
+		loadTablebases("", options.tablebase_cache_mb);
+	}
+
+	if (!options.book_file.empty() && !loadBook(options.book_file)) {
+		std::cerr << "Could not load opening book " << options.book_file << ", searching the opening instead\n";
+	}
+
+	setHashSize(options.hash_size_mb);
+}
+
+
+// sets the options used by engines constructed without explicit options
+void Engine::setDefaultOptions(const EngineOptions &options) {
+	default_options = options;
+}
+
+
+const EngineOptions& Engine::getDefaultOptions() {
+	return default_options;
+}
+
+
+// replaces the transposition table with an empty one of the given size, or removes it if size_mb is zero
+void Engine::setHashSize(int size_mb) {
+	if (size_mb > 0) {
+		m_transposition_table = std::make_shared<TranspositionTable>(size_mb);
+	} else {
+		m_transposition_table = nullptr;
+	}
+}
+
+
+// empties the transposition table, so that the next search doesn't depend on the ones before it
+// a table shared with other engines is emptied for them too
+void Engine::clearHash() {
+	if (m_transposition_table != nullptr) {
+		m_transposition_table->clear();
+	}
+}
+
+
+// makes the engine use table, which may be shared with engines searching on other threads
+void Engine::setTranspositionTable(std::shared_ptr<TranspositionTable> table) {
+	m_transposition_table = table;
+}
+
+
+// loads evaluation weights written by the tuner
+// returns false and leaves the weights unchanged if the file could not be loaded
+bool Engine::loadEvalWeights(const std::string &path) {
+	return m_eval_weights.loadFromFile(path);
+}
+
+
+// loads a network to use for evaluation instead of the weighted evaluation
+// returns false and leaves the evaluation unchanged if the file could not be loaded
+bool Engine::loadNetwork(const std::string &path) {
+	std::shared_ptr<const NnueNetwork> network = NnueNetwork::loadFromFile(path);
+
+	if (network == nullptr) {
+		return false;
+	}
+
+	m_network = network;
+
+	return true;
+}
+
+
+// makes the search look up positions in the tablebases in directory, keeping up to cache_size_mb
+// of decompressed blocks in memory, unless another engine already has them loaded
+// an empty directory only loads the tables compiled into the engine
+// returns false and leaves the tablebases unchanged if directory has none
+bool Engine::loadTablebases(const std::string &directory, int cache_size_mb) {
+	std::shared_ptr<TablebaseProber> tablebases = openTablebases(directory, cache_size_mb);
+
+	if (tablebases == nullptr) {
+		return false;
+	}
+
+	m_tablebases = tablebases;
+	m_tablebase_pieces = tablebases->getMaxPieces();
+
+	return true;
+}
+
+
+// returns the probe counts of the tablebases since they were loaded, counting the probes of every
+// engine sharing them, all zero if none are loaded
+TablebaseProbeStats Engine::getTablebaseStats() const {
+	if (m_tablebases == nullptr) {
+		return TablebaseProbeStats {};
+	}
+
+	return m_tablebases->getStats();
+}
 
-		// add next position
-		position = position.getOffset(direction, is_jumping_move);
-		normal_move.addPosition(position);
+
+// plays the positions of the opening from the book at path, unless another engine already has it open
+// returns false and leaves the book unchanged if it can't be opened
+bool Engine::loadBook(const std::string &path) {
+	std::shared_ptr<const OpeningBook> book = openBook(path);
+
+	if (book == nullptr) {
+		return false;
 	}
 
-	return normal_move;
+	m_book = book;
+
+	return true;
+}
+
+
+// returns the value of the tunable parameter at index
+int Engine::getParameter(int index) const {
+	return m_eval_weights.values[findEvalTerm(tunable_parameters[index].name)];
+}
+
+
+// sets the tunable parameter at index, clamping value to the parameter's range
+void Engine::setParameter(int index, int value) {
+	const EngineParameter &parameter = tunable_parameters[index];
+	value = std::min(std::max(value, parameter.min_value), parameter.max_value);
+	m_eval_weights.values[findEvalTerm(parameter.name)] = value;
+}
+
+
+int Engine::getNumParameters() {
+	return NUM_TUNABLE_PARAMETERS;
+}
+
+
+const EngineParameter& Engine::getParameterInfo(int index) {
+	return tunable_parameters[index];
+}
+
+
+// returns the index of the parameter with the given name, or -1 if there isn't one
+int Engine::findParameter(const std::string &name) {
+	for (int i = 0; i < NUM_TUNABLE_PARAMETERS; i++) {
+		if (name == tunable_parameters[i].name) {
+			return i;
+		}
+	}
+	return -1;
 }
 
 
 Move Engine::findBestMove(const Game &game) {
-	// initialize engine internal state
-	Bitboard board = convertBoardToBitboard(game.getBoard());
+	return findBestMove(game, SearchLimits());
+}
+
+
+Move Engine::findBestMove(const Game &game, const SearchLimits &limits) {
+	return convertCompactMoveToNormalMove(search(game, limits).best_move);
+}
+
+
+// searches the game's current position, scoring the positions it has already been through as draws
+// a position in the opening book is played from it without searching, unless the search is to run until stopped
+SearchInfo Engine::search(const Game &game, const SearchLimits &limits) {
+	const Bitboard board = convertBoardToBitboard(game.getBoard());
+	const bool is_whites_turn = (game.getTurn() == Turn::WHITE);
+
+	SearchInfo info;
+	if (!limits.infinite && probeBook(board, is_whites_turn, &info)) {
+		return info;
+	}
+
+	// a game that was never started has no positions, not even the current one
+	std::vector<u64> history = getHistoryKeys(game);
+	if (!history.empty()) {
+		history.pop_back(); // the position being searched
+	}
+
+	return search(board, is_whites_turn, limits, history);
+}
+
+
+// picks one of the book's moves for the position at random, and fills in info as a search of no depth that found it
+// returns false if there is no book or the position isn't in it
+bool Engine::probeBook(const Bitboard &board, bool is_whites_turn, SearchInfo *info) {
+	BookEntry entry;
+	if (m_book == nullptr || !m_book->pickMove(board, is_whites_turn, static_cast<std::uint32_t>(m_book_random()), &entry)) {
+		return false;
+	}
+
+	*info = SearchInfo {};
+	info->score = entry.score;
+	info->best_move = entry.move;
+	info->pv_length = 1;
+	info->pv[0] = entry.move;
+
+	return true;
+}
+
+
+// searches the position and returns the result of the deepest depth that was finished
+// the best move doesn't exist if the side to move has no moves
+// history is the keys of the positions played before this one since the last capture or man move,
+// oldest first, and reaching any of them again is scored as a draw
+SearchInfo Engine::search(const Bitboard &board, bool is_whites_turn, const SearchLimits &limits,
+		const std::vector<u64> &history) {
+	return searchMultiPv(board, is_whites_turn, limits, 1, history).front();
+}
+
+
+// returns the keys of the positions of game since its last capture or man move, oldest first,
+// ending with the current position
+std::vector<u64> Engine::getHistoryKeys(const Game &game) {
+	const std::vector<Board> &positions = game.getPositionHistory();
+	std::vector<u64> keys(positions.size());
+
+	// the side to move alternates back from the current position
 	bool is_whites_turn = (game.getTurn() == Turn::WHITE);
 
-	CompactMove best_move;
+	for (int i = static_cast<int>(positions.size()) - 1; i >= 0; i--) {
+		keys[i] = hashBitboard(convertBoardToBitboard(positions[i]), is_whites_turn);
+		is_whites_turn = !is_whites_turn;
+	}
+
+	return keys;
+}
+
+
+// searches the position for its num_lines best moves, each with an exact score and its own line of play,
+// and returns them best first as of the deepest depth that was finished for all of them
+// there are fewer lines if the side to move has fewer moves, and a single one without a move if it has none
+// history is as for search()
+//
+// each depth searches the root once per line with a full window, leaving out the moves of the lines
+// already found, so the score of each line is exact. the later searches of a depth mostly run
+// through positions the earlier ones have just put in the transposition table
+std::vector<SearchInfo> Engine::searchMultiPv(const Bitboard &board, bool is_whites_turn, const SearchLimits &limits,
+		int num_lines, const std::vector<u64> &history) {
+	// without a depth the search only stops at the normal depth if nothing else will stop it
+	int max_depth = limits.depth;
+	if (max_depth <= 0) {
+		// pondering alone doesn't count, once the ponder move is played the search stops at the normal depth
+		bool has_limits = limits.nodes > 0 || limits.time_ms > 0 || limits.infinite;
+		max_depth = has_limits ? MAX_PLY - 1 : MAX_DEPTH;
+	}
+	max_depth = std::min(max_depth, MAX_PLY - 1);
+
+	Bitboard next_positions[MAX_MOVES];
+	int num_moves = generateMoves(board, is_whites_turn, next_positions, nullptr);
+	num_lines = std::max(1, std::min(num_lines, num_moves));
+
+	std::vector<SearchInfo> lines;
+	std::vector<SearchInfo> depth_lines;
+
+	m_nodes = 0;
+	m_tablebase_hits = 0;
 
-	negamax(board, is_whites_turn, MAX_DEPTH, -INT_MAX, INT_MAX, &best_move);
+	// the tables only say whether a position is won, not how to make progress, so a root that is in them
+	// is searched as normal down to the captures that leave a smaller table, which are probed
+	m_probe_pieces = std::min(m_tablebase_pieces, popcount(board.black_pieces | board.white_pieces) - 1);
 
-	return convertCompactMovetoNormalMove(best_move);
+	m_limits = &limits;
+	m_start_time_us = currentTimeUs();
+	m_aborted = false;
+
+	m_history_length = static_cast<int>(history.size());
+	m_keys.assign(history.begin(), history.end());
+	m_keys.resize(m_history_length + MAX_PLY);
+	m_reversible_plies[0] = m_history_length;
+
+	for (int depth = 1; depth <= max_depth; depth++) {
+		m_depth = depth;
+		depth_lines.clear();
+		m_num_excluded_root_moves = 0;
+
+		for (int line = 0; line < num_lines; line++) {
+			// each line starts with its move from the previous depth, which is likely to still be the best left
+			m_root_first_move = (line < static_cast<int>(lines.size())) ? lines[line].best_move : CompactMove();
+
+			CompactMove depth_best_move;
+			int score = negamax(board, is_whites_turn, depth, 0, -INT_MAX, INT_MAX, &depth_best_move);
+
+			// the first line of the first depth always finishes so there is a move to return
+			if (m_aborted && (depth > 1 || line > 0)) {
+				break;
+			}
+
+			SearchInfo info {};
+			info.depth = depth;
+			info.score = score;
+			info.nodes = m_nodes;
+			info.time_ms = (currentTimeUs() - m_start_time_us) / 1000;
+			info.best_move = depth_best_move;
+			findPrincipalVariation(board, is_whites_turn, &info);
+			info.line = line;
+			info.tablebase_hits = m_tablebase_hits;
+			depth_lines.push_back(info);
+
+			m_excluded_root_moves[m_num_excluded_root_moves++] = depth_best_move;
+
+			if (m_aborted) {
+				break;
+			}
+		}
+
+		// a depth only replaces the previous one once all its lines are found, except the first
+		if (static_cast<int>(depth_lines.size()) < num_lines && depth > 1) {
+			break;
+		}
+
+		lines = depth_lines;
+
+		if (m_info_callback) {
+			for (const SearchInfo &info : lines) {
+				m_info_callback(info);
+			}
+		}
+
+		if (m_aborted || isProven(lines, depth)) {
+			break;
+		}
+	}
+
+	m_num_excluded_root_moves = 0;
+
+	// an infinite search doesn't return on its own, even if it runs out of depth
+	while (!m_aborted && !limitsApply()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		checkLimits();
+	}
+
+	m_limits = nullptr;
+
+	return lines;
+}
+
+
+// returns a search of the position using this engine's evaluation and transposition table,
+// which is carried out a slice at a time by calling its step()
+// a depth of zero searches to the normal depth
+std::unique_ptr<ResumableSearch> Engine::createResumableSearch(const Bitboard &board, bool is_whites_turn, int depth) const {
+	int max_depth = depth;
+	if (max_depth <= 0) {
+		max_depth = MAX_DEPTH;
+	}
+	max_depth = std::min(max_depth, MAX_PLY - 1);
+
+	return std::unique_ptr<ResumableSearch>(new ResumableSearch(board, is_whites_turn, max_depth,
+		m_eval_weights, m_exchange_pruning, m_network, m_transposition_table, m_tablebases));
+}
+
+
+// sets a function to be called from the searching thread each time a depth is finished,
+// and each time the root finds a better move than the first one it tried at that depth
+void Engine::setInfoCallback(std::function<void(const SearchInfo&)> callback) {
+	m_info_callback = callback;
+}
+
+
+// returns true if every line ends the game within depth plies, in which case searching deeper
+// can't change their scores
+bool Engine::isProven(const std::vector<SearchInfo> &lines, int depth) {
+	for (const SearchInfo &line : lines) {
+		if (!isDecidedScore(line.score) || getPliesToEnd(line.score) > depth) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// returns false while the search should ignore its depth, node and time limits
+bool Engine::limitsApply() const {
+	if (m_limits->infinite) {
+		return false;
+	}
+	return m_limits->ponder == nullptr || !m_limits->ponder->load(std::memory_order_relaxed);
+}
+
+
+// sets m_aborted if the search has been stopped, or has used up its nodes or time once it is past the minimum depth
+// returns m_aborted
+bool Engine::checkLimits() {
+	const SearchLimits &limits = *m_limits;
+
+	if (limits.stop != nullptr && limits.stop->load(std::memory_order_relaxed)) {
+		m_aborted = true;
+	} else if (limitsApply() && m_depth > limits.min_depth) {
+		if (limits.nodes > 0 && m_nodes >= limits.nodes) {
+			m_aborted = true;
+		} else if (limits.time_ms > 0 && currentTimeUs() - m_start_time_us >= limits.time_ms * 1000LL) {
+			m_aborted = true;
+		}
+	}
+
+	return m_aborted;
+}
+
+
+// returns the number of nodes visited by the last search
+std::uint64_t Engine::getNodesSearched() const {
+	return m_nodes;
 }
 
 
 // best_move is optional - used for root call to this function
-int Engine::negamax(const Bitboard &board, bool is_whites_turn, int depth, int alpha, int beta, CompactMove *best_move) {
+int Engine::negamax(const Bitboard &board, bool is_whites_turn, int depth, int ply, int alpha, int beta, CompactMove *best_move) {
+	m_nodes++;
+
+	// the limits are only checked every so often as reading the clock isn't free
+	if (m_aborted || ((m_nodes & LIMIT_CHECK_INTERVAL) == 0 && checkLimits())) {
+		return 0;
+	}
+
 	if (best_move != nullptr) {
 		*best_move = CompactMove();
 	}
 
+	m_pv_length[ply] = ply;
+
+	const bool recording = m_recorder.isRecording(ply);
+	const std::uint64_t start_nodes = m_nodes;
+	const std::int64_t start_time_us = recording ? currentTimeUs() : 0;
+
+	if (m_network != nullptr) {
+		if (ply == 0) {
+			m_network->refreshAccumulator(board, &m_accumulators[0]);
+		} else {
+			m_network->updateAccumulator(m_accumulators[ply - 1], m_board_stack[ply - 1], board, &m_accumulators[ply]);
+		}
+	}
+	m_board_stack[ply] = board;
+
+	if (ply > 0) {
+		m_reversible_plies[ply] = isReversibleMove(m_board_stack[ply - 1], board) ? m_reversible_plies[ply - 1] + 1 : 0;
+	}
+
+	// leaves only need a key if they could be a repetition, the other nodes always have one for the table
+	const bool could_repeat = m_reversible_plies[ply] >= MIN_REPETITION_PLIES;
+	const u64 hash = (depth > 0 || could_repeat) ? hashBitboard(board, is_whites_turn) : 0;
+	m_keys[m_history_length + ply] = hash;
+
+	if (ply > 0 && could_repeat && isRepetition(ply)) {
+		if (recording) {
+			recordNode(board, is_whites_turn, depth, ply, alpha, beta, DRAW_SCORE,
+				SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+		}
+
+		return DRAW_SCORE;
+	}
+
+	// the tablebases give the exact result of the positions with fewer pieces than the root, so there is
+	// always a move to play. those with as many pieces are only settled when drawn, the others are
+	// searched on to find the way to the win and scored at the leaves by getKnownResultScore()
+	// a side that can't move has lost outright, which must outscore any win the tables only promise
+	const int num_pieces = popcount(board.black_pieces | board.white_pieces);
+	TablebaseValue tablebase_value = TB_UNKNOWN;
+
+	if (ply > 0 && num_pieces <= m_tablebase_pieces && !canMove(board, is_whites_turn)) {
+		int value = lossScore(ply);
+
+		if (recording) {
+			recordNode(board, is_whites_turn, depth, ply, alpha, beta, value,
+				SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+		}
+
+		return value;
+	}
+
+	if (ply > 0 && num_pieces <= m_tablebase_pieces && m_tablebases->probe(board, is_whites_turn, &tablebase_value)) {
+		m_tablebase_hits++;
+
+		if (num_pieces <= m_probe_pieces || tablebase_value == TB_DRAW) {
+			int value = getTablebaseScore(tablebase_value, board, is_whites_turn, ply);
+
+			if (recording) {
+				recordNode(board, is_whites_turn, depth, ply, alpha, beta, value,
+					SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+			}
+
+			return value;
+		}
+	}
+
 	if (depth == 0) {
-		return evaluate(board) * (is_whites_turn ? -1 : 1);
+		int value = getKnownResultScore(tablebase_value, evaluateLeaf(board, ply) * (is_whites_turn ? -1 : 1));
+
+		if (recording) {
+			recordNode(board, is_whites_turn, depth, ply, alpha, beta, value,
+				SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+		}
+
+		return value;
+	}
+
+	// neither side can do better than to win on its next move, so there is no point searching a window
+	// that only such a win would reach
+	if (ply > 0) {
+		alpha = std::max(alpha, lossScore(ply));
+		beta = std::min(beta, -lossScore(ply + 1));
+
+		if (alpha >= beta) {
+			if (recording) {
+				recordNode(board, is_whites_turn, depth, ply, alpha, beta, alpha,
+					SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+			}
+
+			return alpha;
+		}
+	}
+
+	int hash_move_index = TranspositionTable::NO_MOVE;
+
+	if (m_transposition_table != nullptr) {
+		TranspositionTable::Entry entry;
+
+		if (m_transposition_table->probe(hash, &entry)) {
+			hash_move_index = entry.best_move_index;
+			entry.score = scoreFromTable(entry.score, ply);
+
+			// the root always searches so that it has a move to return
+			if (ply > 0 && entry.depth >= depth
+					&& (entry.bound == TranspositionTable::EXACT
+					|| (entry.bound == TranspositionTable::LOWER && entry.score >= beta)
+					|| (entry.bound == TranspositionTable::UPPER && entry.score <= alpha))) {
+				if (recording) {
+					recordNode(board, is_whites_turn, depth, ply, alpha, beta, entry.score,
+						SearchTreeNode::NO_BEST_MOVE, 0, 0, start_nodes, start_time_us);
+				}
+
+				return entry.score;
+			}
+		}
 	}
 
 	Bitboard next_positions[MAX_MOVES];
 	CompactMove moves_available[MAX_MOVES];
 
-	int moves_found = generateMoves(board, is_whites_turn, next_positions, best_move != nullptr ? moves_available : nullptr);
+	// the moves themselves are only needed at the root and when recording the children
+	const bool recording_children = m_recorder.isRecording(ply + 1);
+	const bool need_moves = best_move != nullptr || recording_children;
+
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, need_moves ? moves_available : nullptr);
 
-	int value = -INT_MAX;
+	// with no moves the side to move has lost
+	int value = (moves_found == 0) ? lossScore(ply) : -INT_MAX;
+	int best_move_index = SearchTreeNode::NO_BEST_MOVE; // position in the search order
+	int best_generated_index = TranspositionTable::NO_MOVE; // position in the generated order
+	int moves_searched = 0;
+	const int original_alpha = alpha;
 
-	if (best_move != nullptr && moves_found > 0) {
-		*best_move = moves_available[0];
+	// at the root the best move of the previous depth is searched first, elsewhere the move
+	// the table remembers as best, as they are the most likely to still be best
+	if (best_move != nullptr) {
+		for (int i = 0; i < moves_found; i++) {
+			if (moves_available[i] == m_root_first_move) {
+				hash_move_index = i;
+				break;
+			}
+		}
 	}
 
+	int order[MAX_MOVES];
 	for (int i = 0; i < moves_found; i++) {
-		int new_value = -negamax(next_positions[i], !is_whites_turn, depth - 1, -beta, -alpha, nullptr);
+		order[i] = i;
+	}
+	if (hash_move_index < moves_found) {
+		std::swap(order[0], order[hash_move_index]);
+	}
+
+	// the rest go in order of the material they win, and near the leaves the quiet moves that only
+	// give material away are dropped, as the leaves can't see the captures that would follow them
+	int moves_to_search = moves_found;
+
+	if (depth >= MIN_EXCHANGE_ORDERING_DEPTH) {
+		orderByExchange(board, is_whites_turn, next_positions, order, moves_found, hash_move_index < moves_found ? 1 : 0,
+			m_eval_weights);
+	}
+	if (m_exchange_pruning && ply > 0 && depth <= MAX_EXCHANGE_PRUNING_DEPTH) {
+		moves_to_search = pruneLosingMoves(board, is_whites_turn, next_positions, order, moves_found, m_eval_weights);
+	}
+
+	if (best_move != nullptr && m_num_excluded_root_moves > 0) {
+		moves_to_search = excludeRootMoves(moves_available, order, moves_to_search);
+	}
+
+	if (best_move != nullptr && moves_to_search > 0) {
+		*best_move = moves_available[order[0]];
+	}
+
+	for (int i = 0; i < moves_to_search; i++) {
+		const int index = order[i];
+
+		if (recording_children) {
+			m_move_stack[ply + 1] = moves_available[index];
+		}
+
+		int new_value = -negamax(next_positions[index], !is_whites_turn, depth - 1, ply + 1, -beta, -alpha, nullptr);
+		moves_searched++;
 
 		if (new_value > value) {
 			value = new_value;
+			best_move_index = i;
+			best_generated_index = index;
+			updatePrincipalVariation(ply, index);
+
 			if (best_move != nullptr) {
-				*best_move = moves_available[i];
+				*best_move = moves_available[index];
+
+				// only the best line is reported early, the others are never more than runners up
+				if (i > 0 && m_num_excluded_root_moves == 0) {
+					reportNewBestMove(board, is_whites_turn, depth, value, *best_move);
+				}
 			}
 		}
 
@@ -126,51 +758,164 @@ int Engine::negamax(const Bitboard &board, bool is_whites_turn, int depth, int a
 		}
 	}
 
+	// the scores of an unfinished search can't be trusted, and nor can the score of a root
+	// missing some of its moves
+	if (m_transposition_table != nullptr && !m_aborted && (ply > 0 || m_num_excluded_root_moves == 0)) {
+		TranspositionTable::Bound bound = TranspositionTable::EXACT;
+		if (value <= original_alpha) {
+			bound = TranspositionTable::UPPER;
+		} else if (value >= beta) {
+			bound = TranspositionTable::LOWER;
+		}
+
+		m_transposition_table->store(hash, {scoreToTable(value, ply), depth, bound, best_generated_index});
+	}
+
+	if (recording) {
+		recordNode(board, is_whites_turn, depth, ply, original_alpha, beta, value,
+			best_move_index, moves_searched, moves_found, start_nodes, start_time_us);
+	}
+
 	return value;
 }
 
 
-// returns a value representing how good the given board position is for black
-// positive values mean that black is winning and negative values mean white is winning
-int Engine::evaluate(const Bitboard &board) {
-	constexpr int piece_value = 100;
-	constexpr int king_value = 140;
+// removes the moves of the lines already found from the search order of the root
+// returns the number of moves left, which keep their order
+int Engine::excludeRootMoves(const CompactMove *moves, int *order, int num_moves) const {
+	int num_left = 0;
 
-	int black_men = 0;
-	int black_kings = 0;
-	int white_men = 0;
-	int white_kings = 0;
+	for (int i = 0; i < num_moves; i++) {
+		const CompactMove *excluded_end = m_excluded_root_moves + m_num_excluded_root_moves;
 
-	for (int i = 0; i < 32; i++) {
-		bool is_black_piece = board.black_pieces & (1u << i);
-		bool is_white_piece = board.white_pieces & (1u << i);
-		bool is_king_piece = board.king_pieces & (1u << i);
+		if (std::find(m_excluded_root_moves, excluded_end, moves[order[i]]) == excluded_end) {
+			order[num_left++] = order[i];
+		}
+	}
 
-		if (is_black_piece) {
-			if (is_king_piece) {
-				black_kings++;
-			} else {
-				black_men++;
-			}
-		} else if (is_white_piece) {
-			if (is_king_piece) {
-				white_kings++;
-			} else {
-				white_men++;
-			}
+	return num_left;
+}
+
+
+// the best line from ply is the move at index followed by the best line from the ply after it
+void Engine::updatePrincipalVariation(int ply, int index) {
+	m_pv[ply][ply] = static_cast<std::uint8_t>(index);
+
+	const int child_length = m_pv_length[ply + 1];
+	for (int i = ply + 1; i < child_length; i++) {
+		m_pv[ply][i] = m_pv[ply + 1][i];
+	}
+
+	m_pv_length[ply] = std::max(child_length, ply + 1);
+}
+
+
+// fills in the best line found by the last search of the root, and info->ponder_move from it
+// the line ends early where the search took a score from the transposition table
+void Engine::findPrincipalVariation(const Bitboard &board, bool is_whites_turn, SearchInfo *info) const {
+	info->pv_length = 0;
+	info->ponder_move = CompactMove();
+
+	Bitboard position = board;
+	bool is_whites_position = is_whites_turn;
+	const int length = std::min(m_pv_length[0], MAX_PV_LENGTH);
+
+	for (int ply = 0; ply < length; ply++) {
+		Bitboard next_positions[MAX_MOVES];
+		CompactMove moves[MAX_MOVES];
+		int moves_found = generateMoves(position, is_whites_position, next_positions, moves);
+		int index = m_pv[0][ply];
+
+		if (index >= moves_found) {
+			break;
 		}
+
+		info->pv[info->pv_length++] = moves[index];
+		position = next_positions[index];
+		is_whites_position = !is_whites_position;
 	}
 
-	int value = (black_men - white_men) * piece_value
-		+ (black_kings - white_kings) * king_value;
+	if (info->pv_length > 1) {
+		info->ponder_move = info->pv[1];
+	}
+}
 
-	int num_black_pieces = black_men + black_kings;
-	int num_white_pieces = white_men + white_kings;
-	int total_num_pieces = num_black_pieces + num_white_pieces;
 
-	// try to encourage exchanges when in a winning position
-	value += (num_black_pieces - num_white_pieces) * (32 - total_num_pieces);
+// tells the info callback, if there is one, that the root has found a new best move partway through a depth
+void Engine::reportNewBestMove(const Bitboard &board, bool is_whites_turn, int depth, int score, CompactMove move) {
+	if (!m_info_callback || m_aborted) {
+		return;
+	}
 
-	return value;
+	SearchInfo info {};
+	info.depth = depth;
+	info.score = score;
+	info.nodes = m_nodes;
+	info.time_ms = (currentTimeUs() - m_start_time_us) / 1000;
+	info.best_move = move;
+	info.partial = true;
+	info.tablebase_hits = m_tablebase_hits;
+	findPrincipalVariation(board, is_whites_turn, &info);
+
+	m_info_callback(info);
+}
+
+
+// returns true if the position at ply has been reached before with the same side to move,
+// in the game or earlier in the search
+bool Engine::isRepetition(int ply) const {
+	const int end = m_history_length + ply;
+	const int start = end - m_reversible_plies[ply];
+
+	for (int i = end - MIN_REPETITION_PLIES; i >= start; i -= 2) {
+		if (m_keys[i] == m_keys[end]) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
+
+// returns the static evaluation for black of a board reached at ply
+// the endgames with an evaluator of their own have it applied on top
+int Engine::evaluateLeaf(const Bitboard &board, int ply) const {
+	const int value = m_network != nullptr ? m_network->evaluate(m_accumulators[ply]) : evaluate(board, m_eval_weights);
+
+	const EndgameEvaluator endgame = findEndgameEvaluator(board);
+	return endgame != nullptr ? endgame(board, value) : value;
+}
+
+
+// writes a finished node to the search tree file
+// start_nodes and start_time_us are the node count and time when the node was entered
+void Engine::recordNode(const Bitboard &board, bool is_whites_turn, int depth, int ply, int alpha, int beta,
+		int score, int best_move_index, int moves_searched, int moves_available,
+		std::uint64_t start_nodes, std::int64_t start_time_us) {
+	SearchTreeNode node;
+
+	node.hash = hashBitboard(board, is_whites_turn);
+	node.move = ply > 0 ? m_move_stack[ply] : CompactMove();
+	node.ply = ply;
+	node.depth = depth;
+	node.alpha = alpha;
+	node.beta = beta;
+	node.score = score;
+	node.best_move_index = best_move_index;
+	node.moves_searched = moves_searched;
+	node.moves_available = moves_available;
+	node.subtree_nodes = static_cast<u32>(m_nodes - start_nodes + 1);
+	node.subtree_time_us = static_cast<u32>(currentTimeUs() - start_time_us);
+
+	if (moves_available == 0 && depth == 0) {
+		node.type = SearchTreeNode::LEAF_NODE;
+	} else if (score <= alpha) {
+		node.type = SearchTreeNode::ALL_NODE;
+	} else if (score >= beta) {
+		node.type = SearchTreeNode::CUT_NODE;
+	} else {
+		node.type = SearchTreeNode::PV_NODE;
+	}
+
+	m_recorder.write(node);
+}
@@ -2,22 +2,164 @@
 #define ENGINE_H
 
 
+#include "engine/engine_options.h"
+#include "engine/search_limits.h"
+#include "engine/search_recorder.h"
+#include "engine/compact_move.h"
+#include "engine/evaluation.h"
+#include "engine/nnue.h"
+#include "engine/opening_book.h"
+#include "engine/tablebase_probe.h"
+#include "engine/transposition_table.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/bitboard.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
 class Game;
 class Move;
-struct Bitboard;
-class CompactMove;
+class ResumableSearch;
+
+
+// a value that can be tuned by playing games, see Engine::getParameter()
+struct EngineParameter {
+	const char *name;
+	int min_value;
+	int max_value;
+	int step; // a change large enough to make a measurable difference to playing strength
+};
+
+
+constexpr int MAX_PV_LENGTH = 32;
+
+
+// progress reported each time the search finishes a depth or finds a new best move
+struct SearchInfo {
+	int depth;
+	int score; // for the side to move, see score.h for how won and lost positions are scored
+	std::uint64_t nodes;
+	std::int64_t time_ms;
+	CompactMove best_move;
+	CompactMove ponder_move; // the reply expected to best_move, doesn't exist if it isn't known
+	bool partial; // the depth isn't finished, best_move has just been found to beat the previous best
+	int pv_length;
+	CompactMove pv[MAX_PV_LENGTH]; // the line of play expected, starting with best_move
+	int line; // rank of best_move among the moves of a multi-PV search, 0 for the best
+	std::uint64_t tablebase_hits; // positions whose value was found in the tablebases
+};
 
 
 class Engine {
 public:
+	Engine();
+	explicit Engine(const EngineOptions &options);
+
 	Move findBestMove(const Game &game);
+	Move findBestMove(const Game &game, const SearchLimits &limits);
+	SearchInfo search(const Game &game, const SearchLimits &limits);
+	SearchInfo search(const Bitboard &board, bool is_whites_turn, const SearchLimits &limits,
+		const std::vector<u64> &history = std::vector<u64>());
+	std::vector<SearchInfo> searchMultiPv(const Bitboard &board, bool is_whites_turn, const SearchLimits &limits,
+		int num_lines, const std::vector<u64> &history = std::vector<u64>());
+	bool probeBook(const Bitboard &board, bool is_whites_turn, SearchInfo *info);
+	std::unique_ptr<ResumableSearch> createResumableSearch(const Bitboard &board, bool is_whites_turn, int depth) const;
+	std::uint64_t getNodesSearched() const;
+	void setInfoCallback(std::function<void(const SearchInfo&)> callback);
 
-private:
-	int negamax(const Bitboard &board, bool is_whites_turn, int depth, int alpha, int beta, CompactMove *best_move);
+	void setHashSize(int size_mb);
+	void clearHash();
+	void setTranspositionTable(std::shared_ptr<TranspositionTable> table);
+	bool loadEvalWeights(const std::string &path);
+	bool loadNetwork(const std::string &path);
+	bool loadTablebases(const std::string &directory, int cache_size_mb);
+	TablebaseProbeStats getTablebaseStats() const;
+	bool loadBook(const std::string &path);
+
+	int getParameter(int index) const;
+	void setParameter(int index, int value);
+	static int getNumParameters();
+	static const EngineParameter& getParameterInfo(int index);
+	static int findParameter(const std::string &name);
+
+	static std::vector<u64> getHistoryKeys(const Game &game);
 
-	static int evaluate(const Bitboard &board);
+	static void setDefaultOptions(const EngineOptions &options);
+	static const EngineOptions& getDefaultOptions();
+
+	static constexpr int MAX_PLY = 64;
+
+private:
+	int negamax(const Bitboard &board, bool is_whites_turn, int depth, int ply, int alpha, int beta, CompactMove *best_move);
+	void recordNode(const Bitboard &board, bool is_whites_turn, int depth, int ply, int alpha, int beta,
+		int score, int best_move_index, int moves_searched, int moves_available,
+		std::uint64_t start_nodes, std::int64_t start_time_us);
+	int evaluateLeaf(const Bitboard &board, int ply) const;
+	bool isRepetition(int ply) const;
+	void updatePrincipalVariation(int ply, int index);
+	void findPrincipalVariation(const Bitboard &board, bool is_whites_turn, SearchInfo *info) const;
+	void reportNewBestMove(const Bitboard &board, bool is_whites_turn, int depth, int score, CompactMove move);
+	int excludeRootMoves(const CompactMove *moves, int *order, int num_moves) const;
+	static bool isProven(const std::vector<SearchInfo> &lines, int depth);
+	bool limitsApply() const;
+	bool checkLimits();
 
 	static constexpr int MAX_DEPTH = 11;
+	static constexpr std::uint64_t LIMIT_CHECK_INTERVAL = 1023; // mask applied to the node count
+
+	std::uint64_t m_nodes = 0;
+
+	// state of the search in progress
+	const SearchLimits *m_limits = nullptr;
+	std::int64_t m_start_time_us = 0;
+	bool m_aborted = false; // set once a limit is hit, the unfinished depth is then thrown away
+	int m_depth = 0; // of the iteration in progress, the node and time limits wait until it is past SearchLimits::min_depth
+	CompactMove m_root_first_move; // best move of the previous depth, searched first at the root
+	CompactMove m_excluded_root_moves[MAX_MOVES]; // moves of the lines a multi-PV search has already found
+	int m_num_excluded_root_moves = 0;
+	std::function<void(const SearchInfo&)> m_info_callback;
+
+	EvalWeights m_eval_weights = EvalWeights::defaults();
+	bool m_exchange_pruning = true;
+
+	std::shared_ptr<TranspositionTable> m_transposition_table;
+
+	// positions with at most m_probe_pieces pieces are looked up instead of searched
+	std::shared_ptr<TablebaseProber> m_tablebases;
+	int m_tablebase_pieces = 0; // the most of any table
+	int m_probe_pieces = 0; // fewer than the root has, see searchMultiPv()
+	std::uint64_t m_tablebase_hits = 0;
+
+	// the positions of the opening that are played from the book instead of searched, see search()
+	std::shared_ptr<const OpeningBook> m_book;
+	std::mt19937 m_book_random = std::mt19937(std::random_device()());
+
+	// when a network is loaded it replaces the weighted evaluation
+	// the accumulator for each ply is built from the one before it as the search goes deeper
+	std::shared_ptr<const NnueNetwork> m_network;
+	NnueNetwork::Accumulator m_accumulators[MAX_PLY];
+
+	Bitboard m_board_stack[MAX_PLY]; // position at each ply of the search path
+
+	// keys of the positions of the game since its last capture or man move, then of each ply of the search,
+	// so that positions repeated within the search or from the game can be scored as draws
+	// the key of a ply is only filled in where it could be repeated or the transposition table needs it
+	std::vector<u64> m_keys;
+	int m_history_length = 0;
+	int m_reversible_plies[MAX_PLY]; // plies since the last capture or man move, counting those of the game
+
+	// triangular table of the best line found from each ply, as indexes into the moves generated at each ply
+	// the line from ply is m_pv[ply][ply] up to m_pv[ply][m_pv_length[ply] - 1]
+	std::uint8_t m_pv[MAX_PLY][MAX_PLY];
+	int m_pv_length[MAX_PLY + 1];
+
+	SearchRecorder m_recorder;
+	CompactMove m_move_stack[MAX_PLY]; // moves leading to each ply, only filled in while recording
 };
 
 
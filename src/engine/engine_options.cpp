@@ -0,0 +1,39 @@
+#include "engine/engine_options.h"
+
+#include <cstdlib>
+#include <cstring>
+
+
+// reads the engine option at argv[*index], if it is one, moving *index past its value
+// returns false if argv[*index] isn't an engine option
+bool parseEngineOption(int argc, char *argv[], int *index, EngineOptions *options) {
+	int i = *index;
+
+	if (std::strcmp(argv[i], "--record-tree") == 0 && i + 1 < argc) {
+		options->record_tree_file = argv[++i];
+	} else if (std::strcmp(argv[i], "--record-ply") == 0 && i + 1 < argc) {
+		options->record_max_ply = std::atoi(argv[++i]);
+	} else if (std::strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+		options->weights_file = argv[++i];
+	} else if (std::strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+		options->hash_size_mb = std::atoi(argv[++i]);
+	} else if (std::strcmp(argv[i], "--nnue") == 0 && i + 1 < argc) {
+		options->network_file = argv[++i];
+	} else if (std::strcmp(argv[i], "--tablebases") == 0 && i + 1 < argc) {
+		options->tablebase_directory = argv[++i];
+	} else if (std::strcmp(argv[i], "--tb-cache") == 0 && i + 1 < argc) {
+		options->tablebase_cache_mb = std::atoi(argv[++i]);
+	} else if (std::strcmp(argv[i], "--no-bitbases") == 0) {
+		options->built_in_tablebases = false;
+	} else if (std::strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+		options->book_file = argv[++i];
+	} else if (std::strcmp(argv[i], "--no-exchange-pruning") == 0) {
+		options->exchange_pruning = false;
+	} else {
+		return false;
+	}
+
+	*index = i;
+
+	return true;
+}
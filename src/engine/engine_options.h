@@ -0,0 +1,27 @@
+#ifndef ENGINE_OPTIONS_H
+#define ENGINE_OPTIONS_H
+
+
+#include <string>
+
+
+// settings applied when an engine is constructed
+// the frontends fill these in from the command line via Engine::setDefaultOptions()
+struct EngineOptions {
+	std::string record_tree_file; // search tree recording is disabled if empty
+	int record_max_ply = 4; // deepest ply written to the search tree file
+	std::string weights_file; // evaluation weights written by the tuner, the built in weights are used if empty
+	int hash_size_mb = 16; // transposition table size, no table is used if zero
+	std::string network_file; // neural network evaluation, the weighted evaluation is used if empty
+	std::string tablebase_directory; // endgame tablebases written by checkers_tbgen, none are used if empty
+	int tablebase_cache_mb = 16; // decompressed tablebase blocks kept in memory
+	bool built_in_tablebases = true; // the small tablebases compiled in are used when there is no tablebase directory
+	std::string book_file; // opening book written by checkers_bookgen, the opening is searched if empty
+	bool exchange_pruning = true; // quiet moves that lose material are left unsearched near the leaves
+};
+
+
+bool parseEngineOption(int argc, char *argv[], int *index, EngineOptions *options);
+
+
+#endif // ENGINE_OPTIONS_H
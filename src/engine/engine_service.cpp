@@ -0,0 +1,265 @@
+#include "engine/engine_service.h"
+
+#include <algorithm> // for std::min, std::max, std::sort
+#include <numeric> // for std::accumulate
+
+
+// time kept back from a deadline for handing the result over
+static constexpr int DEADLINE_MARGIN_MS = 2;
+
+
+// num_threads defaults to the number of cores and num_partitions to the number of threads
+// options.hash_size_mb is the memory used by all the partitions together
+// min_depth is how deep every search goes whatever its deadline, unless its own depth limit is lower
+// the workers never record their search trees, whatever options.record_tree_file says
+EngineService::EngineService(const EngineOptions &options, int num_threads, int num_partitions, int min_depth) :
+	m_min_depth(std::max(1, min_depth))
+{
+	if (num_threads <= 0) {
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (num_partitions <= 0) {
+		num_partitions = num_threads;
+	}
+
+	if (options.hash_size_mb > 0) {
+		int partition_size_mb = std::max(1, options.hash_size_mb / num_partitions);
+		for (int i = 0; i < num_partitions; i++) {
+			m_partitions.push_back(std::make_shared<TranspositionTable>(partition_size_mb));
+		}
+	}
+
+	EngineOptions engine_options = options;
+	engine_options.hash_size_mb = 0; // the engines are given a partition for each search instead
+	engine_options.record_tree_file.clear(); // the workers would all truncate and write the same file
+
+	m_latencies_us.reserve(NUM_LATENCY_SAMPLES);
+	m_depths.reserve(NUM_LATENCY_SAMPLES);
+
+	for (int i = 0; i < num_threads; i++) {
+		m_workers.emplace_back(new Worker());
+		m_workers.back()->engine.reset(new Engine(engine_options));
+	}
+
+	for (std::unique_ptr<Worker> &worker : m_workers) {
+		worker->thread = std::thread(&EngineService::runWorker, this, worker.get());
+	}
+}
+
+
+// stops the searches in progress and drops the requests that haven't started
+EngineService::~EngineService() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+		for (std::unique_ptr<Worker> &worker : m_workers) {
+			worker->stop = true;
+		}
+	}
+
+	m_work_available.notify_all();
+
+	for (std::unique_ptr<Worker> &worker : m_workers) {
+		worker->thread.join();
+	}
+}
+
+
+// queues a search, it runs once the game's earlier requests are done and a thread is free
+void EngineService::submit(ServiceRequest request) {
+	Clock::time_point now = Clock::now();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	PendingRequest pending;
+	pending.submit_time = now;
+	pending.deadline = request.deadline_ms > 0
+		? now + std::chrono::milliseconds(request.deadline_ms) : Clock::time_point::max();
+	pending.sequence = m_next_sequence++;
+	pending.request = std::move(request);
+
+	std::uint64_t game_id = pending.request.game_id;
+	GameQueue &queue = m_games[game_id];
+	queue.requests.push_back(std::move(pending));
+
+	if (queue.requests.size() == 1 && !queue.running) {
+		makeReady(game_id, queue);
+		lock.unlock();
+		m_work_available.notify_one();
+	}
+}
+
+
+// drops the game's queued requests and stops its search if one is running
+// the result of a stopped search isn't reported
+void EngineService::cancelGame(std::uint64_t game_id) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto game = m_games.find(game_id);
+	if (game == m_games.end()) {
+		return;
+	}
+
+	GameQueue &queue = game->second;
+
+	if (queue.running) {
+		for (std::unique_ptr<Worker> &worker : m_workers) {
+			if (worker->busy && worker->game_id == game_id) {
+				worker->cancelled = true;
+				worker->stop = true;
+			}
+		}
+		queue.requests.clear();
+	} else {
+		const PendingRequest &head = queue.requests.front();
+		m_ready.erase(ReadyKey(-head.request.priority, head.deadline, head.sequence, game_id));
+		m_games.erase(game);
+	}
+}
+
+
+ServiceStats EngineService::getStats() const {
+	std::vector<std::int64_t> latencies;
+	std::vector<int> depths;
+	ServiceStats stats {};
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		latencies = m_latencies_us;
+		depths = m_depths;
+		stats.completed = m_completed;
+		stats.deadlines_missed = m_deadlines_missed;
+		stats.degraded = m_degraded;
+	}
+
+	if (!latencies.empty()) {
+		std::sort(latencies.begin(), latencies.end());
+		stats.p50_latency_ms = latencies[(latencies.size() - 1) / 2] / 1000.0;
+		stats.p99_latency_ms = latencies[(latencies.size() - 1) * 99 / 100] / 1000.0;
+		stats.mean_depth = std::accumulate(depths.begin(), depths.end(), 0.0) / depths.size();
+	}
+
+	return stats;
+}
+
+
+int EngineService::getNumThreads() const {
+	return static_cast<int>(m_workers.size());
+}
+
+
+void EngineService::runWorker(Worker *worker) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_work_available.wait(lock, [this]() { return m_stopping || !m_ready.empty(); });
+
+		if (m_stopping) {
+			return;
+		}
+
+		std::uint64_t game_id = std::get<3>(*m_ready.begin());
+		m_ready.erase(m_ready.begin());
+
+		GameQueue &queue = m_games[game_id];
+		PendingRequest pending = std::move(queue.requests.front());
+		queue.requests.pop_front();
+		queue.running = true;
+
+		worker->game_id = game_id;
+		worker->busy = true;
+		worker->cancelled = false;
+		worker->stop = false;
+
+		lock.unlock();
+
+		SearchLimits limits = pending.request.limits;
+		limits.stop = &worker->stop;
+		limits.ponder = nullptr;
+		limits.min_depth = std::max(limits.min_depth, m_min_depth);
+		bool degraded = false;
+
+		if (pending.deadline != Clock::time_point::max()) {
+			auto time_left = std::chrono::duration_cast<std::chrono::milliseconds>(pending.deadline - Clock::now());
+			int time_ms = static_cast<int>(time_left.count()) - DEADLINE_MARGIN_MS;
+
+			if (time_ms <= 0) {
+				// already late, so it stops as soon as it has the minimum depth rather than holding up the queue further
+				degraded = true;
+				time_ms = 1;
+			}
+			limits.time_ms = limits.time_ms > 0 ? std::min(limits.time_ms, time_ms) : time_ms;
+		}
+
+		worker->engine->setTranspositionTable(getPartition(game_id));
+		SearchInfo result = worker->engine->search(pending.request.board, pending.request.is_whites_turn, limits);
+
+		lock.lock();
+
+		bool cancelled = worker->cancelled;
+		if (!cancelled) {
+			recordResult(pending.submit_time, pending.deadline, Clock::now(), result.depth, degraded);
+		}
+
+		// the game's next request isn't made ready until the result is handed over,
+		// so the results of a game are always reported in order
+		if (!cancelled && pending.request.on_result) {
+			lock.unlock();
+			pending.request.on_result(result);
+			lock.lock();
+		}
+
+		worker->busy = false;
+
+		GameQueue &finished_queue = m_games[game_id];
+		finished_queue.running = false;
+		if (finished_queue.requests.empty()) {
+			m_games.erase(game_id);
+		} else {
+			makeReady(game_id, finished_queue);
+			m_work_available.notify_one();
+		}
+	}
+}
+
+
+// the mutex must be held, and queue must have a request and nothing running
+void EngineService::makeReady(std::uint64_t game_id, const GameQueue &queue) {
+	const PendingRequest &head = queue.requests.front();
+	m_ready.emplace(-head.request.priority, head.deadline, head.sequence, game_id);
+}
+
+
+// the mutex must be held
+void EngineService::recordResult(Clock::time_point submit_time, Clock::time_point deadline, Clock::time_point end_time,
+		int depth, bool degraded) {
+	std::int64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - submit_time).count();
+
+	if (m_latencies_us.size() < NUM_LATENCY_SAMPLES) {
+		m_latencies_us.push_back(latency_us);
+		m_depths.push_back(depth);
+	} else {
+		m_latencies_us[m_completed % NUM_LATENCY_SAMPLES] = latency_us;
+		m_depths[m_completed % NUM_LATENCY_SAMPLES] = depth;
+	}
+
+	m_completed++;
+
+	if (end_time > deadline) {
+		m_deadlines_missed++;
+	}
+	if (degraded) {
+		m_degraded++;
+	}
+}
+
+
+// games are spread over the partitions by a hash of their id, so consecutive ids don't all share one
+std::shared_ptr<TranspositionTable> EngineService::getPartition(std::uint64_t game_id) const {
+	if (m_partitions.empty()) {
+		return nullptr;
+	}
+
+	std::uint64_t hash = game_id * 0x9E3779B97F4A7C15ULL;
+	return m_partitions[(hash >> 32) % m_partitions.size()];
+}
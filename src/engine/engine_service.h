@@ -0,0 +1,135 @@
+#ifndef ENGINE_SERVICE_H
+#define ENGINE_SERVICE_H
+
+
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/search_limits.h"
+#include "engine/transposition_table.h"
+#include "engine/bitboard.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+
+// a search asked for by one of the games hosted by an EngineService
+struct ServiceRequest {
+	std::uint64_t game_id;
+	Bitboard board;
+	bool is_whites_turn;
+	SearchLimits limits; // stop and ponder are ignored, the service controls the search
+	int priority = 0; // requests with a higher priority are started first
+	int deadline_ms = 0; // the result is wanted this long after the request is submitted, 0 for no deadline
+	std::function<void(const SearchInfo&)> on_result; // called from a worker thread once the search is done
+};
+
+
+struct ServiceStats {
+	std::uint64_t completed;
+	std::uint64_t deadlines_missed;
+	std::uint64_t degraded; // started with their deadline already passed, so only searched to the minimum depth
+	double p50_latency_ms; // from submission to result, over the most recent requests
+	double p99_latency_ms;
+	double mean_depth; // reached by the searches, over the same requests
+};
+
+
+// runs the searches of many games on a fixed number of threads
+//
+// each game has a queue of requests, of which only the oldest is ever ready to run, so a game
+// can't take more than one thread or crowd out the others by asking for many searches at once.
+// of the ready requests the highest priority goes first, then the earliest deadline, then the
+// one that has waited longest. a request with a deadline searches for at most the time left
+// when it is started, so time spent waiting in the queue doesn't make it late, but every search
+// reaches the service's minimum depth even if that makes it late: an overloaded service shows up
+// in the latencies and the degraded count rather than in moves that were barely searched.
+//
+// the memory used doesn't grow with the number of games: the hash size in the options is
+// split into one transposition table per partition and each game always uses the same one
+class EngineService {
+public:
+	explicit EngineService(const EngineOptions &options, int num_threads = 0, int num_partitions = 0,
+		int min_depth = DEFAULT_MIN_DEPTH);
+	~EngineService();
+
+	EngineService(const EngineService&) = delete;
+	EngineService& operator=(const EngineService&) = delete;
+
+	void submit(ServiceRequest request);
+	void cancelGame(std::uint64_t game_id);
+
+	ServiceStats getStats() const;
+	int getNumThreads() const;
+
+	static constexpr int DEFAULT_MIN_DEPTH = 6;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct PendingRequest {
+		ServiceRequest request;
+		Clock::time_point submit_time;
+		Clock::time_point deadline; // Clock::time_point::max() if there isn't one
+		std::uint64_t sequence;
+	};
+
+	struct GameQueue {
+		std::deque<PendingRequest> requests; // oldest first
+		bool running = false;
+	};
+
+	// ordering of the ready requests: priority (negated so the highest sorts first), deadline,
+	// sequence, game
+	using ReadyKey = std::tuple<int, Clock::time_point, std::uint64_t, std::uint64_t>;
+
+	struct Worker {
+		std::thread thread;
+		std::unique_ptr<Engine> engine;
+		std::atomic<bool> stop {false};
+		std::uint64_t game_id = 0;
+		bool busy = false;
+		bool cancelled = false; // the game was cancelled during the search, its result isn't wanted
+	};
+
+	void runWorker(Worker *worker);
+	void makeReady(std::uint64_t game_id, const GameQueue &queue);
+	void recordResult(Clock::time_point submit_time, Clock::time_point deadline, Clock::time_point end_time,
+		int depth, bool degraded);
+	std::shared_ptr<TranspositionTable> getPartition(std::uint64_t game_id) const;
+
+	static constexpr int NUM_LATENCY_SAMPLES = 4096;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_work_available;
+	bool m_stopping = false;
+	std::uint64_t m_next_sequence = 0;
+
+	std::map<std::uint64_t, GameQueue> m_games; // only games with requests queued or running
+	std::set<ReadyKey> m_ready;
+
+	int m_min_depth;
+
+	std::vector<std::shared_ptr<TranspositionTable>> m_partitions;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+
+	// latencies in microseconds and depths of the last NUM_LATENCY_SAMPLES requests, used as ring buffers
+	std::vector<std::int64_t> m_latencies_us;
+	std::vector<int> m_depths;
+	std::uint64_t m_completed = 0;
+	std::uint64_t m_deadlines_missed = 0;
+	std::uint64_t m_degraded = 0;
+};
+
+
+#endif // ENGINE_SERVICE_H
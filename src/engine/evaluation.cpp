@@ -0,0 +1,203 @@
+#include "engine/evaluation.h"
+
+#include "engine/bitboard.h"
+#include "engine/bitboard_masks.h"
+#include "engine/bitboard_movegen.h"
+
+#include <fstream>
+#include <sstream>
+
+
+struct EvalTermInfo {
+	const char *name;
+	int default_weight;
+};
+
+
+// indexed by EvalTerm
+static constexpr EvalTermInfo eval_terms[NUM_EVAL_TERMS] = {
+	{"man", 100},
+	{"king", 140},
+	{"trade", 1},
+	{"back_rank", 8},
+	{"centre", 5},
+	{"runaway", 40},
+	{"tempo", 1},
+	{"mobility", 3},
+};
+
+
+// masks used by the positional terms
+static constexpr u32 black_back_rank = 0b0000'0000'0000'0000'0000'0000'0000'1111;
+static constexpr u32 white_back_rank = 0b1111'0000'0000'0000'0000'0000'0000'0000;
+static constexpr u32 centre_squares = 0b0000'0000'0110'0110'0110'0110'0000'0000;
+static constexpr u32 black_runaway_zone = 0b0000'1111'1111'1111'0000'0000'0000'0000; // three rows before the crown row
+static constexpr u32 white_runaway_zone = 0b0000'0000'0000'0000'1111'1111'1111'0000;
+
+// squares whose row index has bit 0, 1 or 2 set, used to sum row numbers with three popcounts
+static constexpr u32 row_bit_0 = 0b1111'0000'1111'0000'1111'0000'1111'0000;
+static constexpr u32 row_bit_1 = 0b1111'1111'0000'0000'1111'1111'0000'0000;
+static constexpr u32 row_bit_2 = 0b1111'1111'1111'1111'0000'0000'0000'0000;
+
+// the first of the two forward directions for each side's men
+static constexpr int black_forward_direction = 2; // down right, down left
+static constexpr int white_forward_direction = 0; // up left, up right
+
+
+EvalWeights EvalWeights::defaults() {
+	EvalWeights weights;
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		weights.values[term] = eval_terms[term].default_weight;
+	}
+	return weights;
+}
+
+
+// reads weights from a text file with one "name value" pair per line
+// blank lines and lines starting with # are ignored, terms that are not mentioned keep their current weight
+// returns false and leaves the weights unchanged if the file can't be read or has an unknown term
+bool EvalWeights::loadFromFile(const std::string &path) {
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	EvalWeights loaded = *this;
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string name;
+		int value;
+
+		if (!(fields >> name) || name[0] == '#') {
+			continue;
+		}
+
+		int term = findEvalTerm(name);
+		if (term < 0 || !(fields >> value)) {
+			return false;
+		}
+
+		loaded.values[term] = value;
+	}
+
+	*this = loaded;
+
+	return true;
+}
+
+
+// writes the weights in the format read by loadFromFile()
+bool EvalWeights::saveToFile(const std::string &path) const {
+	std::ofstream file(path);
+
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		file << getEvalTermName(term) << ' ' << values[term] << '\n';
+	}
+
+	file.close();
+
+	return !file.fail();
+}
+
+
+const char* getEvalTermName(int term) {
+	return eval_terms[term].name;
+}
+
+
+// returns the term with the given name, or -1 if there isn't one
+int findEvalTerm(const std::string &name) {
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		if (name == eval_terms[term].name) {
+			return term;
+		}
+	}
+	return -1;
+}
+
+
+// returns the squares from which a man stepping in either of the two directions
+// starting at first_direction would land on one of squares
+static inline u32 squaresBehind(u32 squares, int first_direction) {
+	return (squaresAdjacentTo(squares, first_direction) & move_mask[first_direction])
+		| (squaresAdjacentTo(squares, first_direction + 1) & move_mask[first_direction + 1]);
+}
+
+
+// returns the men in zone that have no piece at all in the three rows of squares ahead of them
+static inline u32 findRunawayMen(u32 men, u32 occupied, u32 zone, int forward_direction) {
+	// spread the occupied squares backwards one row at a time, so that a square ends up
+	// blocked if any square in its forward cone is occupied
+	u32 blocked = squaresBehind(occupied, forward_direction);
+	blocked = squaresBehind(occupied | blocked, forward_direction);
+	blocked = squaresBehind(occupied | blocked, forward_direction);
+
+	return men & zone & ~blocked;
+}
+
+
+// returns the sum of the row numbers of pieces
+static int sumRows(u32 pieces) {
+	return popcount(pieces & row_bit_0) + 2 * popcount(pieces & row_bit_1) + 4 * popcount(pieces & row_bit_2);
+}
+
+
+static int countMoves(const Bitboard &board, bool is_whites_turn) {
+	u32 movables[NUM_DIRECTIONS];
+	findMovablePieces(board, is_whites_turn, movables);
+
+	return popcount(movables[0]) + popcount(movables[1]) + popcount(movables[2]) + popcount(movables[3]);
+}
+
+
+// fills features (which must have room for NUM_EVAL_TERMS values) with each term of the evaluation
+// before weighting, measured as black's count minus white's count
+// everything is computed from whole board masks, there are no loops over squares or pieces
+void computeEvalFeatures(const Bitboard &board, int *features) {
+	const u32 black_men = board.black_pieces & ~board.king_pieces;
+	const u32 black_kings = board.black_pieces & board.king_pieces;
+	const u32 white_men = board.white_pieces & ~board.king_pieces;
+	const u32 white_kings = board.white_pieces & board.king_pieces;
+	const u32 occupied = board.black_pieces | board.white_pieces;
+
+	const int num_black_pieces = popcount(board.black_pieces);
+	const int num_white_pieces = popcount(board.white_pieces);
+	const int total_num_pieces = num_black_pieces + num_white_pieces;
+
+	features[EVAL_MAN] = popcount(black_men) - popcount(white_men);
+	features[EVAL_KING] = popcount(black_kings) - popcount(white_kings);
+
+	// try to encourage exchanges when in a winning position
+	features[EVAL_TRADE] = (num_black_pieces - num_white_pieces) * (32 - total_num_pieces);
+
+	features[EVAL_BACK_RANK] = popcount(black_men & black_back_rank) - popcount(white_men & white_back_rank);
+	features[EVAL_CENTRE] = popcount(board.black_pieces & centre_squares) - popcount(board.white_pieces & centre_squares);
+
+	features[EVAL_RUNAWAY] =
+		popcount(findRunawayMen(black_men, occupied, black_runaway_zone, black_forward_direction))
+		- popcount(findRunawayMen(white_men, occupied, white_runaway_zone, white_forward_direction));
+
+	// black men advance towards row 7 and white men towards row 0
+	const int black_tempo = sumRows(black_men);
+	const int white_tempo = 7 * popcount(white_men) - sumRows(white_men);
+	features[EVAL_TEMPO] = black_tempo - white_tempo;
+
+	features[EVAL_MOBILITY] = countMoves(board, false) - countMoves(board, true);
+}
+
+
+// returns a value representing how good the given board position is for black
+// positive values mean that black is winning and negative values mean white is winning
+int evaluate(const Bitboard &board, const EvalWeights &weights) {
+	int features[NUM_EVAL_TERMS];
+	computeEvalFeatures(board, features);
+
+	int value = 0;
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		value += features[term] * weights.values[term];
+	}
+
+	return value;
+}
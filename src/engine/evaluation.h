@@ -0,0 +1,42 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+
+#include <string>
+
+
+struct Bitboard;
+
+
+// the terms the evaluation is made up of
+// each is measured as black's count minus white's count and multiplied by its weight
+enum EvalTerm {
+	EVAL_MAN, // men on the board
+	EVAL_KING, // kings on the board
+	EVAL_TRADE, // material lead scaled by the number of pieces traded off
+	EVAL_BACK_RANK, // men still guarding their own back rank
+	EVAL_CENTRE, // pieces on the eight central squares
+	EVAL_RUNAWAY, // men near the crown row with nothing in front of them
+	EVAL_TEMPO, // rows advanced by men
+	EVAL_MOBILITY, // moves available in each direction
+	NUM_EVAL_TERMS,
+};
+
+
+struct EvalWeights {
+	int values[NUM_EVAL_TERMS];
+
+	static EvalWeights defaults();
+
+	bool loadFromFile(const std::string &path);
+	bool saveToFile(const std::string &path) const;
+};
+
+
+const char* getEvalTermName(int term);
+int findEvalTerm(const std::string &name);
+void computeEvalFeatures(const Bitboard &board, int *features);
+int evaluate(const Bitboard &board, const EvalWeights &weights);
+
+
+#endif // EVALUATION_H
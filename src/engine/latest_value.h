@@ -0,0 +1,50 @@
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+
+#include <atomic>
+
+
+// a single value passed from one thread to one other thread without locking, where each store
+// replaces the one before if it hasn't been taken yet, so the newest value is never lost
+//
+// there are three copies of the value: one the producer writes, one the consumer reads, and one
+// between them that each side swaps its own copy with, so neither ever touches the other's copy
+template <typename T>
+class LatestValue {
+public:
+	// called only by the producer
+	void store(const T &value) {
+		m_values[m_back] = value;
+		m_back = m_middle.exchange(m_back | NEW_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// called only by the producer, true until the consumer has taken the last value stored
+	bool isPending() const {
+		return (m_middle.load(std::memory_order_acquire) & NEW_BIT) != 0;
+	}
+
+	// called only by the consumer, returns false if nothing has been stored since the last take
+	bool take(T *value) {
+		if ((m_middle.load(std::memory_order_relaxed) & NEW_BIT) == 0) {
+			return false;
+		}
+
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		*value = m_values[m_front];
+
+		return true;
+	}
+
+private:
+	static constexpr unsigned INDEX_MASK = 3;
+	static constexpr unsigned NEW_BIT = 4; // set in m_middle when it holds a value not yet taken
+
+	T m_values[3];
+	unsigned m_back = 0; // only used by the producer
+	std::atomic<unsigned> m_middle {1};
+	unsigned m_front = 2; // only used by the consumer
+};
+
+
+#endif // LATEST_VALUE_H
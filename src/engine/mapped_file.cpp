@@ -0,0 +1,91 @@
+#include "engine/mapped_file.h"
+
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+
+// maps path, closing any file mapped before
+// returns false if it could not be opened
+bool MappedFile::open(const std::string &path) {
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat file_info;
+	if (fstat(fd, &file_info) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	m_size = static_cast<std::size_t>(file_info.st_size);
+
+	// an empty file can't be mapped, but there is nothing to read anyway
+	if (m_size > 0) {
+		void *data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			::close(fd);
+			m_size = 0;
+			return false;
+		}
+
+		m_data = static_cast<const unsigned char*>(data);
+		m_is_mapped = true;
+	}
+
+	// the mapping stays valid once the file is closed
+	::close(fd);
+
+	return true;
+#else
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	m_data = m_buffer.data();
+	m_size = m_buffer.size();
+
+	return true;
+#endif
+}
+
+
+void MappedFile::close() {
+#ifndef _WIN32
+	if (m_is_mapped) {
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+	}
+#endif
+
+	m_buffer.clear();
+	m_data = nullptr;
+	m_size = 0;
+	m_is_mapped = false;
+}
+
+
+const unsigned char* MappedFile::data() const {
+	return m_data;
+}
+
+
+std::size_t MappedFile::size() const {
+	return m_size;
+}
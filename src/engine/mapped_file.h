@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// a read only view of a whole file
+// the file is mapped into memory where the platform allows, so only the parts that are read
+// are loaded and the pages are shared between processes, otherwise it is read in
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string &path);
+	void close();
+
+	const unsigned char* data() const;
+	std::size_t size() const;
+
+private:
+	const unsigned char *m_data = nullptr;
+	std::size_t m_size = 0;
+	bool m_is_mapped = false;
+	std::vector<unsigned char> m_buffer; // holds the file when it isn't mapped
+};
+
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,495 @@
+#include "engine/nnue.h"
+
+#include "engine/byte_order.h"
+
+#include <algorithm> // for std::min, std::max
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// an AVX2 build also has SSE2, so both of its paths can be checked against the plain C++ one
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NNUE_USE_SSE2
+#endif
+
+
+static constexpr char MAGIC[4] = {'C', 'K', 'N', 'N'};
+static constexpr int HEADER_SIZE = 20;
+static constexpr int CLIP_MAX = 127;
+
+#if defined(NNUE_USE_AVX2)
+static constexpr NnueNetwork::Path FASTEST_PATH = NnueNetwork::AVX2_PATH;
+#elif defined(NNUE_USE_SSE2)
+static constexpr NnueNetwork::Path FASTEST_PATH = NnueNetwork::SSE2_PATH;
+#else
+static constexpr NnueNetwork::Path FASTEST_PATH = NnueNetwork::SCALAR_PATH;
+#endif
+
+using NnueHiddenWeights = std::int16_t[NnueNetwork::HIDDEN_SIZE * 2];
+
+
+// reads sequential little endian values out of a loaded file, remembering if it ran past the end
+class ByteReader {
+public:
+	ByteReader(const std::vector<unsigned char> &data) : m_data(data) {}
+
+	std::int64_t read(int num_bytes, bool is_signed) {
+		if (m_position + num_bytes > m_data.size()) {
+			m_overrun = true;
+			return 0;
+		}
+		u64 value = readLittleEndian(m_data.data() + m_position, num_bytes);
+		m_position += num_bytes;
+
+		// sign extend
+		if (is_signed && num_bytes < 8 && (value >> (8 * num_bytes - 1)) & 1) {
+			value |= ~u64(0) << (8 * num_bytes);
+		}
+		return static_cast<std::int64_t>(value);
+	}
+
+	bool isValid() const { return !m_overrun && m_position == m_data.size(); }
+
+private:
+	const std::vector<unsigned char> &m_data;
+	size_t m_position = 0;
+	bool m_overrun = false;
+};
+
+
+// returns the network stored in path, or a null pointer if it could not be read
+std::shared_ptr<const NnueNetwork> NnueNetwork::loadFromFile(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return nullptr;
+	}
+
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+		return nullptr;
+	}
+
+	ByteReader reader(data);
+	reader.read(4, false); // magic
+
+	if (reader.read(4, false) != FORMAT_VERSION
+			|| reader.read(4, false) != NUM_INPUTS
+			|| reader.read(4, false) != ACCUMULATOR_SIZE
+			|| reader.read(4, false) != HIDDEN_SIZE) {
+		return nullptr;
+	}
+
+	std::shared_ptr<NnueNetwork> network = std::make_shared<NnueNetwork>();
+
+	for (std::int16_t &bias : network->m_feature_biases) {
+		bias = static_cast<std::int16_t>(reader.read(2, true));
+	}
+	for (auto &weights : network->m_feature_weights) {
+		for (std::int16_t &weight : weights) {
+			weight = static_cast<std::int16_t>(reader.read(2, true));
+		}
+	}
+	for (std::int32_t &bias : network->m_hidden_biases) {
+		bias = static_cast<std::int32_t>(reader.read(4, true));
+	}
+	for (int neuron = 0; neuron < HIDDEN_SIZE; neuron++) {
+		for (int input = 0; input < ACCUMULATOR_SIZE; input++) {
+			network->m_hidden_weights[input / 2][neuron * 2 + input % 2] = static_cast<std::int16_t>(reader.read(1, true));
+		}
+	}
+	network->m_output_bias = static_cast<std::int32_t>(reader.read(4, true));
+	for (std::int32_t &weight : network->m_output_weights) {
+		weight = static_cast<std::int32_t>(reader.read(1, true));
+	}
+
+	if (!reader.isValid()) {
+		return nullptr;
+	}
+
+	return network;
+}
+
+
+// returns a network of random weights, the same for the same seed
+// it plays badly, but its accumulator values fall on both sides of the clipping range, so it
+// exercises every part of the evaluation and is enough to time it and check its paths agree
+std::shared_ptr<const NnueNetwork> NnueNetwork::createRandom(std::uint32_t seed) {
+	std::mt19937 rng(seed);
+	auto random = [&rng](int low, int high) { return std::uniform_int_distribution<int>(low, high)(rng); };
+
+	std::shared_ptr<NnueNetwork> network = std::make_shared<NnueNetwork>();
+
+	for (std::int16_t &bias : network->m_feature_biases) {
+		bias = static_cast<std::int16_t>(random(-64, 64));
+	}
+	for (auto &weights : network->m_feature_weights) {
+		for (std::int16_t &weight : weights) {
+			weight = static_cast<std::int16_t>(random(-48, 48));
+		}
+	}
+	for (std::int32_t &bias : network->m_hidden_biases) {
+		bias = random(-4096, 4096);
+	}
+	for (auto &weights : network->m_hidden_weights) {
+		for (std::int16_t &weight : weights) {
+			weight = static_cast<std::int16_t>(random(-128, 127));
+		}
+	}
+	network->m_output_bias = random(-1024, 1024);
+	for (std::int32_t &weight : network->m_output_weights) {
+		weight = random(-128, 127);
+	}
+
+	return network;
+}
+
+
+// writes the network to path in the format loadFromFile() reads
+// returns false if the file could not be written
+bool NnueNetwork::saveToFile(const std::string &path) const {
+	std::vector<unsigned char> data;
+
+	auto write = [&data](std::int64_t value, int num_bytes) {
+		unsigned char bytes[8];
+		writeLittleEndian(bytes, static_cast<u64>(value), num_bytes);
+		data.insert(data.end(), bytes, bytes + num_bytes);
+	};
+
+	data.insert(data.end(), MAGIC, MAGIC + sizeof(MAGIC));
+	write(FORMAT_VERSION, 4);
+	write(NUM_INPUTS, 4);
+	write(ACCUMULATOR_SIZE, 4);
+	write(HIDDEN_SIZE, 4);
+
+	for (std::int16_t bias : m_feature_biases) {
+		write(bias, 2);
+	}
+	for (const auto &weights : m_feature_weights) {
+		for (std::int16_t weight : weights) {
+			write(weight, 2);
+		}
+	}
+	for (std::int32_t bias : m_hidden_biases) {
+		write(bias, 4);
+	}
+	for (int neuron = 0; neuron < HIDDEN_SIZE; neuron++) {
+		for (int input = 0; input < ACCUMULATOR_SIZE; input++) {
+			write(m_hidden_weights[input / 2][neuron * 2 + input % 2], 1);
+		}
+	}
+	write(m_output_bias, 4);
+	for (std::int32_t weight : m_output_weights) {
+		write(weight, 1);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	file.close();
+
+	return !file.fail();
+}
+
+
+// piece types in input order, matching the layout described in nnue.h
+static void getPieceMasks(const Bitboard &board, u32 *masks) {
+	masks[0] = board.black_pieces & ~board.king_pieces;
+	masks[1] = board.black_pieces & board.king_pieces;
+	masks[2] = board.white_pieces & ~board.king_pieces;
+	masks[3] = board.white_pieces & board.king_pieces;
+}
+
+
+// computes the accumulator for board from scratch
+void NnueNetwork::refreshAccumulator(const Bitboard &board, Accumulator *accumulator) const {
+	std::memcpy(accumulator->values, m_feature_biases, sizeof(m_feature_biases));
+
+	u32 masks[4];
+	getPieceMasks(board, masks);
+
+	for (int piece_type = 0; piece_type < 4; piece_type++) {
+		addFeatures(piece_type, masks[piece_type], accumulator);
+	}
+}
+
+
+// computes the accumulator for board from the accumulator of a board one move earlier
+// only the few squares that changed are touched, which is much cheaper than a refresh
+void NnueNetwork::updateAccumulator(const Accumulator &previous, const Bitboard &previous_board,
+		const Bitboard &board, Accumulator *accumulator) const {
+	*accumulator = previous;
+
+	u32 previous_masks[4];
+	u32 masks[4];
+	getPieceMasks(previous_board, previous_masks);
+	getPieceMasks(board, masks);
+
+	for (int piece_type = 0; piece_type < 4; piece_type++) {
+		subtractFeatures(piece_type, previous_masks[piece_type] & ~masks[piece_type], accumulator);
+		addFeatures(piece_type, masks[piece_type] & ~previous_masks[piece_type], accumulator);
+	}
+}
+
+
+void NnueNetwork::addFeatures(int piece_type, u32 squares, Accumulator *accumulator) const {
+	std::int16_t *values = accumulator->values;
+
+	for (; squares; squares &= squares - 1) {
+		const std::int16_t *weights = m_feature_weights[piece_type * 32 + lsbIndex(squares)];
+
+#if defined(NNUE_USE_AVX2)
+		for (int i = 0; i < ACCUMULATOR_SIZE; i += 16) {
+			__m256i sum = _mm256_add_epi16(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), sum);
+		}
+#elif defined(NNUE_USE_SSE2)
+		for (int i = 0; i < ACCUMULATOR_SIZE; i += 8) {
+			__m128i sum = _mm_add_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), sum);
+		}
+#else
+		for (int i = 0; i < ACCUMULATOR_SIZE; i++) {
+			values[i] = static_cast<std::int16_t>(values[i] + weights[i]);
+		}
+#endif
+	}
+}
+
+
+void NnueNetwork::subtractFeatures(int piece_type, u32 squares, Accumulator *accumulator) const {
+	std::int16_t *values = accumulator->values;
+
+	for (; squares; squares &= squares - 1) {
+		const std::int16_t *weights = m_feature_weights[piece_type * 32 + lsbIndex(squares)];
+
+#if defined(NNUE_USE_AVX2)
+		for (int i = 0; i < ACCUMULATOR_SIZE; i += 16) {
+			__m256i difference = _mm256_sub_epi16(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), difference);
+		}
+#elif defined(NNUE_USE_SSE2)
+		for (int i = 0; i < ACCUMULATOR_SIZE; i += 8) {
+			__m128i difference = _mm_sub_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), difference);
+		}
+#else
+		for (int i = 0; i < ACCUMULATOR_SIZE; i++) {
+			values[i] = static_cast<std::int16_t>(values[i] - weights[i]);
+		}
+#endif
+	}
+}
+
+
+// clips the accumulator to [0, CLIP_MAX]
+static void clipInputsScalar(const std::int16_t *values, std::int16_t *inputs) {
+	for (int i = 0; i < NnueNetwork::ACCUMULATOR_SIZE; i++) {
+		inputs[i] = static_cast<std::int16_t>(std::min<int>(std::max<int>(values[i], 0), CLIP_MAX));
+	}
+}
+
+
+// the dense layer, computed for all neurons at once by going through the inputs in pairs
+// every product fits in 16 bits and each pair of products is summed into 32 bits
+// inputs clipped to zero are common, so pairs that are both zero are skipped
+static void computeHiddenSumsScalar(const std::int16_t *inputs, const NnueHiddenWeights *weights, std::int32_t *sums) {
+	for (int neuron = 0; neuron < NnueNetwork::HIDDEN_SIZE; neuron++) {
+		sums[neuron] = 0;
+	}
+
+	for (int pair = 0; pair < NnueNetwork::ACCUMULATOR_SIZE / 2; pair++) {
+		const int first_input = inputs[pair * 2];
+		const int second_input = inputs[pair * 2 + 1];
+		if (first_input == 0 && second_input == 0) {
+			continue;
+		}
+
+		const std::int16_t *pair_weights = weights[pair];
+
+		for (int neuron = 0; neuron < NnueNetwork::HIDDEN_SIZE; neuron++) {
+			sums[neuron] += first_input * pair_weights[neuron * 2] + second_input * pair_weights[neuron * 2 + 1];
+		}
+	}
+}
+
+
+#if defined(NNUE_USE_SSE2)
+static void clipInputsSse2(const std::int16_t *values, std::int16_t *inputs) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i clip_max = _mm_set1_epi16(CLIP_MAX);
+
+	for (int i = 0; i < NnueNetwork::ACCUMULATOR_SIZE; i += 8) {
+		__m128i clipped = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+		clipped = _mm_min_epi16(_mm_max_epi16(clipped, zero), clip_max);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(inputs + i), clipped);
+	}
+}
+
+
+// eight registers of four neurons each, written out so that they stay in registers
+static void computeHiddenSumsSse2(const std::int16_t *inputs, const NnueHiddenWeights *weights, std::int32_t *sums) {
+	static_assert(NnueNetwork::HIDDEN_SIZE == 32, "the SIMD dense layer is written for 32 neurons");
+	__m128i sums_0 = _mm_setzero_si128();
+	__m128i sums_1 = _mm_setzero_si128();
+	__m128i sums_2 = _mm_setzero_si128();
+	__m128i sums_3 = _mm_setzero_si128();
+	__m128i sums_4 = _mm_setzero_si128();
+	__m128i sums_5 = _mm_setzero_si128();
+	__m128i sums_6 = _mm_setzero_si128();
+	__m128i sums_7 = _mm_setzero_si128();
+
+	for (int pair = 0; pair < NnueNetwork::ACCUMULATOR_SIZE / 2; pair++) {
+		std::int32_t packed_inputs;
+		std::memcpy(&packed_inputs, inputs + pair * 2, sizeof(packed_inputs));
+		if (packed_inputs == 0) {
+			continue;
+		}
+
+		const __m128i broadcast_inputs = _mm_set1_epi32(packed_inputs);
+		const __m128i *pair_weights = reinterpret_cast<const __m128i*>(weights[pair]);
+
+		sums_0 = _mm_add_epi32(sums_0, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 0)));
+		sums_1 = _mm_add_epi32(sums_1, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 1)));
+		sums_2 = _mm_add_epi32(sums_2, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 2)));
+		sums_3 = _mm_add_epi32(sums_3, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 3)));
+		sums_4 = _mm_add_epi32(sums_4, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 4)));
+		sums_5 = _mm_add_epi32(sums_5, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 5)));
+		sums_6 = _mm_add_epi32(sums_6, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 6)));
+		sums_7 = _mm_add_epi32(sums_7, _mm_madd_epi16(broadcast_inputs, _mm_loadu_si128(pair_weights + 7)));
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 0), sums_0);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 4), sums_1);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 8), sums_2);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 12), sums_3);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 16), sums_4);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 20), sums_5);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 24), sums_6);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + 28), sums_7);
+}
+#endif
+
+
+#if defined(NNUE_USE_AVX2)
+static void clipInputsAvx2(const std::int16_t *values, std::int16_t *inputs) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i clip_max = _mm256_set1_epi16(CLIP_MAX);
+
+	for (int i = 0; i < NnueNetwork::ACCUMULATOR_SIZE; i += 16) {
+		__m256i clipped = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+		clipped = _mm256_min_epi16(_mm256_max_epi16(clipped, zero), clip_max);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(inputs + i), clipped);
+	}
+}
+
+
+// four registers of eight neurons each, written out so that they stay in registers
+static void computeHiddenSumsAvx2(const std::int16_t *inputs, const NnueHiddenWeights *weights, std::int32_t *sums) {
+	static_assert(NnueNetwork::HIDDEN_SIZE == 32, "the SIMD dense layer is written for 32 neurons");
+	__m256i sums_0 = _mm256_setzero_si256();
+	__m256i sums_1 = _mm256_setzero_si256();
+	__m256i sums_2 = _mm256_setzero_si256();
+	__m256i sums_3 = _mm256_setzero_si256();
+
+	for (int pair = 0; pair < NnueNetwork::ACCUMULATOR_SIZE / 2; pair++) {
+		std::int32_t packed_inputs;
+		std::memcpy(&packed_inputs, inputs + pair * 2, sizeof(packed_inputs));
+		if (packed_inputs == 0) {
+			continue;
+		}
+
+		const __m256i broadcast_inputs = _mm256_set1_epi32(packed_inputs);
+		const __m256i *pair_weights = reinterpret_cast<const __m256i*>(weights[pair]);
+
+		sums_0 = _mm256_add_epi32(sums_0, _mm256_madd_epi16(broadcast_inputs, _mm256_loadu_si256(pair_weights + 0)));
+		sums_1 = _mm256_add_epi32(sums_1, _mm256_madd_epi16(broadcast_inputs, _mm256_loadu_si256(pair_weights + 1)));
+		sums_2 = _mm256_add_epi32(sums_2, _mm256_madd_epi16(broadcast_inputs, _mm256_loadu_si256(pair_weights + 2)));
+		sums_3 = _mm256_add_epi32(sums_3, _mm256_madd_epi16(broadcast_inputs, _mm256_loadu_si256(pair_weights + 3)));
+	}
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + 0), sums_0);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + 8), sums_1);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + 16), sums_2);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + 24), sums_3);
+}
+#endif
+
+
+// returns true if the build includes the given way of evaluating the network
+bool NnueNetwork::isPathAvailable(Path path) {
+	switch (path) {
+	case SCALAR_PATH:
+		return true;
+	case SSE2_PATH:
+#if defined(NNUE_USE_SSE2)
+		return true;
+#else
+		return false;
+#endif
+	case AVX2_PATH:
+#if defined(NNUE_USE_AVX2)
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	return false;
+}
+
+
+// returns the score for black of the position the accumulator was built from
+int NnueNetwork::evaluate(const Accumulator &accumulator) const {
+	return evaluate(accumulator, FASTEST_PATH);
+}
+
+
+// as above, computed with the given path, which must be available
+// every path gives the same score, the others being kept so that this can be checked
+int NnueNetwork::evaluate(const Accumulator &accumulator, Path path) const {
+	std::int16_t inputs[ACCUMULATOR_SIZE];
+	std::int32_t sums[HIDDEN_SIZE];
+
+	switch (path) {
+#if defined(NNUE_USE_AVX2)
+	case AVX2_PATH:
+		clipInputsAvx2(accumulator.values, inputs);
+		computeHiddenSumsAvx2(inputs, m_hidden_weights, sums);
+		break;
+#endif
+#if defined(NNUE_USE_SSE2)
+	case SSE2_PATH:
+		clipInputsSse2(accumulator.values, inputs);
+		computeHiddenSumsSse2(inputs, m_hidden_weights, sums);
+		break;
+#endif
+	default:
+		clipInputsScalar(accumulator.values, inputs);
+		computeHiddenSumsScalar(inputs, m_hidden_weights, sums);
+		break;
+	}
+
+	std::int32_t output = m_output_bias;
+
+	for (int neuron = 0; neuron < HIDDEN_SIZE; neuron++) {
+		int activation = std::min(std::max((sums[neuron] + m_hidden_biases[neuron]) >> HIDDEN_SHIFT, 0), CLIP_MAX);
+		output += activation * m_output_weights[neuron];
+	}
+
+	return output >> OUTPUT_SHIFT;
+}
@@ -0,0 +1,72 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+
+#include "engine/bitboard.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+// a small quantised neural network evaluation
+//
+// inputs: one per (piece type, square) pair, the piece types being black man,
+// black king, white man and white king, so 4 x 32 = 128 binary inputs
+// layer 1: 128 -> 128, int16 weights, kept as an accumulator which is updated
+// incrementally when pieces appear and disappear
+// layer 2: 128 -> 32, int8 weights on the accumulator clipped to [0, 127]
+// output: 32 -> 1, int8 weights on layer 2 shifted down by HIDDEN_SHIFT and clipped to [0, 127]
+// the output is shifted down by OUTPUT_SHIFT to give a score for black on the same scale as evaluate()
+// the layers are computed with AVX2 or SSE2 when the build targets them, and the plain C++ and SSE2
+// versions are kept in such builds too, so that all of them can be checked to give the same scores
+//
+// file format (little endian): "CKNN", version, number of inputs, accumulator size and
+// hidden size as u32, then the layer 1 biases (i16), layer 1 weights (i16, input major),
+// layer 2 biases (i32), layer 2 weights (i8, output major), output bias (i32) and output weights (i8)
+class NnueNetwork {
+public:
+	static constexpr int NUM_INPUTS = 4 * 32;
+	static constexpr int ACCUMULATOR_SIZE = 128;
+	static constexpr int HIDDEN_SIZE = 32;
+	static constexpr int HIDDEN_SHIFT = 6;
+	static constexpr int OUTPUT_SHIFT = 4;
+	static constexpr int FORMAT_VERSION = 1;
+
+	enum Path {
+		SCALAR_PATH,
+		SSE2_PATH,
+		AVX2_PATH,
+	};
+
+	struct Accumulator {
+		std::int16_t values[ACCUMULATOR_SIZE];
+	};
+
+	static std::shared_ptr<const NnueNetwork> loadFromFile(const std::string &path);
+	static std::shared_ptr<const NnueNetwork> createRandom(std::uint32_t seed);
+	bool saveToFile(const std::string &path) const;
+	static bool isPathAvailable(Path path);
+
+	void refreshAccumulator(const Bitboard &board, Accumulator *accumulator) const;
+	void updateAccumulator(const Accumulator &previous, const Bitboard &previous_board,
+		const Bitboard &board, Accumulator *accumulator) const;
+	int evaluate(const Accumulator &accumulator) const;
+	int evaluate(const Accumulator &accumulator, Path path) const;
+
+private:
+	void addFeatures(int piece_type, u32 squares, Accumulator *accumulator) const;
+	void subtractFeatures(int piece_type, u32 squares, Accumulator *accumulator) const;
+
+	std::int16_t m_feature_biases[ACCUMULATOR_SIZE];
+	std::int16_t m_feature_weights[NUM_INPUTS][ACCUMULATOR_SIZE];
+	std::int32_t m_hidden_biases[HIDDEN_SIZE];
+	// stored as i8 and widened when loaded, then laid out so that the weights from a pair of
+	// neighbouring inputs to each neuron sit next to each other, [input pair][neuron * 2 + input in pair]
+	std::int16_t m_hidden_weights[ACCUMULATOR_SIZE / 2][HIDDEN_SIZE * 2];
+	std::int32_t m_output_bias;
+	std::int32_t m_output_weights[HIDDEN_SIZE];
+};
+
+
+#endif // NNUE_H
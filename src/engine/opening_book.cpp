@@ -0,0 +1,171 @@
+#include "engine/opening_book.h"
+
+#include "engine/bitboard_movegen.h"
+#include "engine/byte_order.h"
+#include "engine/zobrist.h"
+
+#include <algorithm> // for std::sort, std::min, std::max, std::find
+#include <cstring>
+#include <fstream>
+
+
+static constexpr char MAGIC[4] = {'C', 'K', 'B', 'K'};
+static constexpr int FORMAT_VERSION = 1;
+static constexpr int HEADER_SIZE = 16;
+static constexpr int RECORD_SIZE = 16;
+
+// scores are stored in 16 bits, which holds every score the search gives
+static constexpr int MAX_STORED_SCORE = 32767;
+
+
+// maps path and checks its header, closing any book opened before
+// returns false if it could not be opened or is not a book file
+bool OpeningBook::open(const std::string &path) {
+	m_records = nullptr;
+	m_num_entries = 0;
+
+	if (!m_file.open(path) || m_file.size() < HEADER_SIZE) {
+		return false;
+	}
+
+	const unsigned char *header = m_file.data();
+	if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0
+			|| readLittleEndian(header + 4, 4) != FORMAT_VERSION
+			|| readLittleEndian(header + 8, 4) != RECORD_SIZE
+			|| (m_file.size() - HEADER_SIZE) % RECORD_SIZE != 0) {
+		return false;
+	}
+
+	m_records = header + HEADER_SIZE;
+	m_num_entries = (m_file.size() - HEADER_SIZE) / RECORD_SIZE;
+
+	return true;
+}
+
+
+std::size_t OpeningBook::getNumEntries() const {
+	return m_num_entries;
+}
+
+
+// copies up to max_entries of the entries with key into entries, in the order they are stored
+// returns the number copied, zero if the position isn't in the book
+int OpeningBook::findEntries(u64 key, BookEntry *entries, int max_entries) const {
+	// the first record with a key that isn't less than key
+	std::size_t low = 0;
+	std::size_t high = m_num_entries;
+
+	while (low < high) {
+		const std::size_t middle = low + (high - low) / 2;
+		if (readLittleEndian(m_records + middle * RECORD_SIZE, 8) < key) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	int num_found = 0;
+	for (std::size_t i = low; i < m_num_entries && num_found < max_entries; i++) {
+		const BookEntry entry = readEntry(i);
+		if (entry.key != key) {
+			break;
+		}
+		entries[num_found++] = entry;
+	}
+
+	return num_found;
+}
+
+
+// picks one of the book's moves for the position, each with a chance in proportion to its weight
+// random is a uniformly random number that decides which
+// returns false if the position has no moves in the book that can be played
+bool OpeningBook::pickMove(const Bitboard &board, bool is_whites_turn, std::uint32_t random, BookEntry *entry) const {
+	BookEntry entries[MAX_MOVES];
+	const int num_entries = findEntries(hashBitboard(board, is_whites_turn), entries, MAX_MOVES);
+	if (num_entries == 0) {
+		return false;
+	}
+
+	Bitboard next_positions[MAX_MOVES];
+	CompactMove moves[MAX_MOVES];
+	const int num_moves = generateMoves(board, is_whites_turn, next_positions, moves);
+
+	// another position can have the same key, so only the entries with a legal move are kept
+	int num_playable = 0;
+	u64 total_weight = 0;
+
+	for (int i = 0; i < num_entries; i++) {
+		if (entries[i].weight > 0 && std::find(moves, moves + num_moves, entries[i].move) != moves + num_moves) {
+			total_weight += entries[i].weight;
+			entries[num_playable++] = entries[i];
+		}
+	}
+
+	if (total_weight == 0) {
+		return false;
+	}
+
+	u64 target = (static_cast<u64>(random) * total_weight) >> 32;
+
+	for (int i = 0; i < num_playable; i++) {
+		if (target < static_cast<u64>(entries[i].weight)) {
+			*entry = entries[i];
+			return true;
+		}
+		target -= entries[i].weight;
+	}
+
+	*entry = entries[num_playable - 1];
+	return true;
+}
+
+
+// writes entries to a book file at path, sorted so that they can be looked up, replacing any file there
+// weights and scores out of the range the file holds are clamped to it
+// returns false if the file could not be written
+bool OpeningBook::write(const std::string &path, std::vector<BookEntry> entries) {
+	// the moves of a position are stored most likely first
+	std::sort(entries.begin(), entries.end(), [](const BookEntry &a, const BookEntry &b) {
+		return a.key != b.key ? a.key < b.key : a.weight > b.weight;
+	});
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	unsigned char header[HEADER_SIZE] = {};
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	writeLittleEndian(header + 4, FORMAT_VERSION, 4);
+	writeLittleEndian(header + 8, RECORD_SIZE, 4);
+	file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+	for (const BookEntry &entry : entries) {
+		const int weight = std::min(std::max(entry.weight, 0), MAX_BOOK_WEIGHT);
+		const int score = std::min(std::max(entry.score, -MAX_STORED_SCORE), MAX_STORED_SCORE);
+
+		unsigned char record[RECORD_SIZE];
+		writeLittleEndian(record + 0, entry.key, 8);
+		writeLittleEndian(record + 8, entry.move.toBits(), 4);
+		writeLittleEndian(record + 12, static_cast<u64>(weight), 2);
+		writeLittleEndian(record + 14, static_cast<std::uint16_t>(score), 2);
+		file.write(reinterpret_cast<const char*>(record), RECORD_SIZE);
+	}
+
+	file.close();
+	return !file.fail();
+}
+
+
+BookEntry OpeningBook::readEntry(std::size_t index) const {
+	const unsigned char *record = m_records + index * RECORD_SIZE;
+
+	BookEntry entry;
+	entry.key = readLittleEndian(record + 0, 8);
+	entry.move = CompactMove::fromBits(static_cast<std::uint32_t>(readLittleEndian(record + 8, 4)));
+	entry.weight = static_cast<int>(readLittleEndian(record + 12, 2));
+	entry.score = static_cast<std::int16_t>(readLittleEndian(record + 14, 2));
+
+	return entry;
+}
@@ -0,0 +1,50 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+
+#include "engine/bitboard.h"
+#include "engine/compact_move.h"
+#include "engine/mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// the weights of a position's moves are stored in 16 bits
+constexpr int MAX_BOOK_WEIGHT = 65535;
+
+
+// a move of the opening, played from the position with the key without searching it
+struct BookEntry {
+	u64 key; // of the position and the side to move, see hashBitboard()
+	CompactMove move;
+	int weight; // chance of the move being played relative to the other moves of the position, up to MAX_BOOK_WEIGHT
+	int score; // for the side to move, from the search the book was made with
+};
+
+
+// the moves of a book file written by checkers_bookgen, looked up by binary search in the mapped file
+// file layout: a 16 byte header followed by 16 byte little endian records sorted by key, each holding
+// the key in 8 bytes, the move as CompactMove::toBits() in 4, and the weight and score in 2 each
+class OpeningBook {
+public:
+	bool open(const std::string &path);
+	std::size_t getNumEntries() const;
+
+	int findEntries(u64 key, BookEntry *entries, int max_entries) const;
+	bool pickMove(const Bitboard &board, bool is_whites_turn, std::uint32_t random, BookEntry *entry) const;
+
+	static bool write(const std::string &path, std::vector<BookEntry> entries);
+
+private:
+	BookEntry readEntry(std::size_t index) const;
+
+	MappedFile m_file;
+	const unsigned char *m_records = nullptr;
+	std::size_t m_num_entries = 0;
+};
+
+
+#endif // OPENING_BOOK_H
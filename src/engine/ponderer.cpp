@@ -0,0 +1,90 @@
+#include "engine/ponderer.h"
+
+#include "game/game.h"
+#include "game/turn.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/conversion.h"
+
+
+Ponderer::Ponderer(Engine *engine) :
+	m_engine(engine)
+{
+}
+
+
+Ponderer::~Ponderer() {
+	stop();
+}
+
+
+// starts searching the position reached by playing expected_reply in game
+// game is the position the opponent is thinking about, after the engine's own move
+// does nothing if the reply isn't known or isn't legal
+void Ponderer::start(const Game &game, CompactMove expected_reply, const SearchLimits &limits) {
+	stop();
+
+	Bitboard board = convertBoardToBitboard(game.getBoard());
+	bool is_whites_turn = (game.getTurn() == Turn::WHITE);
+
+	Bitboard next_positions[MAX_MOVES];
+	CompactMove moves[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, moves);
+
+	for (int i = 0; i < moves_found; i++) {
+		if (moves[i] == expected_reply) {
+			m_board = next_positions[i];
+			m_is_whites_turn = !is_whites_turn;
+			m_history = Engine::getHistoryKeys(game); // the position before the reply is now part of the game
+
+			m_stop = false;
+			m_ponder = true;
+			m_limits = limits;
+			m_limits.stop = &m_stop;
+			m_limits.ponder = &m_ponder;
+
+			m_thread = std::thread([this]() {
+				m_result = m_engine->search(m_board, m_is_whites_turn, m_limits, m_history);
+			});
+
+			return;
+		}
+	}
+}
+
+
+// called once it is the engine's turn in game
+// if the search in progress is of game's position, waits for it to finish under its limits,
+// stores its result and returns true, otherwise stops any search and returns false
+bool Ponderer::finish(const Game &game, SearchInfo *result) {
+	if (!m_thread.joinable()) {
+		return false;
+	}
+
+	Bitboard board = convertBoardToBitboard(game.getBoard());
+	bool is_whites_turn = (game.getTurn() == Turn::WHITE);
+
+	bool is_hit = board.black_pieces == m_board.black_pieces && board.white_pieces == m_board.white_pieces
+		&& board.king_pieces == m_board.king_pieces && is_whites_turn == m_is_whites_turn;
+
+	if (!is_hit) {
+		stop();
+		return false;
+	}
+
+	m_ponder = false;
+	m_thread.join();
+
+	*result = m_result;
+
+	return true;
+}
+
+
+// abandons the search in progress, if any
+void Ponderer::stop() {
+	m_stop = true;
+
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef PONDERER_H
+#define PONDERER_H
+
+
+#include "engine/engine.h"
+#include "engine/search_limits.h"
+#include "engine/compact_move.h"
+#include "engine/bitboard.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+class Game;
+
+
+// searches on another thread while the opponent is thinking, assuming they will play the reply
+// the engine expects. if they do, the search carries on as the engine's real search and
+// finish() returns its result, otherwise it is stopped and only its hash entries are kept
+//
+// the engine mustn't be used for anything else while a ponder search is running
+class Ponderer {
+public:
+	explicit Ponderer(Engine *engine);
+	~Ponderer();
+
+	void start(const Game &game, CompactMove expected_reply, const SearchLimits &limits);
+	bool finish(const Game &game, SearchInfo *result);
+	void stop();
+
+private:
+	Engine *m_engine;
+
+	std::thread m_thread;
+	std::atomic<bool> m_stop {false};
+	std::atomic<bool> m_ponder {false};
+	SearchLimits m_limits;
+
+	// the position being searched, after the expected reply
+	Bitboard m_board;
+	bool m_is_whites_turn = false;
+	std::vector<u64> m_history; // keys of the game's positions before it
+
+	SearchInfo m_result {};
+};
+
+
+#endif // PONDERER_H
@@ -0,0 +1,86 @@
+#include "engine/position_file.h"
+
+#include "engine/byte_order.h"
+
+#include <cstring>
+
+
+static constexpr char MAGIC[4] = {'C', 'K', 'L', 'P'};
+static constexpr int FORMAT_VERSION = 1;
+static constexpr int HEADER_SIZE = 16;
+static constexpr int RECORD_SIZE = 14;
+
+
+// opens path for writing, discarding any previous contents
+// returns false if the file could not be opened
+bool PositionFileWriter::open(const std::string &path) {
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file) {
+		return false;
+	}
+
+	unsigned char header[HEADER_SIZE] = {};
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	writeLittleEndian(header + 4, FORMAT_VERSION, 4);
+	writeLittleEndian(header + 8, RECORD_SIZE, 4);
+	m_file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+	return true;
+}
+
+
+void PositionFileWriter::write(const LabelledPosition &position) {
+	unsigned char record[RECORD_SIZE];
+
+	writeLittleEndian(record + 0, position.board.black_pieces, 4);
+	writeLittleEndian(record + 4, position.board.white_pieces, 4);
+	writeLittleEndian(record + 8, position.board.king_pieces, 4);
+	record[12] = position.is_whites_turn ? 1 : 0;
+	record[13] = static_cast<unsigned char>(position.result);
+
+	m_file.write(reinterpret_cast<const char*>(record), RECORD_SIZE);
+}
+
+
+// returns false if any write failed
+bool PositionFileWriter::close() {
+	m_file.close();
+	return !m_file.fail();
+}
+
+
+// opens path and checks its header
+// returns false if it could not be opened or is not a position file
+bool PositionFileReader::open(const std::string &path) {
+	m_file.open(path, std::ios::binary);
+
+	unsigned char header[HEADER_SIZE];
+	if (!m_file.read(reinterpret_cast<char*>(header), HEADER_SIZE)) {
+		return false;
+	}
+
+	return std::memcmp(header, MAGIC, sizeof(MAGIC)) == 0
+		&& readLittleEndian(header + 4, 4) == FORMAT_VERSION
+		&& readLittleEndian(header + 8, 4) == RECORD_SIZE;
+}
+
+
+// reads the next position
+PositionFileReader::ReadResult PositionFileReader::read(LabelledPosition *position) {
+	unsigned char record[RECORD_SIZE];
+	if (!m_file.read(reinterpret_cast<char*>(record), RECORD_SIZE)) {
+		return (m_file.gcount() == 0) ? END_OF_FILE : INVALID_RECORD;
+	}
+
+	if (record[13] > LabelledPosition::BLACK_WIN) {
+		return INVALID_RECORD;
+	}
+
+	position->board.black_pieces = static_cast<u32>(readLittleEndian(record + 0, 4));
+	position->board.white_pieces = static_cast<u32>(readLittleEndian(record + 4, 4));
+	position->board.king_pieces = static_cast<u32>(readLittleEndian(record + 8, 4));
+	position->is_whites_turn = record[12] != 0;
+	position->result = static_cast<LabelledPosition::Result>(record[13]);
+
+	return POSITION_READ;
+}
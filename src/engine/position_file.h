@@ -0,0 +1,55 @@
+#ifndef POSITION_FILE_H
+#define POSITION_FILE_H
+
+
+#include "engine/bitboard.h"
+
+#include <fstream>
+#include <string>
+
+
+// a position labelled with the result of the game it came from
+struct LabelledPosition {
+	enum Result {
+		WHITE_WIN,
+		DRAW,
+		BLACK_WIN,
+	};
+
+	Bitboard board;
+	bool is_whites_turn;
+	Result result;
+};
+
+
+// writes labelled positions to a binary file one at a time
+// file layout: a 16 byte header followed by fixed size little endian records
+class PositionFileWriter {
+public:
+	bool open(const std::string &path);
+	void write(const LabelledPosition &position);
+	bool close();
+
+private:
+	std::ofstream m_file;
+};
+
+
+// reads the positions of a file written by PositionFileWriter one at a time
+class PositionFileReader {
+public:
+	enum ReadResult {
+		POSITION_READ,
+		END_OF_FILE,
+		INVALID_RECORD, // cut short or with an unknown result, nothing after it is read
+	};
+
+	bool open(const std::string &path);
+	ReadResult read(LabelledPosition *position);
+
+private:
+	std::ifstream m_file;
+};
+
+
+#endif // POSITION_FILE_H
@@ -0,0 +1,52 @@
+#include "engine/quiescence.h"
+
+#include "engine/bitboard_masks.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/evaluation.h"
+
+#include <algorithm> // for std::max
+#include <climits>
+
+
+// resolves forced captures by searching every capture sequence until the side to move has none left
+// returns the score for the side to move of the quiet position at the end of the best line
+// quiet_position is optional, if given it receives that quiet position
+// captures are compulsory, so unlike chess there is no option to stand pat while captures remain
+int quiescence(const Bitboard &board, bool is_whites_turn, int alpha, int beta,
+		const EvalWeights &weights, QuietPosition *quiet_position) {
+	u32 movables[NUM_DIRECTIONS];
+
+	if (!findMovablePieces(board, is_whites_turn, movables)) {
+		if (quiet_position != nullptr) {
+			*quiet_position = {board, is_whites_turn};
+		}
+		return evaluate(board, weights) * (is_whites_turn ? -1 : 1);
+	}
+
+	Bitboard next_positions[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, nullptr);
+
+	int value = -INT_MAX;
+
+	for (int i = 0; i < moves_found; i++) {
+		QuietPosition child_quiet_position;
+
+		int new_value = -quiescence(next_positions[i], !is_whites_turn, -beta, -alpha, weights,
+			quiet_position != nullptr ? &child_quiet_position : nullptr);
+
+		if (new_value > value) {
+			value = new_value;
+			if (quiet_position != nullptr) {
+				*quiet_position = child_quiet_position;
+			}
+		}
+
+		alpha = std::max(alpha, value);
+
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	return value;
+}
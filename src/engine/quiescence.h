@@ -0,0 +1,21 @@
+#ifndef QUIESCENCE_H
+#define QUIESCENCE_H
+
+
+#include "engine/bitboard.h"
+
+
+struct EvalWeights;
+
+
+struct QuietPosition {
+	Bitboard board;
+	bool is_whites_turn;
+};
+
+
+int quiescence(const Bitboard &board, bool is_whites_turn, int alpha, int beta,
+	const EvalWeights &weights, QuietPosition *quiet_position);
+
+
+#endif // QUIESCENCE_H
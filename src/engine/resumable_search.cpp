@@ -0,0 +1,350 @@
+#include "engine/resumable_search.h"
+
+#include "engine/bitboard_movegen.h"
+#include "engine/endgame.h"
+#include "engine/score.h"
+#include "engine/static_exchange.h"
+#include "engine/zobrist.h"
+
+#include <algorithm> // for std::max, std::min
+#include <chrono>
+#include <climits>
+#include <utility> // for std::swap
+
+
+static std::int64_t currentTimeUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ResumableSearch::ResumableSearch(const Bitboard &board, bool is_whites_turn, int max_depth, const EvalWeights &weights,
+		bool exchange_pruning, std::shared_ptr<const NnueNetwork> network, std::shared_ptr<TranspositionTable> table,
+		std::shared_ptr<TablebaseProber> tablebases) :
+	m_board(board),
+	m_is_whites_turn(is_whites_turn),
+	m_max_depth(max_depth),
+	m_eval_weights(weights),
+	m_exchange_pruning(exchange_pruning),
+	m_network(network),
+	m_transposition_table(table),
+	m_tablebases(tablebases),
+	m_tablebase_pieces(tablebases != nullptr ? tablebases->getMaxPieces() : 0),
+	m_probe_pieces(std::min(m_tablebase_pieces, popcount(board.black_pieces | board.white_pieces) - 1))
+{
+	m_frames.reserve(max_depth + 1);
+
+	Bitboard next_positions[MAX_MOVES];
+	CompactMove moves[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, moves);
+	m_root_moves.assign(moves, moves + moves_found);
+}
+
+
+// searches until about node_budget more nodes have been visited or the search is finished
+// returns true once it is finished, getResult() then has the result of the deepest depth
+bool ResumableSearch::step(std::uint64_t node_budget) {
+	const std::uint64_t end_nodes = m_nodes + node_budget;
+	m_step_start_us = currentTimeUs();
+
+	// set when the frame on top of the stack has to take in the score of the child it just searched
+	bool has_child_value = false;
+	int child_value = 0;
+
+	while (!m_finished) {
+		if (m_frames.empty()) {
+			if (m_nodes >= end_nodes) {
+				break;
+			}
+			startDepth();
+			continue;
+		}
+
+		Frame &frame = m_frames.back();
+
+		if (has_child_value) {
+			has_child_value = false;
+
+			int new_value = -child_value;
+			int index = getGeneratedIndex(frame, frame.next_move);
+			frame.next_move++;
+
+			if (new_value > frame.value) {
+				frame.value = new_value;
+				frame.best_generated_index = index;
+			}
+
+			frame.alpha = std::max(frame.alpha, frame.value);
+		}
+
+		if (frame.next_move < frame.num_moves && frame.alpha < frame.beta) {
+			// only ever pauses here, between children, where the frames hold everything there is to know
+			if (m_nodes >= end_nodes) {
+				break;
+			}
+
+			// a copy, as entering the child adds its own children to the buffer
+			const Bitboard child = m_children[frame.moves_begin + getGeneratedIndex(frame, frame.next_move)];
+
+			if (!enterNode(child, !frame.is_whites_turn, frame.depth - 1, -frame.beta, -frame.alpha, &child_value)) {
+				has_child_value = true;
+			}
+		} else {
+			child_value = frame.value;
+			has_child_value = true;
+
+			finishFrame(frame);
+			m_children.resize(frame.moves_begin);
+			m_order.resize(frame.moves_begin);
+			m_frames.pop_back();
+
+			if (m_frames.empty()) {
+				has_child_value = false;
+			}
+		}
+	}
+
+	m_time_us += currentTimeUs() - m_step_start_us;
+
+	return m_finished;
+}
+
+
+bool ResumableSearch::isFinished() const {
+	return m_finished;
+}
+
+
+// returns the result of the deepest depth finished so far
+// the best move doesn't exist if no depth has been finished yet or the side to move has no moves
+SearchInfo ResumableSearch::getResult() const {
+	return m_result;
+}
+
+
+std::uint64_t ResumableSearch::getNodesSearched() const {
+	return m_nodes;
+}
+
+
+// pushes the root for the next depth, or finishes the search after the last one
+void ResumableSearch::startDepth() {
+	// as in Engine::search(), a game that is proven to end within the depth searched is never searched deeper
+	bool is_proven = m_depth > 0 && isDecidedScore(m_result.score) && getPliesToEnd(m_result.score) <= m_depth;
+
+	if (m_depth >= m_max_depth || (m_depth > 0 && m_root_moves.empty()) || is_proven) {
+		m_finished = true;
+		return;
+	}
+
+	m_depth++;
+
+	int value;
+	enterNode(m_board, m_is_whites_turn, m_depth, -INT_MAX, INT_MAX, &value);
+}
+
+
+// visits a node, returning true if it has a frame to search its children in
+// nodes decided straight away, by the evaluation or the transposition table, instead return false
+// with their score in value
+bool ResumableSearch::enterNode(const Bitboard &board, bool is_whites_turn, int depth, int alpha, int beta, int *value) {
+	m_nodes++;
+
+	const bool is_root = m_frames.empty();
+	const int ply = static_cast<int>(m_frames.size());
+
+	// repetitions are scored as draws, as in Engine::negamax()
+	int reversible_plies = 0;
+	if (!is_root && isReversibleMove(m_frames.back().board, board)) {
+		reversible_plies = m_frames.back().reversible_plies + 1;
+	}
+
+	const bool could_repeat = reversible_plies >= MIN_REPETITION_PLIES;
+	const u64 hash = (depth > 0 || could_repeat) ? hashBitboard(board, is_whites_turn) : 0;
+
+	if (could_repeat && isRepetition(hash, ply, reversible_plies)) {
+		*value = DRAW_SCORE;
+		return false;
+	}
+
+	// positions in the tablebases with fewer pieces than the root, or drawn, aren't searched, as in Engine::negamax()
+	// and neither are those where the side to move has already lost
+	const int num_pieces = popcount(board.black_pieces | board.white_pieces);
+	TablebaseValue tablebase_value = TB_UNKNOWN;
+
+	if (!is_root && num_pieces <= m_tablebase_pieces && !canMove(board, is_whites_turn)) {
+		*value = lossScore(ply);
+		return false;
+	}
+
+	if (!is_root && num_pieces <= m_tablebase_pieces && m_tablebases->probe(board, is_whites_turn, &tablebase_value)) {
+		m_tablebase_hits++;
+
+		if (num_pieces <= m_probe_pieces || tablebase_value == TB_DRAW) {
+			*value = getTablebaseScore(tablebase_value, board, is_whites_turn, ply);
+			return false;
+		}
+	}
+
+	if (depth == 0) {
+		*value = getKnownResultScore(tablebase_value, evaluateLeaf(board, is_whites_turn));
+		return false;
+	}
+
+	// mate distance pruning, as in Engine::negamax()
+	if (!is_root) {
+		alpha = std::max(alpha, lossScore(ply));
+		beta = std::min(beta, -lossScore(ply + 1));
+
+		if (alpha >= beta) {
+			*value = alpha;
+			return false;
+		}
+	}
+
+	int hash_move_index = TranspositionTable::NO_MOVE;
+
+	if (m_transposition_table != nullptr) {
+		TranspositionTable::Entry entry;
+
+		if (m_transposition_table->probe(hash, &entry)) {
+			hash_move_index = entry.best_move_index;
+			entry.score = scoreFromTable(entry.score, ply);
+
+			// the root always searches so that it has a move to return
+			if (!is_root && entry.depth >= depth
+					&& (entry.bound == TranspositionTable::EXACT
+					|| (entry.bound == TranspositionTable::LOWER && entry.score >= beta)
+					|| (entry.bound == TranspositionTable::UPPER && entry.score <= alpha))) {
+				*value = entry.score;
+				return false;
+			}
+		}
+	}
+
+	Frame frame;
+	frame.board = board;
+	frame.hash = hash;
+	frame.reversible_plies = reversible_plies;
+	frame.depth = depth;
+	frame.alpha = alpha;
+	frame.beta = beta;
+	frame.original_alpha = alpha;
+	frame.moves_begin = static_cast<int>(m_children.size());
+	frame.next_move = 0;
+	frame.best_generated_index = TranspositionTable::NO_MOVE;
+	frame.is_whites_turn = is_whites_turn;
+
+	m_children.resize(frame.moves_begin + MAX_MOVES);
+	frame.num_moves = generateMoves(board, is_whites_turn, &m_children[frame.moves_begin], nullptr);
+	m_children.resize(frame.moves_begin + frame.num_moves);
+	m_order.resize(m_children.size());
+
+	// with no moves the side to move has lost
+	frame.value = (frame.num_moves == 0) ? lossScore(ply) : -INT_MAX;
+
+	// the best move of the previous depth goes first at the root, as in Engine::search()
+	if (is_root) {
+		for (int i = 0; i < frame.num_moves; i++) {
+			if (m_root_moves[i] == m_root_first_move) {
+				hash_move_index = i;
+				break;
+			}
+		}
+	}
+
+	// the same order as Engine::negamax(), the hash move first and the rest by static exchange
+	int *order = m_order.data() + frame.moves_begin;
+	for (int i = 0; i < frame.num_moves; i++) {
+		order[i] = i;
+	}
+	if (hash_move_index < frame.num_moves) {
+		std::swap(order[0], order[hash_move_index]);
+	}
+
+	if (depth >= MIN_EXCHANGE_ORDERING_DEPTH) {
+		orderByExchange(board, is_whites_turn, m_children.data() + frame.moves_begin, order,
+			frame.num_moves, hash_move_index < frame.num_moves ? 1 : 0, m_eval_weights);
+	}
+	if (m_exchange_pruning && !is_root && depth <= MAX_EXCHANGE_PRUNING_DEPTH) {
+		frame.num_moves = pruneLosingMoves(board, is_whites_turn, m_children.data() + frame.moves_begin, order,
+			frame.num_moves, m_eval_weights);
+	}
+
+	m_frames.push_back(frame);
+
+	return true;
+}
+
+
+// stores the score of a frame whose children are all searched or that was cut off,
+// and records the result of the depth if it is the root
+void ResumableSearch::finishFrame(const Frame &frame) {
+	if (m_transposition_table != nullptr) {
+		TranspositionTable::Bound bound = TranspositionTable::EXACT;
+		if (frame.value <= frame.original_alpha) {
+			bound = TranspositionTable::UPPER;
+		} else if (frame.value >= frame.beta) {
+			bound = TranspositionTable::LOWER;
+		}
+
+		const int ply = static_cast<int>(m_frames.size()) - 1;
+		m_transposition_table->store(frame.hash, {scoreToTable(frame.value, ply), frame.depth, bound, frame.best_generated_index});
+	}
+
+	if (m_frames.size() == 1) {
+		CompactMove best_move;
+		if (frame.best_generated_index != TranspositionTable::NO_MOVE) {
+			best_move = m_root_moves[frame.best_generated_index];
+		}
+
+		m_result = SearchInfo {};
+		m_result.depth = m_depth;
+		m_result.score = frame.value;
+		m_result.nodes = m_nodes;
+		m_result.time_ms = (m_time_us + currentTimeUs() - m_step_start_us) / 1000;
+		m_result.best_move = best_move;
+		m_result.tablebase_hits = m_tablebase_hits;
+		m_root_first_move = best_move;
+	}
+}
+
+
+// maps a position in the search order to one in the generated order
+int ResumableSearch::getGeneratedIndex(const Frame &frame, int search_index) const {
+	return m_order[frame.moves_begin + search_index];
+}
+
+
+// returns true if the position with the given hash at ply has been reached before on the path from the root
+bool ResumableSearch::isRepetition(u64 hash, int ply, int reversible_plies) const {
+	for (int i = ply - MIN_REPETITION_PLIES; i >= ply - reversible_plies; i -= 2) {
+		if (m_frames[i].hash == hash) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// returns the static evaluation for the side to move
+// the network's accumulator is built from scratch at each leaf as there is no recursion to carry it down
+int ResumableSearch::evaluateLeaf(const Bitboard &board, bool is_whites_turn) const {
+	int value;
+
+	if (m_network != nullptr) {
+		NnueNetwork::Accumulator accumulator;
+		m_network->refreshAccumulator(board, &accumulator);
+		value = m_network->evaluate(accumulator);
+	} else {
+		value = evaluate(board, m_eval_weights);
+	}
+
+	const EndgameEvaluator endgame = findEndgameEvaluator(board);
+	if (endgame != nullptr) {
+		value = endgame(board, value);
+	}
+
+	return is_whites_turn ? -value : value;
+}
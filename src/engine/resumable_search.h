@@ -0,0 +1,90 @@
+#ifndef RESUMABLE_SEARCH_H
+#define RESUMABLE_SEARCH_H
+
+
+#include "engine/engine.h"
+#include "engine/compact_move.h"
+#include "engine/evaluation.h"
+#include "engine/nnue.h"
+#include "engine/tablebase_probe.h"
+#include "engine/transposition_table.h"
+#include "engine/bitboard.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+// an iterative deepening search that can be paused after any node and picked up again later,
+// possibly on another thread, so a scheduler can share a few threads between many searches
+//
+// it searches the same tree as Engine::search() but keeps its own stack of frames instead
+// of recursing, which holds the board, the window and how far through the moves each ply is
+// the children of every ply on the stack are kept in one buffer, so a paused search only
+// takes a few kilobytes
+//
+// create one with Engine::createResumableSearch()
+class ResumableSearch {
+public:
+	ResumableSearch(const Bitboard &board, bool is_whites_turn, int max_depth, const EvalWeights &weights,
+		bool exchange_pruning, std::shared_ptr<const NnueNetwork> network, std::shared_ptr<TranspositionTable> table,
+		std::shared_ptr<TablebaseProber> tablebases);
+
+	bool step(std::uint64_t node_budget);
+	bool isFinished() const;
+	SearchInfo getResult() const;
+	std::uint64_t getNodesSearched() const;
+
+private:
+	struct Frame {
+		Bitboard board;
+		u64 hash;
+		int reversible_plies; // since the last capture or man move
+		int depth;
+		int alpha;
+		int beta;
+		int original_alpha;
+		int value;
+		int moves_begin; // index of the first child in m_children
+		int num_moves; // left to search, which leaves out any that were pruned
+		int next_move; // in search order
+		int best_generated_index;
+		bool is_whites_turn;
+	};
+
+	void startDepth();
+	bool enterNode(const Bitboard &board, bool is_whites_turn, int depth, int alpha, int beta, int *value);
+	void finishFrame(const Frame &frame);
+	int getGeneratedIndex(const Frame &frame, int search_index) const;
+	int evaluateLeaf(const Bitboard &board, bool is_whites_turn) const;
+	bool isRepetition(u64 hash, int ply, int reversible_plies) const;
+
+	const Bitboard m_board;
+	const bool m_is_whites_turn;
+	const int m_max_depth;
+
+	EvalWeights m_eval_weights;
+	bool m_exchange_pruning;
+	std::shared_ptr<const NnueNetwork> m_network;
+	std::shared_ptr<TranspositionTable> m_transposition_table;
+	std::shared_ptr<TablebaseProber> m_tablebases;
+	int m_tablebase_pieces; // the most of any table
+	int m_probe_pieces; // as in Engine::searchMultiPv()
+
+	std::vector<Frame> m_frames; // the root is at the bottom
+	std::vector<Bitboard> m_children;
+	std::vector<int> m_order; // the search order of the children, indexes into the frame's part of m_children
+	std::vector<CompactMove> m_root_moves; // in generated order
+
+	int m_depth = 0; // depth of the iteration in progress
+	bool m_finished = false;
+	std::uint64_t m_nodes = 0;
+	std::uint64_t m_tablebase_hits = 0;
+	std::int64_t m_time_us = 0; // spent inside step(), not counting the time the search was paused
+	std::int64_t m_step_start_us = 0;
+	CompactMove m_root_first_move;
+	SearchInfo m_result {};
+};
+
+
+#endif // RESUMABLE_SEARCH_H
@@ -0,0 +1,83 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+
+// scores of won and lost positions count the plies to the end of the game, so the search
+// prefers the quickest win and the slowest loss
+// the side to move loses when it has no moves, which at ply scores -(WIN_SCORE - ply)
+// anything beyond MIN_WIN_SCORE either way is a decided game, the evaluation never gets near it
+constexpr int WIN_SCORE = 30000;
+constexpr int MIN_WIN_SCORE = WIN_SCORE - 1000;
+
+// a position the tablebases show to be won, though not how soon, scores between the decided scores
+// and anything the evaluation gives, less the ply it is found at so the search heads for the nearest one
+// wins with fewer pieces left over than the other side score lower still, by more than any difference in ply,
+// so that the search never gives material away just to reach a table sooner
+constexpr int TABLEBASE_WIN_SCORE = MIN_WIN_SCORE - 1;
+constexpr int MIN_TABLEBASE_WIN_SCORE = TABLEBASE_WIN_SCORE - 1000;
+constexpr int TABLEBASE_MATERIAL_STEP = 64; // per piece, more than the deepest ply of a search
+constexpr int MAX_TABLEBASE_MATERIAL = 7; // pieces counted either way, keeping the scores above MIN_TABLEBASE_WIN_SCORE
+
+// a leaf the tablebases show to be won but that has as many pieces as the root, so that the search has to
+// find the way to win it, scores its evaluation plus this, below the scores of reaching a smaller table
+constexpr int KNOWN_WIN_SCORE = MIN_TABLEBASE_WIN_SCORE / 2;
+constexpr int MAX_KNOWN_WIN_EVALUATION = KNOWN_WIN_SCORE / 2; // the evaluation added is kept within this either way
+constexpr int MIN_KNOWN_WIN_SCORE = KNOWN_WIN_SCORE - MAX_KNOWN_WIN_EVALUATION;
+
+// a repeated position is scored as a draw, as whichever side is better off could have avoided it
+constexpr int DRAW_SCORE = 0;
+
+
+inline int lossScore(int ply) {
+	return -WIN_SCORE + ply;
+}
+
+
+inline bool isDecidedScore(int score) {
+	return score >= MIN_WIN_SCORE || score <= -MIN_WIN_SCORE;
+}
+
+
+// returns true if the score is of a position the tablebases show to be won or lost, see TABLEBASE_WIN_SCORE
+inline bool isTablebaseScore(int score) {
+	return !isDecidedScore(score) && (score >= MIN_TABLEBASE_WIN_SCORE || score <= -MIN_TABLEBASE_WIN_SCORE);
+}
+
+
+// returns true if the score is of a position the tablebases show to be won or lost but that the search
+// hasn't yet found the way to a smaller table from, see KNOWN_WIN_SCORE
+inline bool isKnownResultScore(int score) {
+	return !isDecidedScore(score) && !isTablebaseScore(score)
+		&& (score >= MIN_KNOWN_WIN_SCORE || score <= -MIN_KNOWN_WIN_SCORE);
+}
+
+
+// returns the number of plies until the game ends in a decided score
+inline int getPliesToEnd(int score) {
+	return WIN_SCORE - (score >= 0 ? score : -score);
+}
+
+
+// the transposition table holds decided and tablebase scores counted from the position they belong to
+// rather than from the root, so they stay right when the position is reached at another ply
+inline int scoreToTable(int score, int ply) {
+	if (score >= MIN_TABLEBASE_WIN_SCORE) {
+		return score + ply;
+	} else if (score <= -MIN_TABLEBASE_WIN_SCORE) {
+		return score - ply;
+	}
+	return score;
+}
+
+
+inline int scoreFromTable(int score, int ply) {
+	if (score >= MIN_TABLEBASE_WIN_SCORE) {
+		return score - ply;
+	} else if (score <= -MIN_TABLEBASE_WIN_SCORE) {
+		return score + ply;
+	}
+	return score;
+}
+
+
+#endif // SCORE_H
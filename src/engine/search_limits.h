@@ -0,0 +1,27 @@
+#ifndef SEARCH_LIMITS_H
+#define SEARCH_LIMITS_H
+
+
+#include <atomic>
+#include <cstdint>
+
+
+// limits on a single call to Engine::findBestMove()
+// a value of zero means that limit isn't used
+// the search deepens one ply at a time and returns the best move of the last depth it finished
+struct SearchLimits {
+	int depth = 0; // plies to search, the engine's normal depth is used if zero and there are no other limits
+	std::uint64_t nodes = 0; // nodes to visit before stopping
+	int time_ms = 0; // time to search for
+	bool infinite = false; // ignore the other limits and search until stopped
+	int min_depth = 0; // depths up to this are always finished, whatever the node and time limits
+
+	// flags owned by the caller that another thread can set while the search is running
+	// stop ends the search, ponder makes it ignore the node and time limits and wait once it reaches
+	// its depth until ponder is cleared, after which the limits apply with time counted from the start
+	const std::atomic<bool> *stop = nullptr;
+	const std::atomic<bool> *ponder = nullptr;
+};
+
+
+#endif // SEARCH_LIMITS_H
@@ -0,0 +1,116 @@
+#include "engine/search_recorder.h"
+
+#include "engine/byte_order.h"
+
+#include <cstring>
+
+
+static constexpr char MAGIC[4] = {'C', 'K', 'S', 'T'};
+
+
+// opens path for writing, discarding any previous contents
+// returns false if the file could not be opened
+bool SearchRecorder::open(const std::string &path, int max_ply) {
+	close();
+
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file) {
+		return false;
+	}
+
+	unsigned char header[HEADER_SIZE] = {};
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	writeLittleEndian(header + 4, FORMAT_VERSION, 4);
+	writeLittleEndian(header + 8, max_ply, 4);
+	writeLittleEndian(header + 12, RECORD_SIZE, 4);
+	m_file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+
+	m_max_ply = max_ply;
+
+	return true;
+}
+
+
+void SearchRecorder::close() {
+	if (m_file.is_open()) {
+		m_file.close();
+	}
+	m_max_ply = -1;
+}
+
+
+bool SearchRecorder::isOpen() const {
+	return m_file.is_open();
+}
+
+
+void SearchRecorder::write(const SearchTreeNode &node) {
+	unsigned char record[RECORD_SIZE] = {};
+
+	writeLittleEndian(record + 0, node.hash, 8);
+	writeLittleEndian(record + 8, node.move.toBits(), 4);
+	writeLittleEndian(record + 12, static_cast<u32>(node.alpha), 4);
+	writeLittleEndian(record + 16, static_cast<u32>(node.beta), 4);
+	writeLittleEndian(record + 20, static_cast<u32>(node.score), 4);
+	writeLittleEndian(record + 24, node.subtree_nodes, 4);
+	writeLittleEndian(record + 28, node.subtree_time_us, 4);
+	record[32] = static_cast<unsigned char>(node.ply);
+	record[33] = static_cast<unsigned char>(node.depth);
+	record[34] = static_cast<unsigned char>(node.type);
+	record[35] = static_cast<unsigned char>(node.best_move_index);
+	record[36] = static_cast<unsigned char>(node.moves_searched);
+	record[37] = static_cast<unsigned char>(node.moves_available);
+	// bytes 38-39 are reserved
+
+	m_file.write(reinterpret_cast<const char*>(record), RECORD_SIZE);
+}
+
+
+// reads and validates the file header
+// returns false if the stream does not hold a search tree file of a supported version
+bool SearchRecorder::readHeader(std::istream &in, int *max_ply) {
+	unsigned char header[HEADER_SIZE];
+	if (!in.read(reinterpret_cast<char*>(header), HEADER_SIZE)) {
+		return false;
+	}
+
+	if (std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0
+			|| readLittleEndian(header + 4, 4) != FORMAT_VERSION
+			|| readLittleEndian(header + 12, 4) != RECORD_SIZE) {
+		return false;
+	}
+
+	*max_ply = static_cast<int>(readLittleEndian(header + 8, 4));
+
+	return true;
+}
+
+
+// reads the next node record
+SearchRecorder::ReadResult SearchRecorder::readNode(std::istream &in, SearchTreeNode *node) {
+	unsigned char record[RECORD_SIZE];
+	if (!in.read(reinterpret_cast<char*>(record), RECORD_SIZE)) {
+		return (in.gcount() == 0) ? END_OF_FILE : INVALID_RECORD;
+	}
+
+	// checked before the conversion, as a value outside the enum's range can't be stored in it
+	if (record[34] > SearchTreeNode::LEAF_NODE) {
+		return INVALID_RECORD;
+	}
+
+	node->hash = readLittleEndian(record + 0, 8);
+	node->move = CompactMove::fromBits(static_cast<u32>(readLittleEndian(record + 8, 4)));
+	node->alpha = static_cast<int>(static_cast<u32>(readLittleEndian(record + 12, 4)));
+	node->beta = static_cast<int>(static_cast<u32>(readLittleEndian(record + 16, 4)));
+	node->score = static_cast<int>(static_cast<u32>(readLittleEndian(record + 20, 4)));
+	node->subtree_nodes = static_cast<u32>(readLittleEndian(record + 24, 4));
+	node->subtree_time_us = static_cast<u32>(readLittleEndian(record + 28, 4));
+	node->ply = record[32];
+	node->depth = record[33];
+	node->type = static_cast<SearchTreeNode::Type>(record[34]);
+	node->best_move_index = record[35];
+	node->moves_searched = record[36];
+	node->moves_available = record[37];
+
+	return NODE_READ;
+}
@@ -0,0 +1,72 @@
+#ifndef SEARCH_RECORDER_H
+#define SEARCH_RECORDER_H
+
+
+#include "engine/bitboard.h"
+#include "engine/compact_move.h"
+
+#include <fstream>
+#include <istream>
+#include <string>
+
+
+// a single searched node
+// nodes are written once their subtree has been searched, so a parent always comes after its children
+struct SearchTreeNode {
+	enum Type {
+		PV_NODE, // score fell inside the window so it is exact
+		CUT_NODE, // score was at least beta
+		ALL_NODE, // score was at most alpha
+		LEAF_NODE, // score came from the static evaluation
+	};
+
+	static constexpr int NO_BEST_MOVE = 255;
+
+	u64 hash = 0;
+	CompactMove move; // the move leading to this node, blank for the root
+	int ply = 0;
+	int depth = 0;
+	int alpha = 0;
+	int beta = 0;
+	int score = 0;
+	Type type = LEAF_NODE;
+	int best_move_index = NO_BEST_MOVE; // position of the best move in search order
+	int moves_searched = 0;
+	int moves_available = 0;
+	u32 subtree_nodes = 0;
+	u32 subtree_time_us = 0;
+};
+
+
+// streams search tree nodes to a compact binary file, up to a maximum ply
+// file layout: a 16 byte header followed by fixed size little endian node records
+class SearchRecorder {
+public:
+	enum ReadResult {
+		NODE_READ,
+		END_OF_FILE,
+		INVALID_RECORD, // cut short or with an unknown node type, nothing after it is read
+	};
+
+	bool open(const std::string &path, int max_ply);
+	void close();
+	bool isOpen() const;
+	void write(const SearchTreeNode &node);
+
+	// returns true if nodes at this ply should be recorded
+	bool isRecording(int ply) const { return ply <= m_max_ply; }
+
+	static bool readHeader(std::istream &in, int *max_ply);
+	static ReadResult readNode(std::istream &in, SearchTreeNode *node);
+
+	static constexpr int HEADER_SIZE = 16;
+	static constexpr int RECORD_SIZE = 40;
+	static constexpr int FORMAT_VERSION = 1;
+
+private:
+	std::ofstream m_file;
+	int m_max_ply = -1;
+};
+
+
+#endif // SEARCH_RECORDER_H
@@ -0,0 +1,58 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+
+#include <atomic>
+#include <cstddef>
+
+
+// a fixed size queue for passing items from one thread to one other thread without locking
+// neither side ever waits: push() fails when the queue is full and pop() when it is empty
+// CAPACITY must be a power of two
+template <typename T, std::size_t CAPACITY>
+class SpscQueue {
+	static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+public:
+	// called only by the producer
+	bool push(const T &item) {
+		std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) {
+			return false;
+		}
+
+		m_items[tail & (CAPACITY - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// called only by the consumer
+	bool pop(T *item) {
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+
+		if (head == m_tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		*item = m_items[head & (CAPACITY - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+private:
+	static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+	// the counters only ever increase, and are padded apart so the two threads don't keep
+	// taking the same cache line from each other
+	std::atomic<std::size_t> m_head {0}; // next item to pop
+	char m_head_padding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+	std::atomic<std::size_t> m_tail {0}; // next slot to push into
+	char m_tail_padding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+	T m_items[CAPACITY];
+};
+
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,125 @@
+#include "engine/static_exchange.h"
+
+#include "engine/bitboard_movegen.h"
+
+#include <algorithm> // for std::max
+#include <climits>
+
+
+// captures further into an exchange than this are left out, long exchanges are rare and slow to play out
+static constexpr int MAX_EXCHANGE_PLIES = 8;
+
+
+// returns true if the move from before to after took any pieces
+static bool isCapture(const Bitboard &before, const Bitboard &after) {
+	return popcount(before.black_pieces | before.white_pieces) != popcount(after.black_pieces | after.white_pieces);
+}
+
+
+// returns the material of the side to move less that of the other side, valued by the evaluation's piece weights
+static int getMaterialBalance(const Bitboard &board, bool is_whites_turn, const EvalWeights &weights) {
+	const u32 my_pieces = is_whites_turn ? board.white_pieces : board.black_pieces;
+	const u32 their_pieces = is_whites_turn ? board.black_pieces : board.white_pieces;
+
+	const int man_value = weights.values[EVAL_MAN];
+	const int king_value = weights.values[EVAL_KING];
+
+	return (popcount(my_pieces & ~board.king_pieces) - popcount(their_pieces & ~board.king_pieces)) * man_value
+		+ (popcount(my_pieces & board.king_pieces) - popcount(their_pieces & board.king_pieces)) * king_value;
+}
+
+
+// plays out the captures forced from board, each side picking the one that leaves it with the most material,
+// and returns the material balance for the side to move once a side has no capture
+// only the best line matters, so lines that can't change the result are cut off as in quiescence()
+static int resolveCaptures(const Bitboard &board, bool is_whites_turn, int alpha, int beta, int plies_left,
+		const EvalWeights &weights) {
+	if (plies_left == 0 || !canJump(board, is_whites_turn)) {
+		return getMaterialBalance(board, is_whites_turn, weights);
+	}
+
+	Bitboard next_positions[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, nullptr);
+
+	int value = -INT_MAX;
+
+	for (int i = 0; i < moves_found; i++) {
+		value = std::max(value,
+			-resolveCaptures(next_positions[i], !is_whites_turn, -beta, -alpha, plies_left - 1, weights));
+		alpha = std::max(alpha, value);
+
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	return value;
+}
+
+
+// returns the material a move wins, or loses if negative, once the captures it forces have been played out
+// before and after are the positions either side of the move, which includes any pieces it captured itself
+// only material is counted, so a move that gives up a man to crown a king is worth the difference
+int staticExchange(const Bitboard &before, const Bitboard &after, bool is_whites_move, const EvalWeights &weights) {
+	return -resolveCaptures(after, !is_whites_move, -INT_MAX, INT_MAX, MAX_EXCHANGE_PLIES, weights)
+		- getMaterialBalance(before, is_whites_move, weights);
+}
+
+
+// returns true if the static exchange of a move is negative
+// this only needs a null window, so it is quicker than working out what the exchange comes to
+bool losesMaterial(const Bitboard &before, const Bitboard &after, bool is_whites_move, const EvalWeights &weights) {
+	if (!canJump(after, !is_whites_move)) {
+		return false; // a quiet move with nothing to take back only changes the material by crowning
+	}
+
+	// the move loses material if the other side ends up better off than it was before the move
+	const int their_balance = -getMaterialBalance(before, is_whites_move, weights);
+	return resolveCaptures(after, !is_whites_move, their_balance, their_balance + 1, MAX_EXCHANGE_PLIES, weights)
+		> their_balance;
+}
+
+
+// sorts the moves in order, which holds indexes into next_positions, by their static exchange, best first
+// the first num_fixed moves, such as a hash move, are left where they are
+void orderByExchange(const Bitboard &board, bool is_whites_turn, const Bitboard *next_positions,
+		int *order, int num_moves, int num_fixed, const EvalWeights &weights) {
+	int exchange[MAX_MOVES];
+	for (int i = num_fixed; i < num_moves; i++) {
+		exchange[i] = staticExchange(board, next_positions[order[i]], is_whites_turn, weights);
+	}
+
+	// insertion sort, as there are only a handful of moves and it keeps equal moves in generated order
+	for (int i = num_fixed + 1; i < num_moves; i++) {
+		const int index = order[i];
+		const int value = exchange[i];
+
+		int j = i;
+		for (; j > num_fixed && exchange[j - 1] < value; j--) {
+			order[j] = order[j - 1];
+			exchange[j] = exchange[j - 1];
+		}
+		order[j] = index;
+		exchange[j] = value;
+	}
+}
+
+
+// drops the quiet moves that lose material from order, keeping the rest in the same order
+// the first move is always kept so the node still gets a score, and captures are never dropped as they're forced
+// returns the number of moves left to search
+int pruneLosingMoves(const Bitboard &board, bool is_whites_turn, const Bitboard *next_positions,
+		int *order, int num_moves, const EvalWeights &weights) {
+	if (num_moves == 0 || isCapture(board, next_positions[0])) {
+		return num_moves;
+	}
+
+	int moves_kept = 1;
+	for (int i = 1; i < num_moves; i++) {
+		if (!losesMaterial(board, next_positions[order[i]], is_whites_turn, weights)) {
+			order[moves_kept++] = order[i];
+		}
+	}
+
+	return moves_kept;
+}
@@ -0,0 +1,25 @@
+#ifndef STATIC_EXCHANGE_H
+#define STATIC_EXCHANGE_H
+
+
+#include "engine/evaluation.h"
+#include "engine/bitboard.h"
+
+
+// moves are ordered by their static exchange at nodes at least this far from the leaves,
+// any closer and working it out costs more than the better order saves
+constexpr int MIN_EXCHANGE_ORDERING_DEPTH = 3;
+
+// quiet moves that lose material aren't searched at nodes this close to the leaves
+constexpr int MAX_EXCHANGE_PRUNING_DEPTH = 1;
+
+
+int staticExchange(const Bitboard &before, const Bitboard &after, bool is_whites_move, const EvalWeights &weights);
+bool losesMaterial(const Bitboard &before, const Bitboard &after, bool is_whites_move, const EvalWeights &weights);
+void orderByExchange(const Bitboard &board, bool is_whites_turn, const Bitboard *next_positions,
+	int *order, int num_moves, int num_fixed, const EvalWeights &weights);
+int pruneLosingMoves(const Bitboard &board, bool is_whites_turn, const Bitboard *next_positions,
+	int *order, int num_moves, const EvalWeights &weights);
+
+
+#endif // STATIC_EXCHANGE_H
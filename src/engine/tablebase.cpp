@@ -0,0 +1,527 @@
+#include "engine/tablebase.h"
+
+#include "engine/bitboard_masks.h"
+#include "engine/byte_order.h"
+
+#include <algorithm> // for std::min
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+
+static constexpr char MAGIC[4] = {'C', 'K', 'T', 'B'};
+static constexpr int FORMAT_VERSION = 2;
+static constexpr int HEADER_SIZE = 16;
+static constexpr int OFFSET_SIZE = 4;
+
+// lengths the run length encoding can hold in its control byte
+static constexpr int MIN_REPEAT = 3;
+static constexpr int MAX_REPEAT = 130;
+static constexpr int MAX_LITERALS = 128;
+
+static constexpr int MAX_PIECES_PER_SIDE = 12;
+static constexpr int NUM_SQUARES = 32;
+
+// men never stand on the row where they would be crowned
+static constexpr u32 black_men_squares = ~black_crown_row;
+static constexpr u32 white_men_squares = ~white_crown_row;
+static constexpr int NUM_MEN_SQUARES = 28;
+
+
+// binomial[n][k] is n choose k, the number of ways to place k pieces of one kind on n squares
+struct BinomialTable {
+	u64 values[NUM_SQUARES + 1][MAX_PIECES_PER_SIDE + 1];
+
+	BinomialTable() {
+		for (int n = 0; n <= NUM_SQUARES; n++) {
+			values[n][0] = 1;
+			for (int k = 1; k <= MAX_PIECES_PER_SIDE; k++) {
+				values[n][k] = (n == 0) ? 0 : values[n - 1][k - 1] + values[n - 1][k];
+			}
+		}
+	}
+};
+
+static const BinomialTable binomial;
+
+
+bool MaterialSignature::operator==(const MaterialSignature &other) const {
+	return black_men == other.black_men && black_kings == other.black_kings
+		&& white_men == other.white_men && white_kings == other.white_kings;
+}
+
+
+bool MaterialSignature::operator!=(const MaterialSignature &other) const {
+	return !(*this == other);
+}
+
+
+MaterialSignature getMaterialSignature(const Bitboard &board) {
+	return {
+		popcount(board.black_pieces & ~board.king_pieces),
+		popcount(board.black_pieces & board.king_pieces),
+		popcount(board.white_pieces & ~board.king_pieces),
+		popcount(board.white_pieces & board.king_pieces),
+	};
+}
+
+
+// returns the signature with the colours swapped, the one the positions of signature are in with white to move
+MaterialSignature getFlippedSignature(const MaterialSignature &signature) {
+	return {signature.white_men, signature.white_kings, signature.black_men, signature.black_kings};
+}
+
+
+int getNumPieces(const MaterialSignature &signature) {
+	return signature.black_men + signature.black_kings + signature.white_men + signature.white_kings;
+}
+
+
+// returns a number that is different for every signature, one byte for each kind of piece
+int getSignatureKey(const MaterialSignature &signature) {
+	return signature.black_men | (signature.black_kings << 8) | (signature.white_men << 16) | (signature.white_kings << 24);
+}
+
+
+// returns a name like "mmkvk" for two men and a king against a king, black's pieces first
+std::string getSignatureName(const MaterialSignature &signature) {
+	return std::string(signature.black_men, 'm') + std::string(signature.black_kings, 'k') + 'v'
+		+ std::string(signature.white_men, 'm') + std::string(signature.white_kings, 'k');
+}
+
+
+// the inverse of getSignatureName()
+// returns false if name isn't the name of a signature
+bool parseSignatureName(const std::string &name, MaterialSignature *signature) {
+	int counts[4] = {};
+	int side = 0;
+
+	for (char c : name) {
+		if (c == 'v' && side == 0) {
+			side = 2;
+		} else if ((c == 'm' && counts[side + 1] == 0) || c == 'k') {
+			counts[side + (c == 'k')]++;
+		} else {
+			return false;
+		}
+	}
+
+	*signature = {counts[0], counts[1], counts[2], counts[3]};
+
+	return side == 2 && counts[0] + counts[1] > 0 && counts[2] + counts[3] > 0
+		&& counts[0] + counts[1] <= MAX_PIECES_PER_SIDE && counts[2] + counts[3] <= MAX_PIECES_PER_SIDE;
+}
+
+
+// returns every signature with up to max_pieces pieces and at least one piece on each side,
+// in an order where each signature comes after all those its moves can lead to except its flipped signature
+// captures lead to fewer pieces and crowning to fewer men, so it goes by pieces and then by men
+std::vector<MaterialSignature> getSignaturesInOrder(int max_pieces) {
+	std::vector<MaterialSignature> signatures;
+
+	for (int pieces = 2; pieces <= max_pieces; pieces++) {
+		for (int men = 0; men <= pieces; men++) {
+			for (int black_men = 0; black_men <= men; black_men++) {
+				const int white_men = men - black_men;
+
+				for (int black_kings = 0; black_kings <= pieces - men; black_kings++) {
+					const int white_kings = pieces - men - black_kings;
+
+					if (black_men + black_kings == 0 || white_men + white_kings == 0
+							|| black_men + black_kings > MAX_PIECES_PER_SIDE
+							|| white_men + white_kings > MAX_PIECES_PER_SIDE) {
+						continue;
+					}
+
+					signatures.push_back({black_men, black_kings, white_men, white_kings});
+				}
+			}
+		}
+	}
+
+	return signatures;
+}
+
+
+// returns the signatures of the tables holding the positions reached by a move from signature,
+// which have white to move and so are looked up flipped
+// a move can crown one man and capture any number of pieces, the positions where white has no
+// pieces left aren't in a table and are left out
+std::vector<MaterialSignature> getSuccessorSignatures(const MaterialSignature &signature) {
+	std::vector<MaterialSignature> successors;
+
+	for (int crowned = 0; crowned <= (signature.black_men > 0 ? 1 : 0); crowned++) {
+		for (int men_taken = 0; men_taken <= signature.white_men; men_taken++) {
+			for (int kings_taken = 0; kings_taken <= signature.white_kings; kings_taken++) {
+				const int white_men = signature.white_men - men_taken;
+				const int white_kings = signature.white_kings - kings_taken;
+
+				if (white_men + white_kings == 0) {
+					continue;
+				}
+
+				successors.push_back({white_men, white_kings,
+					signature.black_men - crowned, signature.black_kings + crowned});
+			}
+		}
+	}
+
+	return successors;
+}
+
+
+// rotates the board half a turn and swaps the colours, so a position with white to move becomes
+// the same position with black to move
+// the squares are numbered along the rows, so the rotation just reverses the order of the bits
+Bitboard flipBoard(const Bitboard &board) {
+	auto reverse = [](u32 bits) {
+		bits = ((bits >> 1) & 0x5555'5555) | ((bits & 0x5555'5555) << 1);
+		bits = ((bits >> 2) & 0x3333'3333) | ((bits & 0x3333'3333) << 2);
+		bits = ((bits >> 4) & 0x0f0f'0f0f) | ((bits & 0x0f0f'0f0f) << 4);
+		bits = ((bits >> 8) & 0x00ff'00ff) | ((bits & 0x00ff'00ff) << 8);
+		return (bits >> 16) | (bits << 16);
+	};
+
+	return {reverse(board.white_pieces), reverse(board.black_pieces), reverse(board.king_pieces)};
+}
+
+
+// returns the index of a placement of pieces among the squares in allowed
+// in the combinatorial number system: the i-th piece, counting from one, on the n-th allowed square adds n choose i
+static u64 rankSquares(u32 pieces, u32 allowed) {
+	u64 rank = 0;
+
+	for (int i = 1; pieces; i++) {
+		const u32 piece = pieces & (~pieces + 1);
+		rank += binomial.values[popcount(allowed & (piece - 1))][i];
+		pieces &= pieces - 1;
+	}
+
+	return rank;
+}
+
+
+// the inverse of rankSquares(), places count pieces on the squares in allowed
+static u32 unrankSquares(u64 rank, int count, u32 allowed) {
+	u32 pieces = 0;
+	int limit = popcount(allowed);
+
+	for (int i = count; i >= 1; i--) {
+		// the highest allowed square whose binomial still fits in what is left of the rank
+		int n = limit - 1;
+		while (binomial.values[n][i] > rank) {
+			n--;
+		}
+		rank -= binomial.values[n][i];
+		limit = n;
+
+		u32 square = allowed;
+		for (int j = 0; j < n; j++) {
+			square &= square - 1;
+		}
+		pieces |= square & (~square + 1);
+	}
+
+	return pieces;
+}
+
+
+// the number of indexes in the table of signature
+// the men of each side are placed on their 28 squares independently, so the indexes where they
+// overlap don't stand for a position, the kings are placed on the squares the men leave free
+u64 getTableSize(const MaterialSignature &signature) {
+	const int free_squares = NUM_SQUARES - signature.black_men - signature.white_men;
+
+	return binomial.values[NUM_MEN_SQUARES][signature.black_men]
+		* binomial.values[NUM_MEN_SQUARES][signature.white_men]
+		* binomial.values[free_squares][signature.black_kings]
+		* binomial.values[free_squares - signature.black_kings][signature.white_kings];
+}
+
+
+// returns the index of board, with black to move, in the table of signature, which must be the board's own
+u64 getTableIndex(const MaterialSignature &signature, const Bitboard &board) {
+	const u32 black_men = board.black_pieces & ~board.king_pieces;
+	const u32 white_men = board.white_pieces & ~board.king_pieces;
+	const u32 black_kings = board.black_pieces & board.king_pieces;
+	const u32 white_kings = board.white_pieces & board.king_pieces;
+	const u32 free_squares = ~(black_men | white_men);
+	const int num_free_squares = NUM_SQUARES - signature.black_men - signature.white_men;
+
+	u64 index = rankSquares(black_men, black_men_squares);
+	index = index * binomial.values[NUM_MEN_SQUARES][signature.white_men] + rankSquares(white_men, white_men_squares);
+	index = index * binomial.values[num_free_squares][signature.black_kings] + rankSquares(black_kings, free_squares);
+	index = index * binomial.values[num_free_squares - signature.black_kings][signature.white_kings]
+		+ rankSquares(white_kings, free_squares & ~black_kings);
+
+	return index;
+}
+
+
+// the inverse of getTableIndex()
+// returns false if the index doesn't stand for a position as the men of both sides overlap
+bool getTablePosition(const MaterialSignature &signature, u64 index, Bitboard *board) {
+	const int num_free_squares = NUM_SQUARES - signature.black_men - signature.white_men;
+	const u64 num_white_kings = binomial.values[num_free_squares - signature.black_kings][signature.white_kings];
+	const u64 num_black_kings = binomial.values[num_free_squares][signature.black_kings];
+	const u64 num_white_men = binomial.values[NUM_MEN_SQUARES][signature.white_men];
+
+	const u64 white_kings_rank = index % num_white_kings;
+	index /= num_white_kings;
+	const u64 black_kings_rank = index % num_black_kings;
+	index /= num_black_kings;
+	const u64 white_men_rank = index % num_white_men;
+	const u64 black_men_rank = index / num_white_men;
+
+	const u32 black_men = unrankSquares(black_men_rank, signature.black_men, black_men_squares);
+	const u32 white_men = unrankSquares(white_men_rank, signature.white_men, white_men_squares);
+
+	if (black_men & white_men) {
+		return false;
+	}
+
+	const u32 free_squares = ~(black_men | white_men);
+	const u32 black_kings = unrankSquares(black_kings_rank, signature.black_kings, free_squares);
+	const u32 white_kings = unrankSquares(white_kings_rank, signature.white_kings, free_squares & ~black_kings);
+
+	board->black_pieces = black_men | black_kings;
+	board->white_pieces = white_men | white_kings;
+	board->king_pieces = black_kings | white_kings;
+
+	return true;
+}
+
+
+// the number of ways to place num_men men of one side
+u64 getMenPlacements(int num_men) {
+	return binomial.values[NUM_MEN_SQUARES][num_men];
+}
+
+
+// returns the placement of a side's men among those getMenSquares() numbers
+u64 getMenPlacement(u32 men, bool is_white) {
+	return rankSquares(men, is_white ? white_men_squares : black_men_squares);
+}
+
+
+// returns the squares of num_men men of one side in a placement from 0 to getMenPlacements() - 1
+u32 getMenSquares(int num_men, u64 placement, bool is_white) {
+	return unrankSquares(placement, num_men, is_white ? white_men_squares : black_men_squares);
+}
+
+
+// the number of ways to place the kings of signature around the men
+u64 getKingPlacements(const MaterialSignature &signature) {
+	const int free_squares = NUM_SQUARES - signature.black_men - signature.white_men;
+
+	return binomial.values[free_squares][signature.black_kings]
+		* binomial.values[free_squares - signature.black_kings][signature.white_kings];
+}
+
+
+std::string getTablePath(const std::string &directory, const MaterialSignature &signature) {
+	return directory + "/" + getSignatureName(signature) + ".cktb";
+}
+
+
+static u64 getNumBlocks(const MaterialSignature &signature) {
+	return ((getTableSize(signature) + 3) / 4 + TABLE_BLOCK_SIZE - 1) / TABLE_BLOCK_SIZE;
+}
+
+
+// returns the bytes of packed values in block, all blocks are full size except perhaps the last
+static int getBlockSize(const MaterialSignature &signature, u64 block) {
+	const u64 packed_size = (getTableSize(signature) + 3) / 4;
+	return static_cast<int>(std::min<u64>(TABLE_BLOCK_SIZE, packed_size - block * TABLE_BLOCK_SIZE));
+}
+
+
+// gives the indexes that aren't a position the value of the position before them, which makes
+// the runs of equal bytes the compression relies on as long as they can be
+static void fillGaps(std::vector<unsigned char> *values, u64 size) {
+	unsigned char previous = TB_DRAW;
+
+	for (u64 index = 0; index < size; index++) {
+		const int shift = (index & 3) * 2;
+		unsigned char &byte = (*values)[index >> 2];
+
+		if (((byte >> shift) & 3) == TB_UNKNOWN) {
+			byte |= previous << shift;
+		} else {
+			previous = (byte >> shift) & 3;
+		}
+	}
+}
+
+
+// run length encodes bytes: each run starts with a control byte c, below 128 for c + 1 bytes copied
+// as they are, otherwise for the next byte repeated c - 125 times
+static void compressBlock(const unsigned char *bytes, int size, std::vector<unsigned char> *output) {
+	int i = 0;
+
+	while (i < size) {
+		int run = 1;
+		while (i + run < size && run < MAX_REPEAT && bytes[i + run] == bytes[i]) {
+			run++;
+		}
+
+		if (run >= MIN_REPEAT) {
+			output->push_back(static_cast<unsigned char>(run + 125));
+			output->push_back(bytes[i]);
+			i += run;
+			continue;
+		}
+
+		// copy bytes until the next run worth encoding
+		int literals = 0;
+		while (i + literals < size && literals < MAX_LITERALS) {
+			const unsigned char byte = bytes[i + literals];
+			if (i + literals + MIN_REPEAT <= size && bytes[i + literals + 1] == byte && bytes[i + literals + 2] == byte) {
+				break;
+			}
+			literals++;
+		}
+
+		output->push_back(static_cast<unsigned char>(literals - 1));
+		output->insert(output->end(), bytes + i, bytes + i + literals);
+		i += literals;
+	}
+}
+
+
+// the inverse of compressBlock(), returns false unless data decompresses to exactly size bytes
+static bool decompressBlock(const unsigned char *data, std::size_t data_size, unsigned char *bytes, int size) {
+	std::size_t in = 0;
+	int out = 0;
+
+	while (in < data_size) {
+		const int control = data[in++];
+
+		if (control < 128) {
+			const int literals = control + 1;
+			if (in + literals > data_size || out + literals > size) {
+				return false;
+			}
+			std::memcpy(bytes + out, data + in, literals);
+			in += literals;
+			out += literals;
+		} else {
+			const int run = control - 125;
+			if (in >= data_size || out + run > size) {
+				return false;
+			}
+			std::memset(bytes + out, data[in++], run);
+			out += run;
+		}
+	}
+
+	return out == size;
+}
+
+
+// writes a table of packed values
+// file layout: a 16 byte header with the signature and the number of blocks, the little endian
+// offset from the start of the file of each compressed block and one past the last, then the blocks
+// returns false if the file could not be written
+bool saveTable(const std::string &path, const MaterialSignature &signature, const std::vector<unsigned char> &values) {
+	const u64 num_blocks = getNumBlocks(signature);
+
+	std::vector<unsigned char> filled = values;
+	fillGaps(&filled, getTableSize(signature));
+
+	std::vector<unsigned char> blocks;
+	std::vector<unsigned char> offsets((num_blocks + 1) * OFFSET_SIZE);
+	const u64 blocks_start = HEADER_SIZE + offsets.size();
+
+	for (u64 block = 0; block < num_blocks; block++) {
+		writeLittleEndian(&offsets[block * OFFSET_SIZE], blocks_start + blocks.size(), OFFSET_SIZE);
+		compressBlock(&filled[block * TABLE_BLOCK_SIZE], getBlockSize(signature, block), &blocks);
+	}
+	writeLittleEndian(&offsets[num_blocks * OFFSET_SIZE], blocks_start + blocks.size(), OFFSET_SIZE);
+
+	if (blocks_start + blocks.size() > UINT32_MAX) {
+		return false; // too big for the offsets
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	unsigned char header[HEADER_SIZE] = {};
+	std::memcpy(header, MAGIC, sizeof(MAGIC));
+	writeLittleEndian(header + 4, FORMAT_VERSION, 4);
+	writeLittleEndian(header + 8, static_cast<u32>(getSignatureKey(signature)), 4);
+	writeLittleEndian(header + 12, num_blocks, 4);
+
+	file.write(reinterpret_cast<const char*>(header), HEADER_SIZE);
+	file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size());
+	file.write(reinterpret_cast<const char*>(blocks.data()), blocks.size());
+	file.close();
+
+	return !file.fail();
+}
+
+
+// reads all the packed values of a table written by saveTable()
+// returns false if the file could not be read or isn't the table of signature
+bool loadTable(const std::string &path, const MaterialSignature &signature, std::vector<unsigned char> *values) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (!checkTableFile(contents.data(), contents.size(), signature)) {
+		return false;
+	}
+
+	values->resize((getTableSize(signature) + 3) / 4);
+
+	for (u64 block = 0; block < getNumBlocks(signature); block++) {
+		if (!readTableBlock(contents.data(), signature, block, values->data() + block * TABLE_BLOCK_SIZE)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// returns true if file holds the table of signature, with offsets that all lie inside it
+bool checkTableFile(const unsigned char *file, std::size_t file_size, const MaterialSignature &signature) {
+	const u64 num_blocks = getNumBlocks(signature);
+	const u64 blocks_start = HEADER_SIZE + (num_blocks + 1) * OFFSET_SIZE;
+
+	if (file_size < blocks_start
+			|| std::memcmp(file, MAGIC, sizeof(MAGIC)) != 0
+			|| readLittleEndian(file + 4, 4) != FORMAT_VERSION
+			|| readLittleEndian(file + 8, 4) != static_cast<u32>(getSignatureKey(signature))
+			|| readLittleEndian(file + 12, 4) != num_blocks) {
+		return false;
+	}
+
+	u64 previous = blocks_start;
+	for (u64 block = 0; block <= num_blocks; block++) {
+		const u64 offset = readLittleEndian(file + HEADER_SIZE + block * OFFSET_SIZE, OFFSET_SIZE);
+		if (offset < previous || offset > file_size) {
+			return false;
+		}
+		previous = offset;
+	}
+
+	return true;
+}
+
+
+// decompresses a block of a file that passed checkTableFile() into values, which must have room for TABLE_BLOCK_SIZE bytes
+// returns false if the block is corrupt
+bool readTableBlock(const unsigned char *file, const MaterialSignature &signature, u64 block, unsigned char *values) {
+	const unsigned char *offset = file + HEADER_SIZE + block * OFFSET_SIZE;
+	const u64 begin = readLittleEndian(offset, OFFSET_SIZE);
+	const u64 end = readLittleEndian(offset + OFFSET_SIZE, OFFSET_SIZE);
+
+	return decompressBlock(file + begin, end - begin, values, getBlockSize(signature, block));
+}
@@ -0,0 +1,81 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+
+#include "engine/bitboard.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// the result of a tablebase position for the side to move, each fits in two bits
+enum TablebaseValue {
+	TB_UNKNOWN,
+	TB_LOSS,
+	TB_DRAW,
+	TB_WIN,
+};
+
+
+// the number of each kind of piece on the board
+// every position of a signature is in one table, which only holds the positions with black to move:
+// a position with white to move is looked up as the position rotated half a turn with the colours
+// swapped, which is in the table of the flipped signature
+struct MaterialSignature {
+	int black_men;
+	int black_kings;
+	int white_men;
+	int white_kings;
+
+	bool operator==(const MaterialSignature &other) const;
+	bool operator!=(const MaterialSignature &other) const;
+};
+
+
+MaterialSignature getMaterialSignature(const Bitboard &board);
+MaterialSignature getFlippedSignature(const MaterialSignature &signature);
+int getNumPieces(const MaterialSignature &signature);
+int getSignatureKey(const MaterialSignature &signature);
+std::string getSignatureName(const MaterialSignature &signature);
+bool parseSignatureName(const std::string &name, MaterialSignature *signature);
+std::vector<MaterialSignature> getSignaturesInOrder(int max_pieces);
+std::vector<MaterialSignature> getSuccessorSignatures(const MaterialSignature &signature);
+
+Bitboard flipBoard(const Bitboard &board);
+
+u64 getTableSize(const MaterialSignature &signature);
+u64 getTableIndex(const MaterialSignature &signature, const Bitboard &board);
+bool getTablePosition(const MaterialSignature &signature, u64 index, Bitboard *board);
+
+// the men make up the most significant part of an index: the placement of black's men times the
+// number of placements of white's men plus that of white's, so the positions with the same men take up
+// a run of getKingPlacements() indexes
+u64 getMenPlacements(int num_men);
+u64 getMenPlacement(u32 men, bool is_white);
+u32 getMenSquares(int num_men, u64 placement, bool is_white);
+u64 getKingPlacements(const MaterialSignature &signature);
+
+
+// a table's values are packed four to a byte, the first position in the lowest two bits
+// indexes that aren't a position hold TB_UNKNOWN while a table is built, and once it is saved
+// whatever value compresses best
+inline TablebaseValue getPackedValue(const unsigned char *values, u64 index) {
+	return static_cast<TablebaseValue>((values[index >> 2] >> ((index & 3) * 2)) & 3);
+}
+
+
+// the files are compressed a block of packed values at a time, so a probe only has to decompress
+// the block holding its position
+constexpr int TABLE_BLOCK_SIZE = 1024;
+constexpr int POSITIONS_PER_BLOCK = TABLE_BLOCK_SIZE * 4;
+
+
+std::string getTablePath(const std::string &directory, const MaterialSignature &signature);
+bool saveTable(const std::string &path, const MaterialSignature &signature, const std::vector<unsigned char> &values);
+bool loadTable(const std::string &path, const MaterialSignature &signature, std::vector<unsigned char> *values);
+bool checkTableFile(const unsigned char *file, std::size_t file_size, const MaterialSignature &signature);
+bool readTableBlock(const unsigned char *file, const MaterialSignature &signature, u64 block, unsigned char *values);
+
+
+#endif // TABLEBASE_H
@@ -0,0 +1,563 @@
+#include "engine/tablebase_generator.h"
+
+#include "engine/bitboard_movegen.h"
+#include "engine/bitboard_unmovegen.h"
+
+#include <algorithm> // for std::min, std::max
+#include <cstdio> // for std::rename, std::remove
+#include <thread>
+
+
+// returns how far men have come from the rows they start on, a row for every move
+static int getProgress(u32 men, bool is_white) {
+	int progress = 0;
+
+	for (; men; men &= men - 1) {
+		const int row = lsbIndex(men) / 4;
+		progress += is_white ? 7 - row : row;
+	}
+
+	return progress;
+}
+
+
+// writes a table under another name and only gives it its own once it reads back the same,
+// so a table file that exists is always complete
+static bool saveCheckedTable(const std::string &path, const MaterialSignature &signature,
+		const std::vector<unsigned char> &values) {
+	const std::string temporary_path = path + ".tmp";
+	std::vector<unsigned char> saved_values;
+
+	if (!saveTable(temporary_path, signature, values)
+			|| !loadTable(temporary_path, signature, &saved_values)) {
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	// the indexes that aren't a position may have been filled in
+	for (u64 index = 0; index < getTableSize(signature); index++) {
+		const TablebaseValue value = getPackedValue(values.data(), index);
+		if (value != TB_UNKNOWN && value != getPackedValue(saved_values.data(), index)) {
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+
+// num_threads defaults to the number of cores
+// the tables are written to directory, where the tables their moves lead to must already be
+TablebaseGenerator::TablebaseGenerator(const std::string &directory, int num_threads) :
+	m_directory(directory),
+	m_num_threads(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+
+// writes the tables of signature and its flipped signature, stats are for signature
+// returns false if a table a move leads to is missing or a table could not be written
+bool TablebaseGenerator::generate(const MaterialSignature &signature, TablebaseStats *stats) {
+	start(signature);
+
+	for (int level = getNumLevels(m_signature) - 1; level >= 0; level--) {
+		if (!solveSlice(level, 0, 1)) {
+			m_tables.clear();
+			m_successors.clear();
+			return false;
+		}
+	}
+
+	return finish(stats);
+}
+
+
+// sets up the tables of signature and its flipped signature with nothing solved
+void TablebaseGenerator::start(const MaterialSignature &signature) {
+	m_signature = signature;
+	m_tables.clear();
+	m_successors.clear();
+	m_successors_loaded = false;
+	m_passes = 0;
+
+	const MaterialSignature flipped = getFlippedSignature(signature);
+
+	for (const MaterialSignature &table_signature : {signature, flipped}) {
+		if (!m_tables.empty() && table_signature == m_tables[0].signature) {
+			break;
+		}
+
+		Table table;
+		table.signature = table_signature;
+		table.size = getTableSize(table_signature);
+		table.values.reset(new std::atomic<std::uint8_t>[(table.size + 3) / 4]());
+		m_tables.push_back(std::move(table));
+	}
+
+	m_king_placements = getKingPlacements(signature);
+
+	m_black_men.resize(getMenPlacements(signature.black_men));
+	m_black_progress.resize(m_black_men.size());
+	m_flipped_black_men.resize(m_black_men.size());
+
+	for (u64 men = 0; men < m_black_men.size(); men++) {
+		m_black_men[men] = getMenSquares(signature.black_men, men, false);
+		m_black_progress[men] = getProgress(m_black_men[men], false);
+		m_flipped_black_men[men] = getMenPlacement(flipBoard({m_black_men[men], 0, 0}).white_pieces, true);
+	}
+
+	m_white_men.resize(getMenPlacements(signature.white_men));
+	m_flipped_white_men.resize(m_white_men.size());
+	m_white_men_by_progress.assign(getNumLevels(m_signature), std::vector<u64>());
+
+	for (u64 men = 0; men < m_white_men.size(); men++) {
+		m_white_men[men] = getMenSquares(signature.white_men, men, true);
+		m_white_men_by_progress[getProgress(m_white_men[men], true)].push_back(men);
+		m_flipped_white_men[men] = getMenPlacement(flipBoard({0, m_white_men[men], 0}).black_pieces, false);
+	}
+}
+
+
+// a man can come at most six rows
+int TablebaseGenerator::getNumLevels(const MaterialSignature &signature) {
+	return 6 * (signature.black_men + signature.white_men) + 1;
+}
+
+
+// solves the groups of a slice of a level, the level above must already be solved
+// the groups of a level are dealt out in turn to num_slices slices
+// returns false if a table a move leads to is missing
+bool TablebaseGenerator::solveSlice(int level, int slice, int num_slices) {
+	if (!m_successors_loaded) {
+		if (!loadSuccessors(m_signature) || !loadSuccessors(getFlippedSignature(m_signature))) {
+			return false;
+		}
+		m_successors_loaded = true;
+	}
+
+	const std::vector<u64> groups = getSliceGroups(level, slice, num_slices);
+	std::vector<int> passes(groups.size());
+	std::atomic<std::size_t> next_group(0);
+
+	// with fewer groups than threads each group is shared between all of them instead
+	const bool share_groups = groups.size() < static_cast<std::size_t>(m_num_threads);
+
+	auto work = [&]() {
+		std::size_t i;
+		while ((i = next_group++) < groups.size()) {
+			Group group;
+			findGroup(groups[i], &group);
+			passes[i] = solveGroup(&group, share_groups ? m_num_threads : 1);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < m_num_threads && !share_groups; i++) {
+		workers.emplace_back(work);
+	}
+
+	work();
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	for (int group_passes : passes) {
+		m_passes = std::max(m_passes, group_passes);
+	}
+
+	return true;
+}
+
+
+// returns the solved values of a slice packed four to a byte, its groups' positions one after the other
+std::vector<unsigned char> TablebaseGenerator::getSliceValues(int level, int slice, int num_slices) const {
+	std::vector<unsigned char> values;
+	u64 position = 0;
+
+	for (u64 men : getSliceGroups(level, slice, num_slices)) {
+		Group group;
+		findGroup(men, &group);
+
+		for (int part = 0; part < group.num_parts; part++) {
+			const Table &table = m_tables[group.tables[part]];
+
+			for (u64 kings = 0; kings < m_king_placements; kings++, position++) {
+				const u64 index = group.men[part] * m_king_placements + kings;
+				const int value = (table.values[index >> 2].load(std::memory_order_relaxed) >> ((index & 3) * 2)) & 3;
+
+				if ((position & 3) == 0) {
+					values.push_back(0);
+				}
+				values.back() |= value << ((position & 3) * 2);
+			}
+		}
+	}
+
+	return values;
+}
+
+
+// fills in the values of a slice solved elsewhere, as returned by getSliceValues()
+// returns false if there are too many or too few of them
+bool TablebaseGenerator::setSliceValues(int level, int slice, int num_slices, const std::vector<unsigned char> &values) {
+	const std::vector<u64> groups = getSliceGroups(level, slice, num_slices);
+
+	u64 num_positions = 0;
+	for (u64 men : groups) {
+		Group group;
+		findGroup(men, &group);
+		num_positions += group.num_parts * m_king_placements;
+	}
+
+	if (values.size() != (num_positions + 3) / 4) {
+		return false;
+	}
+
+	u64 position = 0;
+
+	for (u64 men : groups) {
+		Group group;
+		findGroup(men, &group);
+
+		for (int part = 0; part < group.num_parts; part++) {
+			Table &table = m_tables[group.tables[part]];
+
+			for (u64 kings = 0; kings < m_king_placements; kings++, position++) {
+				const u64 index = group.men[part] * m_king_placements + kings;
+				const int value = getPackedValue(values.data(), position);
+
+				table.values[index >> 2].fetch_or(value << ((index & 3) * 2), std::memory_order_relaxed);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+// writes the tables once every level is solved, stats are for the signature given to start()
+// returns false if a table could not be written
+bool TablebaseGenerator::finish(TablebaseStats *stats) {
+	bool saved = true;
+
+	for (Table &table : m_tables) {
+		std::vector<unsigned char> values((table.size + 3) / 4);
+		for (std::size_t i = 0; i < values.size(); i++) {
+			values[i] = table.values[i].load(std::memory_order_relaxed);
+		}
+
+		// the indexes that aren't a position are the only ones left unknown
+		TablebaseStats table_stats = {};
+		for (u64 index = 0; index < table.size; index++) {
+			const TablebaseValue value = getPackedValue(values.data(), index);
+
+			table_stats.positions += (value != TB_UNKNOWN);
+			table_stats.wins += (value == TB_WIN);
+			table_stats.draws += (value == TB_DRAW);
+			table_stats.losses += (value == TB_LOSS);
+		}
+		table_stats.passes = m_passes;
+
+		if (table.signature == m_signature) {
+			*stats = table_stats;
+		}
+
+		saved = saveCheckedTable(getTablePath(m_directory, table.signature), table.signature, values) && saved;
+	}
+
+	m_tables.clear();
+	m_successors.clear();
+
+	return saved;
+}
+
+
+// reads the tables the moves out of signature lead to, other than the ones being solved
+bool TablebaseGenerator::loadSuccessors(const MaterialSignature &signature) {
+	for (const MaterialSignature &successor : getSuccessorSignatures(signature)) {
+		const int key = getSignatureKey(successor);
+
+		bool is_being_solved = false;
+		for (const Table &table : m_tables) {
+			is_being_solved = is_being_solved || table.signature == successor;
+		}
+
+		if (is_being_solved || m_successors.count(key) > 0) {
+			continue;
+		}
+
+		if (!loadTable(getTablePath(m_directory, successor), successor, &m_successors[key])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// returns the men placements, in the first table, of the groups of a slice of a level in index order
+// a group of a signature that is its own flipped signature is only returned for the lower of its two placements
+std::vector<u64> TablebaseGenerator::getSliceGroups(int level, int slice, int num_slices) const {
+	std::vector<u64> groups;
+	u64 num_groups = 0;
+
+	const u64 white_placements = m_white_men.size();
+
+	for (u64 black = 0; black < m_black_men.size(); black++) {
+		const int white_progress = level - m_black_progress[black];
+		if (white_progress < 0 || white_progress >= static_cast<int>(m_white_men_by_progress.size())) {
+			continue;
+		}
+
+		for (u64 white : m_white_men_by_progress[white_progress]) {
+			if (m_black_men[black] & m_white_men[white]) {
+				continue;
+			}
+
+			const u64 men = black * white_placements + white;
+			const u64 flipped_men = m_flipped_white_men[white] * m_black_men.size() + m_flipped_black_men[black];
+
+			if (m_tables.size() == 1 && flipped_men < men) {
+				continue;
+			}
+
+			if (num_groups++ % num_slices == static_cast<u64>(slice)) {
+				groups.push_back(men);
+			}
+		}
+	}
+
+	return groups;
+}
+
+
+// fills in the parts of the group with men in the first table, but not its values
+void TablebaseGenerator::findGroup(u64 men, Group *group) const {
+	const u64 black = men / m_white_men.size();
+	const u64 white = men % m_white_men.size();
+	const u64 flipped_men = m_flipped_white_men[white] * m_black_men.size() + m_flipped_black_men[black];
+
+	group->num_parts = 1;
+	group->tables[0] = 0;
+	group->men[0] = men;
+
+	if (m_tables.size() == 2 || flipped_men != men) {
+		group->num_parts = 2;
+		group->tables[1] = static_cast<int>(m_tables.size()) - 1;
+		group->men[1] = flipped_men;
+	}
+}
+
+
+// solves a group and stores its values in the tables
+// returns the number of passes after the first
+int TablebaseGenerator::solveGroup(Group *group, int num_threads) {
+	group->values.reset(new std::atomic<std::uint8_t>[group->num_parts * m_king_placements]());
+
+	runPass(group, true, num_threads);
+
+	int passes = 0;
+	while (runPass(group, false, num_threads) > 0) {
+		passes++;
+	}
+
+	storeGroup(*group);
+
+	return passes;
+}
+
+
+// solves what it can of a group, the threads taking a chunk of positions at a time
+// returns the number of positions that were given a value
+u64 TablebaseGenerator::runPass(Group *group, bool is_first_pass, int num_threads) {
+	const u64 size = group->num_parts * m_king_placements;
+
+	if (num_threads <= 1 || size <= CHUNK_SIZE) {
+		return solveRange(group, 0, size, is_first_pass);
+	}
+
+	std::atomic<u64> changed(0);
+	std::atomic<u64> next_chunk(0);
+
+	auto work = [&]() {
+		u64 begin;
+		while ((begin = next_chunk.fetch_add(CHUNK_SIZE)) < size) {
+			changed += solveRange(group, begin, std::min(begin + CHUNK_SIZE, size), is_first_pass);
+		}
+	};
+
+	// the calling thread does a share of the work too
+	std::vector<std::thread> workers;
+	for (int i = 1; i < num_threads; i++) {
+		workers.emplace_back(work);
+	}
+
+	work();
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	return changed;
+}
+
+
+u64 TablebaseGenerator::solveRange(Group *group, u64 begin, u64 end, bool is_first_pass) {
+	u64 changed = 0;
+	std::vector<Bitboard> previous_positions;
+
+	for (u64 position = begin; position < end; position++) {
+		solvePosition(group, position, is_first_pass, &changed, &previous_positions);
+	}
+
+	return changed;
+}
+
+
+// the first pass settles the positions decided by the moves that leave the group, and notes
+// the ones that can't be lost as one of those moves draws
+// the passes after it only look at the king moves of the positions still unknown that are marked to be checked again
+// the mark is cleared before the moves are looked up and set after a value is stored, so that a position
+// another thread gives a value meanwhile is either seen or leaves the mark for the next pass
+void TablebaseGenerator::solvePosition(Group *group, u64 position, bool is_first_pass, u64 *changed,
+		std::vector<Bitboard> *previous_positions) {
+	std::atomic<std::uint8_t> &entry = group->values[position];
+	std::uint8_t flags = entry.load(std::memory_order_relaxed);
+
+	if (!is_first_pass) {
+		if ((flags & VALUE_MASK) != TB_UNKNOWN || !(flags & RECHECK)) {
+			return;
+		}
+		flags = entry.fetch_and(static_cast<std::uint8_t>(~RECHECK));
+	}
+
+	// the men of a group never overlap, so every index is a position
+	const int part = static_cast<int>(position / m_king_placements);
+	const u64 index = group->men[part] * m_king_placements + position % m_king_placements;
+	Bitboard board;
+	getTablePosition(m_tables[group->tables[part]].signature, index, &board);
+
+	Bitboard next_positions[MAX_MOVES];
+	const int moves_found = generateMoves(board, false, next_positions, nullptr);
+
+	const u32 men = (board.black_pieces | board.white_pieces) & ~board.king_pieces;
+	const int num_pieces = popcount(board.black_pieces | board.white_pieces);
+
+	bool can_lose = !(flags & CANNOT_LOSE);
+	bool has_king_move = false;
+	std::uint8_t value = TB_UNKNOWN;
+
+	for (int i = 0; i < moves_found && value == TB_UNKNOWN; i++) {
+		const Bitboard &child = next_positions[i];
+
+		// a king move that doesn't capture leaves the men where they were
+		const bool is_king_move = ((child.black_pieces | child.white_pieces) & ~child.king_pieces) == men
+			&& popcount(child.black_pieces | child.white_pieces) == num_pieces;
+		has_king_move = has_king_move || is_king_move;
+
+		if (is_king_move == is_first_pass) {
+			continue;
+		}
+
+		const TablebaseValue child_value = lookUp(*group, child, is_king_move);
+		if (child_value == TB_LOSS) {
+			value = TB_WIN;
+		} else if (child_value != TB_WIN) {
+			can_lose = false;
+		}
+	}
+
+	if (value == TB_UNKNOWN && can_lose && (!is_first_pass || !has_king_move)) {
+		value = TB_LOSS; // every move reaches a won position, or there are no moves at all
+	} else if (value == TB_UNKNOWN && is_first_pass && !has_king_move) {
+		value = TB_DRAW;
+	}
+
+	// the positions left unknown by the first pass are all checked by the second, which needs the king moves
+	if (is_first_pass) {
+		entry.store(value | (can_lose ? 0 : CANNOT_LOSE) | (value == TB_UNKNOWN ? RECHECK : 0), std::memory_order_relaxed);
+	} else if (value != TB_UNKNOWN) {
+		entry.store(value);
+		markPredecessors(group, board, previous_positions);
+	}
+
+	if (value != TB_UNKNOWN) {
+		(*changed)++;
+	}
+}
+
+
+// marks the positions of the group with a king move to board, which has just been given a value, to be checked again
+void TablebaseGenerator::markPredecessors(Group *group, const Bitboard &board, std::vector<Bitboard> *previous_positions) {
+	// the moves are black's, into the position with white to move
+	const Bitboard child = flipBoard(board);
+	const u32 men = (child.black_pieces | child.white_pieces) & ~child.king_pieces;
+
+	generateUnmoves(child, true, 0, previous_positions);
+
+	for (const Bitboard &previous : *previous_positions) {
+		// leave out the men that moved and the kings that were crowned
+		if (((previous.black_pieces | previous.white_pieces) & ~previous.king_pieces) != men) {
+			continue;
+		}
+
+		const MaterialSignature signature = getMaterialSignature(previous);
+		const u64 index = getTableIndex(signature, previous);
+
+		for (int part = 0; part < group->num_parts; part++) {
+			if (m_tables[group->tables[part]].signature == signature && group->men[part] == index / m_king_placements) {
+				group->values[part * m_king_placements + index % m_king_placements].fetch_or(RECHECK);
+			}
+		}
+	}
+}
+
+
+// returns the value for white, who is to move, of the position after one of black's moves
+// a king move stays in the group, any other move in the signature goes to the level above
+TablebaseValue TablebaseGenerator::lookUp(const Group &group, const Bitboard &child, bool is_in_group) const {
+	if (child.white_pieces == 0) {
+		return TB_LOSS;
+	}
+
+	const Bitboard flipped = flipBoard(child);
+	const MaterialSignature signature = getMaterialSignature(flipped);
+	const u64 index = getTableIndex(signature, flipped);
+
+	if (is_in_group) {
+		for (int part = 0; part < group.num_parts; part++) {
+			if (m_tables[group.tables[part]].signature == signature && group.men[part] == index / m_king_placements) {
+				const u64 position = part * m_king_placements + index % m_king_placements;
+				return static_cast<TablebaseValue>(group.values[position].load() & VALUE_MASK);
+			}
+		}
+	}
+
+	for (const Table &table : m_tables) {
+		if (table.signature == signature) {
+			return static_cast<TablebaseValue>((table.values[index >> 2].load(std::memory_order_relaxed) >> ((index & 3) * 2)) & 3);
+		}
+	}
+
+	return getPackedValue(m_successors.at(getSignatureKey(signature)).data(), index);
+}
+
+
+// packs the values of a solved group into the tables, the positions still unknown being draws
+void TablebaseGenerator::storeGroup(const Group &group) {
+	for (int part = 0; part < group.num_parts; part++) {
+		Table &table = m_tables[group.tables[part]];
+
+		for (u64 kings = 0; kings < m_king_placements; kings++) {
+			std::uint8_t value = group.values[part * m_king_placements + kings].load(std::memory_order_relaxed) & VALUE_MASK;
+			if (value == TB_UNKNOWN) {
+				value = TB_DRAW;
+			}
+
+			const u64 index = group.men[part] * m_king_placements + kings;
+			table.values[index >> 2].fetch_or(value << ((index & 3) * 2), std::memory_order_relaxed);
+		}
+	}
+}
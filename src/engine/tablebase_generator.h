@@ -0,0 +1,109 @@
+#ifndef TABLEBASE_GENERATOR_H
+#define TABLEBASE_GENERATOR_H
+
+
+#include "engine/tablebase.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+struct TablebaseStats {
+	u64 positions; // legal positions, leaving out the indexes that aren't one
+	u64 wins;
+	u64 draws;
+	u64 losses;
+	int passes; // the most any group needed after its first, the longest win is about this many moves
+};
+
+
+// solves every position of a material signature with retrograde analysis and writes its table
+//
+// a man that moves without capturing or crowning goes one row forward, so the positions are split into
+// levels by how far the men of both sides have come, and every move either stays in its level by moving
+// a king, goes up one level or leaves the signature. the levels are solved from the top down, each only
+// needing the level above it and the tables already written for the signatures the moves leave to
+//
+// the positions with the same men, with either side to move, make up a group that only king moves go
+// between. the first pass over a group looks up every move that leaves it. each pass after that plays
+// the king moves, marking a position won if a move reaches a lost position and lost if every move
+// reaches a won one, until a pass changes nothing. whatever is still unknown then is a draw. a pass
+// only looks at the positions that a king move undone from a position given a value leads back to
+//
+// a signature and its flipped signature are solved together. the groups of a level are split across
+// threads, or the positions of each group if there are too few groups. a level can also be split into
+// slices that are solved separately and their values passed between processes, see tablebase_jobs.h
+class TablebaseGenerator {
+public:
+	explicit TablebaseGenerator(const std::string &directory, int num_threads = 0);
+
+	bool generate(const MaterialSignature &signature, TablebaseStats *stats);
+
+	void start(const MaterialSignature &signature);
+	static int getNumLevels(const MaterialSignature &signature);
+	bool solveSlice(int level, int slice, int num_slices);
+	std::vector<unsigned char> getSliceValues(int level, int slice, int num_slices) const;
+	bool setSliceValues(int level, int slice, int num_slices, const std::vector<unsigned char> &values);
+	bool finish(TablebaseStats *stats);
+
+private:
+	// a group being solved holds a byte per position: its value in the low bits and these flags
+	static constexpr std::uint8_t VALUE_MASK = 3;
+	static constexpr std::uint8_t CANNOT_LOSE = 4; // a move leaving the group reaches a draw
+	static constexpr std::uint8_t RECHECK = 8; // a king move from it reaches a position given a value since it was looked at
+
+	// positions handed to a thread at a time when a group is split between threads
+	static constexpr u64 CHUNK_SIZE = 1 << 12;
+
+	struct Table {
+		MaterialSignature signature;
+		u64 size;
+		std::unique_ptr<std::atomic<std::uint8_t>[]> values; // packed as in a table file, a group at a time
+	};
+
+	// the positions of one or two men placements, each with every placement of the kings
+	// the second is the first flipped, unless that is the same positions
+	struct Group {
+		int num_parts;
+		int tables[2]; // indexes into m_tables
+		u64 men[2];
+		std::unique_ptr<std::atomic<std::uint8_t>[]> values; // the parts one after the other
+	};
+
+	bool loadSuccessors(const MaterialSignature &signature);
+	std::vector<u64> getSliceGroups(int level, int slice, int num_slices) const;
+	void findGroup(u64 men, Group *group) const;
+	int solveGroup(Group *group, int num_threads);
+	u64 runPass(Group *group, bool is_first_pass, int num_threads);
+	u64 solveRange(Group *group, u64 begin, u64 end, bool is_first_pass);
+	void solvePosition(Group *group, u64 position, bool is_first_pass, u64 *changed, std::vector<Bitboard> *previous_positions);
+	void markPredecessors(Group *group, const Bitboard &board, std::vector<Bitboard> *previous_positions);
+	TablebaseValue lookUp(const Group &group, const Bitboard &child, bool is_in_group) const;
+	void storeGroup(const Group &group);
+
+	std::string m_directory;
+	int m_num_threads;
+
+	MaterialSignature m_signature;
+	std::vector<Table> m_tables; // the signature being solved and its flipped signature, if it is different
+	std::map<int, std::vector<unsigned char>> m_successors; // packed values by signature key
+	bool m_successors_loaded = false;
+	int m_passes = 0;
+
+	// for each placement of the men of each side in the first table: its squares, how far the men have
+	// come and the placement of the same men flipped in the second table
+	u64 m_king_placements = 0;
+	std::vector<u32> m_black_men;
+	std::vector<u32> m_white_men;
+	std::vector<int> m_black_progress;
+	std::vector<std::vector<u64>> m_white_men_by_progress;
+	std::vector<u64> m_flipped_black_men;
+	std::vector<u64> m_flipped_white_men;
+};
+
+
+#endif // TABLEBASE_GENERATOR_H
@@ -0,0 +1,529 @@
+#include "engine/tablebase_jobs.h"
+
+#include "engine/byte_order.h"
+#include "engine/tablebase_generator.h"
+
+#include <algorithm> // for std::min, std::max, std::find
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#include <process.h>
+#endif
+
+
+static constexpr char PART_MAGIC[4] = {'C', 'K', 'T', 'P'};
+static constexpr int PART_FORMAT_VERSION = 1;
+static constexpr int PART_HEADER_SIZE = 32;
+
+// a level is only split into more slices if each would have about this many positions
+static constexpr u64 MIN_SLICE_POSITIONS = 1 << 16;
+
+
+// FNV-1a, which is plenty to catch a part that was cut short or damaged on the way
+static u64 getChecksum(const std::vector<unsigned char> &values) {
+	u64 hash = 0xcbf2'9ce4'8422'2325;
+
+	for (unsigned char byte : values) {
+		hash = (hash ^ byte) * 0x100'0000'01b3;
+	}
+
+	return hash;
+}
+
+
+static std::string getHostName() {
+#ifndef _WIN32
+	char name[256] = {};
+	if (gethostname(name, sizeof(name) - 1) == 0) {
+		return name;
+	}
+#endif
+	return "localhost";
+}
+
+
+static long getProcessId() {
+#ifndef _WIN32
+	return static_cast<long>(getpid());
+#else
+	return static_cast<long>(_getpid());
+#endif
+}
+
+
+// returns true if a lock file was left by a worker on this machine that is no longer running
+// a lock from another machine can't be checked, see TablebaseJobs::release()
+static bool isStaleLock(const std::string &path) {
+#ifndef _WIN32
+	std::ifstream file(path);
+	std::string host;
+	long pid = 0;
+
+	if (!(file >> host >> pid) || host != getHostName()) {
+		return false;
+	}
+
+	return kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH;
+#else
+	(void) path;
+	return false;
+#endif
+}
+
+
+static bool makeDirectory(const std::string &path) {
+#ifndef _WIN32
+	return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+#else
+	return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#endif
+}
+
+
+// writes contents under another name first, so path only ever holds a whole file
+static bool writeFileAtomically(const std::string &path, const std::string &contents) {
+	const std::string temporary_path = path + ".tmp";
+
+	std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+	file.write(contents.data(), contents.size());
+	file.close();
+
+	if (file.fail() || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+static bool writePart(const std::string &path, const MaterialSignature &signature, int level, int slice,
+		const std::vector<unsigned char> &values) {
+	unsigned char header[PART_HEADER_SIZE] = {};
+	std::memcpy(header, PART_MAGIC, sizeof(PART_MAGIC));
+	writeLittleEndian(header + 4, PART_FORMAT_VERSION, 4);
+	writeLittleEndian(header + 8, static_cast<u32>(getSignatureKey(signature)), 4);
+	writeLittleEndian(header + 12, level, 4);
+	writeLittleEndian(header + 16, slice, 4);
+	writeLittleEndian(header + 20, values.size(), 4);
+	writeLittleEndian(header + 24, getChecksum(values), 8);
+
+	std::string contents(reinterpret_cast<const char*>(header), PART_HEADER_SIZE);
+	contents.append(values.begin(), values.end());
+
+	return writeFileAtomically(path, contents);
+}
+
+
+// returns false if the part can't be read, is of another slice or doesn't match its checksum
+static bool readPart(const std::string &path, const MaterialSignature &signature, int level, int slice,
+		std::vector<unsigned char> *values) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (contents.size() < PART_HEADER_SIZE
+			|| std::memcmp(contents.data(), PART_MAGIC, sizeof(PART_MAGIC)) != 0
+			|| readLittleEndian(&contents[4], 4) != PART_FORMAT_VERSION
+			|| readLittleEndian(&contents[8], 4) != static_cast<u32>(getSignatureKey(signature))
+			|| readLittleEndian(&contents[12], 4) != static_cast<u64>(level)
+			|| readLittleEndian(&contents[16], 4) != static_cast<u64>(slice)
+			|| readLittleEndian(&contents[20], 4) != contents.size() - PART_HEADER_SIZE) {
+		return false;
+	}
+
+	values->assign(contents.begin() + PART_HEADER_SIZE, contents.end());
+
+	return readLittleEndian(&contents[24], 8) == getChecksum(*values);
+}
+
+
+// the jobs use num_threads threads each, defaulting to the number of cores
+TablebaseJobs::TablebaseJobs(const std::string &directory, int num_threads) :
+	m_directory(directory),
+	m_num_threads(num_threads)
+{
+}
+
+
+// adds the jobs that generate every table with up to max_pieces pieces that isn't already written
+// or planned, splitting each level into up to num_slices slices
+// returns false if the jobs could not be written
+bool TablebaseJobs::plan(int max_pieces, int num_slices, int *num_jobs) {
+	if (!makeDirectory(getJobsPath())) {
+		return false;
+	}
+
+	int number = 0;
+	std::set<std::string> planned;
+
+	Job existing_job;
+	while (readJob(number, &existing_job)) {
+		planned.insert(existing_job.writes.begin(), existing_job.writes.end());
+		number++;
+	}
+
+	const int first_number = number;
+
+	for (const MaterialSignature &signature : getSignaturesInOrder(max_pieces)) {
+		const MaterialSignature flipped = getFlippedSignature(signature);
+		const std::string table_path = getTablePath(".", signature);
+
+		if (planned.count(table_path) > 0 || fileExists(getTablePath(m_directory, signature))) {
+			continue; // along with its flipped signature
+		}
+
+		std::set<std::string> successors;
+		for (const MaterialSignature &side : {signature, flipped}) {
+			for (const MaterialSignature &successor : getSuccessorSignatures(side)) {
+				if (successor != signature && successor != flipped) {
+					successors.insert(getTablePath(".", successor));
+				}
+			}
+		}
+
+		// a level has about as many groups to share out as men placements over levels
+		const int num_levels = TablebaseGenerator::getNumLevels(signature);
+		const u64 level_groups = getMenPlacements(signature.black_men) * getMenPlacements(signature.white_men) / num_levels;
+		const u64 level_positions = getTableSize(signature) / num_levels;
+		const int slices = static_cast<int>(std::max<u64>(1,
+			std::min<u64>({static_cast<u64>(num_slices), level_groups, level_positions / MIN_SLICE_POSITIONS})));
+
+		Job merge_job;
+		merge_job.description = "merge " + getSignatureName(signature) + " " + std::to_string(slices);
+
+		for (int level = num_levels - 1; level >= 0; level--) {
+			for (int slice = 0; slice < slices; slice++) {
+				Job job;
+				job.description = "solve " + getSignatureName(signature) + " " + std::to_string(level)
+					+ " " + std::to_string(slice) + " " + std::to_string(slices);
+				job.needs.assign(successors.begin(), successors.end());
+				for (int above = 0; above < slices && level + 1 < num_levels; above++) {
+					job.needs.push_back(getPartPath(signature, level + 1, above));
+				}
+				job.writes.push_back(getPartPath(signature, level, slice));
+
+				if (!writeJob(number++, job)) {
+					return false;
+				}
+
+				merge_job.needs.push_back(job.writes[0]);
+			}
+		}
+
+		merge_job.writes.push_back(table_path);
+		if (flipped != signature) {
+			merge_job.writes.push_back(getTablePath(".", flipped));
+		}
+
+		if (!writeJob(number++, merge_job)) {
+			return false;
+		}
+
+		planned.insert(merge_job.writes.begin(), merge_job.writes.end());
+	}
+
+	*num_jobs = number - first_number;
+
+	return true;
+}
+
+
+// carries out the first job that is ready and no other worker has taken, description is set to its
+// first line, or to the path of a part it found damaged, which is then made again
+// the part files of a signature are removed once it has been merged
+TablebaseJobs::Result TablebaseJobs::runNextJob(std::string *description) {
+	bool all_done = true;
+
+	for (int number = 0; fileExists(getJobPath(number, "job")); number++) {
+		const std::string done_path = getJobPath(number, "done");
+		if (fileExists(done_path)) {
+			continue;
+		}
+
+		all_done = false;
+
+		Job job;
+		if (!readJob(number, &job)) {
+			return JOB_FAILED;
+		}
+
+		bool is_ready = true;
+		for (const std::string &path : job.needs) {
+			is_ready = is_ready && fileExists(m_directory + "/" + path);
+		}
+
+		if (!is_ready || !lockJob(number)) {
+			continue;
+		}
+
+		const std::string lock_path = getJobPath(number, "lock");
+
+		// another worker may have finished it between looking and taking the lock
+		if (fileExists(done_path)) {
+			std::remove(lock_path.c_str());
+			continue;
+		}
+
+		*description = job.description;
+
+		std::string damaged_part;
+		bool succeeded = (job.type == "solve") ? runSolveJob(job, &damaged_part) : runMergeJob(job, &damaged_part);
+
+		if (!damaged_part.empty()) {
+			redoPart(damaged_part);
+			std::remove(lock_path.c_str());
+			*description = damaged_part;
+			return PART_DAMAGED;
+		}
+
+		succeeded = succeeded && writeFileAtomically(done_path, "");
+
+		if (succeeded && job.type == "merge") {
+			for (const std::string &path : job.needs) {
+				std::remove((m_directory + "/" + path).c_str());
+			}
+		}
+
+		std::remove(lock_path.c_str());
+
+		return succeeded ? JOB_DONE : JOB_FAILED;
+	}
+
+	return all_done ? ALL_DONE : NO_JOB_READY;
+}
+
+
+TablebaseJobs::Status TablebaseJobs::getStatus() const {
+	Status status = {};
+
+	for (int number = 0; fileExists(getJobPath(number, "job")); number++) {
+		const bool is_done = fileExists(getJobPath(number, "done"));
+
+		status.jobs++;
+		status.done += is_done;
+		status.running += !is_done && fileExists(getJobPath(number, "lock"));
+	}
+
+	return status;
+}
+
+
+// removes the locks of the jobs that aren't done, so the jobs of a worker that died on another
+// machine can be taken up again, which must only be done while no workers are running
+// returns the number of locks removed
+int TablebaseJobs::release() {
+	int released = 0;
+
+	for (int number = 0; fileExists(getJobPath(number, "job")); number++) {
+		const std::string lock_path = getJobPath(number, "lock");
+
+		if (!fileExists(getJobPath(number, "done")) && fileExists(lock_path) && std::remove(lock_path.c_str()) == 0) {
+			released++;
+		}
+	}
+
+	return released;
+}
+
+
+std::string TablebaseJobs::getJobsPath() const {
+	return m_directory + "/jobs";
+}
+
+
+// the files of a job are numbered so that the jobs are listed in order
+std::string TablebaseJobs::getJobPath(int number, const char *extension) const {
+	char name[32];
+	std::snprintf(name, sizeof(name), "/%06d.%s", number, extension);
+
+	return getJobsPath() + name;
+}
+
+
+// returns the path of a part relative to the tablebase directory, as job files give it
+std::string TablebaseJobs::getPartPath(const MaterialSignature &signature, int level, int slice) const {
+	return "jobs/" + getSignatureName(signature) + "." + std::to_string(level) + "." + std::to_string(slice) + ".part";
+}
+
+
+// returns false if the job doesn't exist or its file can't be understood
+bool TablebaseJobs::readJob(int number, Job *job) const {
+	std::ifstream file(getJobPath(number, "job"));
+	std::string line;
+
+	if (!std::getline(file, line)) {
+		return false;
+	}
+
+	job->description = line;
+	job->level = 0;
+	job->slice = 0;
+	job->needs.clear();
+	job->writes.clear();
+
+	std::istringstream first_line(line);
+	std::string name;
+	first_line >> job->type >> name;
+
+	if (job->type == "solve") {
+		first_line >> job->level >> job->slice >> job->num_slices;
+	} else if (job->type == "merge") {
+		first_line >> job->num_slices;
+	} else {
+		return false;
+	}
+
+	if (!first_line || !parseSignatureName(name, &job->signature)) {
+		return false;
+	}
+
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		std::string path;
+
+		if (!(fields >> key >> path)) {
+			return false;
+		} else if (key == "needs") {
+			job->needs.push_back(path);
+		} else if (key == "writes") {
+			job->writes.push_back(path);
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool TablebaseJobs::writeJob(int number, const Job &job) const {
+	std::string contents = job.description + "\n";
+
+	for (const std::string &path : job.needs) {
+		contents += "needs " + path + "\n";
+	}
+	for (const std::string &path : job.writes) {
+		contents += "writes " + path + "\n";
+	}
+
+	return writeFileAtomically(getJobPath(number, "job"), contents);
+}
+
+
+bool TablebaseJobs::fileExists(const std::string &path) const {
+	return std::ifstream(path).good();
+}
+
+
+// takes a job for this process by creating its lock file, which names the machine and process
+// returns false if another worker that is still running has it
+bool TablebaseJobs::lockJob(int number) const {
+	const std::string path = getJobPath(number, "lock");
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		// opening with x fails if the file exists, even over a network filesystem
+		std::FILE *file = std::fopen(path.c_str(), "wx");
+
+		if (file != nullptr) {
+			std::fprintf(file, "%s %ld\n", getHostName().c_str(), getProcessId());
+			std::fclose(file);
+			return true;
+		}
+
+		if (attempt > 0 || !isStaleLock(path)) {
+			break;
+		}
+
+		std::remove(path.c_str());
+	}
+
+	return false;
+}
+
+
+// reads a part into the generator
+// damaged_part is set to its path if the part is there but fails its checks
+bool TablebaseJobs::readSlice(TablebaseGenerator *generator, const Job &job, int level, int slice,
+		std::string *damaged_part) const {
+	const std::string path = getPartPath(job.signature, level, slice);
+	std::vector<unsigned char> values;
+
+	if (!readPart(m_directory + "/" + path, job.signature, level, slice, &values)
+			|| !generator->setSliceValues(level, slice, job.num_slices, values)) {
+		if (fileExists(m_directory + "/" + path)) {
+			*damaged_part = path;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+
+// solves a slice from the parts of the level above it
+bool TablebaseJobs::runSolveJob(const Job &job, std::string *damaged_part) const {
+	TablebaseGenerator generator(m_directory, m_num_threads);
+	generator.start(job.signature);
+
+	const int level_above = job.level + 1;
+
+	for (int slice = 0; slice < job.num_slices && level_above < TablebaseGenerator::getNumLevels(job.signature); slice++) {
+		if (!readSlice(&generator, job, level_above, slice, damaged_part)) {
+			return false;
+		}
+	}
+
+	if (!generator.solveSlice(job.level, job.slice, job.num_slices)) {
+		return false;
+	}
+
+	return writePart(m_directory + "/" + getPartPath(job.signature, job.level, job.slice), job.signature,
+		job.level, job.slice, generator.getSliceValues(job.level, job.slice, job.num_slices));
+}
+
+
+// writes the tables of a signature from the parts of all its levels
+bool TablebaseJobs::runMergeJob(const Job &job, std::string *damaged_part) const {
+	TablebaseGenerator generator(m_directory, m_num_threads);
+	generator.start(job.signature);
+
+	for (int level = 0; level < TablebaseGenerator::getNumLevels(job.signature); level++) {
+		for (int slice = 0; slice < job.num_slices; slice++) {
+			if (!readSlice(&generator, job, level, slice, damaged_part)) {
+				return false;
+			}
+		}
+	}
+
+	TablebaseStats stats;
+	return generator.finish(&stats);
+}
+
+
+// removes a damaged part and the done file of the job that wrote it, so that job is run again
+void TablebaseJobs::redoPart(const std::string &path) const {
+	std::remove((m_directory + "/" + path).c_str());
+
+	Job job;
+	for (int number = 0; readJob(number, &job); number++) {
+		if (std::find(job.writes.begin(), job.writes.end(), path) != job.writes.end()) {
+			std::remove(getJobPath(number, "done").c_str());
+		}
+	}
+}
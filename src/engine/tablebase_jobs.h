@@ -0,0 +1,87 @@
+#ifndef TABLEBASE_JOBS_H
+#define TABLEBASE_JOBS_H
+
+
+#include "engine/tablebase.h"
+
+#include <string>
+#include <vector>
+
+
+class TablebaseGenerator;
+
+
+// splits the generation of the tablebases into jobs that worker processes carry out, on one machine
+// or on several sharing the tablebase directory over a network filesystem
+//
+// plan() writes a file for each job to the jobs directory inside the tablebase directory, numbered in
+// an order where every job comes after the jobs it needs. a job either solves a slice of a level of a
+// signature, see TablebaseGenerator, or merges all the slices of a signature into its tables. a job file
+// is text, with paths relative to the tablebase directory:
+//
+//   solve SIGNATURE LEVEL SLICE NUM_SLICES  or  merge SIGNATURE NUM_SLICES
+//   needs PATH     a file that must exist before the job can start, one line for each
+//   writes PATH    a file the job writes, one line for each
+//
+// a worker takes the first job whose files are all there by creating its lock file, which fails if
+// another worker got there first, and leaves a done file next to it once it is finished. everything
+// is written under another name and renamed when it is complete, so a worker that dies part way
+// through only leaves its lock behind, which the next worker on the same machine takes over
+//
+// a slice is written to a part file: a 32 byte header with the signature, level, slice and a checksum
+// of the values that follow, packed four to a byte in the order TablebaseGenerator::getSliceValues()
+// gives them. the checksum is checked whenever a part is read, a damaged part being made again, and a
+// merged table is read back and compared before it is given its name
+class TablebaseJobs {
+public:
+	enum Result {
+		JOB_DONE,
+		JOB_FAILED,
+		PART_DAMAGED, // the job that wrote it is to be run again, then the job that found it
+		NO_JOB_READY, // the jobs left are running or need jobs that are
+		ALL_DONE,
+	};
+
+	struct Status {
+		int jobs;
+		int done;
+		int running; // locked but not done, which includes jobs whose worker has died
+	};
+
+	explicit TablebaseJobs(const std::string &directory, int num_threads = 0);
+
+	bool plan(int max_pieces, int num_slices, int *num_jobs);
+	Result runNextJob(std::string *description);
+	Status getStatus() const;
+	int release();
+
+private:
+	struct Job {
+		std::string description; // the first line of its file
+		std::string type;
+		MaterialSignature signature;
+		int level;
+		int slice;
+		int num_slices;
+		std::vector<std::string> needs;
+		std::vector<std::string> writes;
+	};
+
+	std::string getJobsPath() const;
+	std::string getJobPath(int number, const char *extension) const;
+	std::string getPartPath(const MaterialSignature &signature, int level, int slice) const;
+	bool readJob(int number, Job *job) const;
+	bool writeJob(int number, const Job &job) const;
+	bool fileExists(const std::string &path) const;
+	bool lockJob(int number) const;
+	bool readSlice(TablebaseGenerator *generator, const Job &job, int level, int slice, std::string *damaged_part) const;
+	bool runSolveJob(const Job &job, std::string *damaged_part) const;
+	bool runMergeJob(const Job &job, std::string *damaged_part) const;
+	void redoPart(const std::string &path) const;
+
+	std::string m_directory;
+	int m_num_threads;
+};
+
+
+#endif // TABLEBASE_JOBS_H
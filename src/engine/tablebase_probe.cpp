@@ -0,0 +1,169 @@
+#include "engine/tablebase_probe.h"
+
+#include "engine/bitbases.h"
+
+#include <algorithm> // for std::max
+#include <iterator> // for std::prev
+
+
+TablebaseProber::TablebaseProber(int cache_size_mb) :
+	m_max_cached_blocks(std::max<std::size_t>(1,
+		static_cast<std::size_t>(cache_size_mb) * 1024 * 1024 / sizeof(CachedBlock) / NUM_CACHE_SHARDS))
+{
+}
+
+
+// maps the tables in directory with up to max_pieces pieces, leaving any that are missing or damaged
+// returns the number of tables mapped, not safe to call while probing
+int TablebaseProber::load(const std::string &directory, int max_pieces) {
+	int num_loaded = 0;
+
+	if (max_pieces > MAX_TABLEBASE_PIECES) {
+		max_pieces = MAX_TABLEBASE_PIECES;
+	}
+
+	for (const MaterialSignature &signature : getSignaturesInOrder(max_pieces)) {
+		std::unique_ptr<Table> table(new Table());
+		table->signature = signature;
+		table->id = static_cast<int>(m_tables.size());
+
+		if (!table->file.open(getTablePath(directory, signature))
+				|| !checkTableFile(table->file.data(), table->file.size(), signature)) {
+			continue;
+		}
+
+		table->data = table->file.data();
+		m_tables[getSignatureKey(signature)] = std::move(table);
+		m_max_pieces = std::max(m_max_pieces, getNumPieces(signature));
+		num_loaded++;
+	}
+
+	return num_loaded;
+}
+
+
+// adds the tables compiled into the engine for the signatures that don't have a table yet
+// returns the number of tables added, not safe to call while probing
+int TablebaseProber::loadBuiltIn() {
+	int num_loaded = 0;
+
+	for (int i = 0; i < num_built_in_tables; i++) {
+		const BuiltInTable &built_in = built_in_tables[i];
+
+		MaterialSignature signature;
+		if (!parseSignatureName(built_in.name, &signature) || m_tables.count(getSignatureKey(signature)) > 0
+				|| !checkTableFile(built_in.file, built_in.file_size, signature)) {
+			continue;
+		}
+
+		std::unique_ptr<Table> table(new Table());
+		table->signature = signature;
+		table->id = static_cast<int>(m_tables.size());
+		table->data = built_in.file;
+
+		m_tables[getSignatureKey(signature)] = std::move(table);
+		m_max_pieces = std::max(m_max_pieces, getNumPieces(signature));
+		num_loaded++;
+	}
+
+	return num_loaded;
+}
+
+
+// returns the most pieces of any table, positions with more pieces are never found
+int TablebaseProber::getMaxPieces() const {
+	return m_max_pieces;
+}
+
+
+// looks up the value of the position for the side to move
+// returns false if there is no table for its material or the table is damaged
+bool TablebaseProber::probe(const Bitboard &board, bool is_whites_turn, TablebaseValue *value) {
+	if (popcount(board.black_pieces | board.white_pieces) > m_max_pieces) {
+		return false;
+	}
+
+	m_probes.fetch_add(1, std::memory_order_relaxed);
+
+	// the tables only hold positions with black to move
+	const Bitboard position = is_whites_turn ? flipBoard(board) : board;
+	const MaterialSignature signature = getMaterialSignature(position);
+
+	// there are no tables for a side with no pieces left, which has lost
+	if (position.black_pieces == 0) {
+		*value = TB_LOSS;
+		m_hits.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	auto found = m_tables.find(getSignatureKey(signature));
+	if (found == m_tables.end()) {
+		return false;
+	}
+
+	const Table &table = *found->second;
+	const u64 index = getTableIndex(signature, position);
+	const u64 block = index / POSITIONS_PER_BLOCK;
+	const std::uint64_t key = (static_cast<std::uint64_t>(table.id) << 40) | block;
+
+	CacheShard &shard = getShard(key);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	const unsigned char *values = findBlock(table, block, shard, key);
+	if (values == nullptr) {
+		return false;
+	}
+
+	*value = getPackedValue(values, index % POSITIONS_PER_BLOCK);
+	m_hits.fetch_add(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+
+TablebaseProbeStats TablebaseProber::getStats() const {
+	return {m_probes.load(), m_hits.load(), m_cache_hits.load(), m_cache_misses.load()};
+}
+
+
+// returns the shard a block's key belongs to
+// neighbouring blocks of a table are often probed together, so the key is mixed to spread them out
+TablebaseProber::CacheShard& TablebaseProber::getShard(std::uint64_t key) {
+	static_assert(NUM_CACHE_SHARDS == 16, "the shard is taken from the top four bits of the mixed key");
+	return m_cache_shards[(key * 0x9e3779b97f4a7c15ull) >> 60];
+}
+
+
+// returns the decompressed values of a block, decompressing it into the shard if it isn't there already,
+// or nullptr if it is damaged
+// the shard's mutex must be held, and the values are only valid until it is released
+const unsigned char* TablebaseProber::findBlock(const Table &table, u64 block, CacheShard &shard, std::uint64_t key) {
+	auto cached = shard.index.find(key);
+	if (cached != shard.index.end()) {
+		m_cache_hits.fetch_add(1, std::memory_order_relaxed);
+		shard.blocks.splice(shard.blocks.begin(), shard.blocks, cached->second);
+		return cached->second->values;
+	}
+
+	m_cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+	// the least recently used block is reused once the shard is full
+	if (shard.blocks.size() >= m_max_cached_blocks) {
+		shard.index.erase(shard.blocks.back().key);
+		shard.blocks.splice(shard.blocks.begin(), shard.blocks, std::prev(shard.blocks.end()));
+	} else {
+		shard.blocks.emplace_front();
+	}
+
+	CachedBlock &entry = shard.blocks.front();
+
+	if (!readTableBlock(table.data, table.signature, block, entry.values)) {
+		shard.blocks.pop_front();
+		return nullptr;
+	}
+
+	entry.key = key;
+	shard.index[key] = shard.blocks.begin();
+
+	return entry.values;
+}
@@ -0,0 +1,116 @@
+#ifndef TABLEBASE_PROBE_H
+#define TABLEBASE_PROBE_H
+
+
+#include "engine/bitboard.h"
+#include "engine/mapped_file.h"
+#include "engine/score.h"
+#include "engine/tablebase.h"
+
+#include <algorithm> // for std::min, std::max
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+struct TablebaseProbeStats {
+	std::uint64_t probes; // positions looked up that have few enough pieces
+	std::uint64_t hits; // of those, the ones a table was found for
+	std::uint64_t cache_hits; // blocks that were already decompressed
+	std::uint64_t cache_misses; // blocks that had to be decompressed
+};
+
+
+// looks up positions in the tables written by checkers_tbgen, and those compiled into the engine
+// the files are mapped into memory and their blocks decompressed when first needed into a cache
+// of the blocks used most recently, kept within a fixed budget
+// safe to share between threads, the cache being split into shards with a lock each so that
+// threads probing different blocks rarely wait for each other
+class TablebaseProber {
+public:
+	explicit TablebaseProber(int cache_size_mb);
+
+	int load(const std::string &directory, int max_pieces = MAX_TABLEBASE_PIECES);
+	int loadBuiltIn();
+	int getMaxPieces() const;
+	bool probe(const Bitboard &board, bool is_whites_turn, TablebaseValue *value);
+	TablebaseProbeStats getStats() const;
+
+	static constexpr int MAX_TABLEBASE_PIECES = 8;
+
+private:
+	struct Table {
+		MaterialSignature signature;
+		int id; // numbers the tables for the cache keys
+		MappedFile file;
+		const unsigned char *data; // of the file, or of the table compiled in
+	};
+
+	struct CachedBlock {
+		std::uint64_t key; // the table's id and the block number
+		unsigned char values[TABLE_BLOCK_SIZE];
+	};
+
+	// the blocks whose keys hash to it, with their own share of the budget
+	struct CacheShard {
+		std::mutex mutex;
+		std::list<CachedBlock> blocks; // the most recently used first
+		std::unordered_map<std::uint64_t, std::list<CachedBlock>::iterator> index;
+	};
+
+	static constexpr int NUM_CACHE_SHARDS = 16;
+
+	CacheShard& getShard(std::uint64_t key);
+	const unsigned char* findBlock(const Table &table, u64 block, CacheShard &shard, std::uint64_t key);
+
+	std::unordered_map<int, std::unique_ptr<Table>> m_tables; // by signature key
+	int m_max_pieces = 0;
+
+	std::size_t m_max_cached_blocks; // in each shard
+	CacheShard m_cache_shards[NUM_CACHE_SHARDS];
+
+	std::atomic<std::uint64_t> m_probes {0};
+	std::atomic<std::uint64_t> m_hits {0};
+	std::atomic<std::uint64_t> m_cache_hits {0};
+	std::atomic<std::uint64_t> m_cache_misses {0};
+};
+
+
+// returns the search score at ply of a position with a tablebase value, see TABLEBASE_WIN_SCORE
+// the side to move must have a move, a side that has none has already lost and scores lossScore()
+inline int getTablebaseScore(TablebaseValue value, const Bitboard &board, bool is_whites_turn, int ply) {
+	const int my_pieces = popcount(is_whites_turn ? board.white_pieces : board.black_pieces);
+	const int their_pieces = popcount(is_whites_turn ? board.black_pieces : board.white_pieces);
+	const int material = std::min(std::max(my_pieces - their_pieces, -MAX_TABLEBASE_MATERIAL), MAX_TABLEBASE_MATERIAL);
+
+	if (value == TB_WIN) {
+		return TABLEBASE_WIN_SCORE - ply - TABLEBASE_MATERIAL_STEP * (MAX_TABLEBASE_MATERIAL - material);
+	} else if (value == TB_LOSS) {
+		return -(TABLEBASE_WIN_SCORE - ply - TABLEBASE_MATERIAL_STEP * (MAX_TABLEBASE_MATERIAL + material));
+	}
+	return DRAW_SCORE;
+}
+
+
+// returns the search score of a leaf with as many pieces as the root given its tablebase value, if there is one,
+// and evaluation, its evaluation for the side to move, see KNOWN_WIN_SCORE
+inline int getKnownResultScore(TablebaseValue value, int evaluation) {
+	evaluation = std::min(std::max(evaluation, -MAX_KNOWN_WIN_EVALUATION), MAX_KNOWN_WIN_EVALUATION);
+
+	if (value == TB_WIN) {
+		return KNOWN_WIN_SCORE + evaluation;
+	} else if (value == TB_LOSS) {
+		return -KNOWN_WIN_SCORE + evaluation;
+	} else if (value == TB_DRAW) {
+		return DRAW_SCORE;
+	}
+	return evaluation;
+}
+
+
+#endif // TABLEBASE_PROBE_H
@@ -0,0 +1,84 @@
+#include "engine/transposition_table.h"
+
+#include <cstdint>
+
+
+// data word layout, from the lowest bit
+static constexpr int SCORE_SHIFT = 0; // 32 bits
+static constexpr int DEPTH_SHIFT = 32; // 8 bits
+static constexpr int BOUND_SHIFT = 40; // 2 bits
+static constexpr int MOVE_SHIFT = 42; // 8 bits
+static constexpr int USED_SHIFT = 50; // 1 bit, so an empty slot never matches a hash of zero
+
+
+// the number of slots is rounded down to a power of two so a slot can be found with a mask
+TranspositionTable::TranspositionTable(int size_mb) {
+	std::size_t max_slots = (static_cast<std::size_t>(size_mb > 0 ? size_mb : 1) << 20) / sizeof(Slot);
+	std::size_t num_slots = 1;
+
+	while (num_slots * 2 <= max_slots) {
+		num_slots *= 2;
+	}
+
+	m_slots.reset(new Slot[num_slots]);
+	m_index_mask = num_slots - 1;
+
+	clear();
+}
+
+
+// returns false if the position isn't in the table
+bool TranspositionTable::probe(u64 hash, Entry *entry) const {
+	const Slot &slot = m_slots[hash & m_index_mask];
+
+	u64 data = slot.data.load(std::memory_order_relaxed);
+	u64 key = slot.key_xor_data.load(std::memory_order_relaxed) ^ data;
+
+	if (key != hash || ((data >> USED_SHIFT) & 1) == 0) {
+		return false;
+	}
+
+	entry->score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data >> SCORE_SHIFT));
+	entry->depth = static_cast<int>((data >> DEPTH_SHIFT) & 0xff);
+	entry->bound = static_cast<Bound>((data >> BOUND_SHIFT) & 0x3);
+	entry->best_move_index = static_cast<int>((data >> MOVE_SHIFT) & 0xff);
+
+	return true;
+}
+
+
+// results for other positions are always replaced, as they are probably from an older search,
+// but a deeper result for the same position is kept
+void TranspositionTable::store(u64 hash, const Entry &entry) {
+	Slot &slot = m_slots[hash & m_index_mask];
+
+	u64 old_data = slot.data.load(std::memory_order_relaxed);
+	u64 old_key = slot.key_xor_data.load(std::memory_order_relaxed) ^ old_data;
+
+	if (old_key == hash && static_cast<int>((old_data >> DEPTH_SHIFT) & 0xff) > entry.depth) {
+		return;
+	}
+
+	u64 data = (static_cast<u64>(static_cast<std::uint32_t>(entry.score)) << SCORE_SHIFT)
+		| (static_cast<u64>(entry.depth & 0xff) << DEPTH_SHIFT)
+		| (static_cast<u64>(entry.bound) << BOUND_SHIFT)
+		| (static_cast<u64>(entry.best_move_index & 0xff) << MOVE_SHIFT)
+		| (u64(1) << USED_SHIFT);
+
+	slot.key_xor_data.store(hash ^ data, std::memory_order_relaxed);
+	slot.data.store(data, std::memory_order_relaxed);
+}
+
+
+// not safe to call while another thread is using the table
+void TranspositionTable::clear() {
+	for (u64 i = 0; i <= m_index_mask; i++) {
+		m_slots[i].key_xor_data.store(0, std::memory_order_relaxed);
+		m_slots[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+
+std::size_t TranspositionTable::getSizeBytes() const {
+	return (m_index_mask + 1) * sizeof(Slot);
+}
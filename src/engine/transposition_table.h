@@ -0,0 +1,52 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+
+#include "engine/bitboard.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+// results of earlier searches, indexed by zobrist hash
+// a table can be shared by engines searching on different threads without any locking:
+// each entry is stored as two words with the key xored into the data, so an entry torn by
+// two threads writing at once no longer matches its key and is ignored
+class TranspositionTable {
+public:
+	enum Bound {
+		EXACT, // score fell inside the window
+		LOWER, // score was at least beta
+		UPPER, // score was at most alpha
+	};
+
+	struct Entry {
+		int score;
+		int depth;
+		Bound bound;
+		int best_move_index; // in the order the moves are generated, NO_MOVE if there isn't one
+	};
+
+	static constexpr int NO_MOVE = 255;
+
+	explicit TranspositionTable(int size_mb);
+
+	bool probe(u64 hash, Entry *entry) const;
+	void store(u64 hash, const Entry &entry);
+	void clear();
+
+	std::size_t getSizeBytes() const;
+
+private:
+	struct Slot {
+		std::atomic<u64> key_xor_data;
+		std::atomic<u64> data;
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	u64 m_index_mask;
+};
+
+
+#endif // TRANSPOSITION_TABLE_H
@@ -0,0 +1,61 @@
+#include "engine/zobrist.h"
+
+
+// black men, black kings, white men, white kings
+static constexpr int NUM_PIECE_TYPES = 4;
+
+
+struct ZobristKeys {
+	u64 pieces[NUM_PIECE_TYPES][32];
+	u64 white_to_move;
+};
+
+
+// splitmix64 generator, used so that the keys are identical on every platform and every run
+// (hashes get written to files, so they must be reproducible)
+static constexpr u64 nextRandom(u64 &state) {
+	state += 0x9e37'79b9'7f4a'7c15;
+	u64 z = state;
+	z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+	z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+	return z ^ (z >> 31);
+}
+
+
+static constexpr ZobristKeys generateKeys() {
+	ZobristKeys keys {};
+	u64 state = 0x636b'7273'2020'2020; // "ckrs    "
+
+	for (int type = 0; type < NUM_PIECE_TYPES; type++) {
+		for (int position = 0; position < 32; position++) {
+			keys.pieces[type][position] = nextRandom(state);
+		}
+	}
+	keys.white_to_move = nextRandom(state);
+
+	return keys;
+}
+
+
+static constexpr ZobristKeys zobrist_keys = generateKeys();
+
+
+// returns a 64 bit hash of the board and side to move
+u64 hashBitboard(const Bitboard &board, bool is_whites_turn) {
+	const u32 piece_masks[NUM_PIECE_TYPES] = {
+		board.black_pieces & ~board.king_pieces,
+		board.black_pieces & board.king_pieces,
+		board.white_pieces & ~board.king_pieces,
+		board.white_pieces & board.king_pieces,
+	};
+
+	u64 hash = is_whites_turn ? zobrist_keys.white_to_move : 0;
+
+	for (int type = 0; type < NUM_PIECE_TYPES; type++) {
+		for (u32 pieces = piece_masks[type]; pieces; pieces &= pieces - 1) {
+			hash ^= zobrist_keys.pieces[type][lsbIndex(pieces)];
+		}
+	}
+
+	return hash;
+}
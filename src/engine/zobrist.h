@@ -0,0 +1,11 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+
+#include "engine/bitboard.h"
+
+
+u64 hashBitboard(const Bitboard &board, bool is_whites_turn);
+
+
+#endif // ZOBRIST_H
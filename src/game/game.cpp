@@ -5,7 +5,7 @@
 #include "game/movegen.h"
 #include "game/position.h"
 
-#include <algorithm> // for std::find
+#include <algorithm> // for std::find, std::max
 
 
 // set up the board and member variables for a new game and set match type
@@ -27,6 +27,7 @@ void Game::newGame(MatchType match_type) {
 	m_match_type = match_type;
 
 	m_moves = MoveGen::generateMoves(m_board, m_turn);
+	m_history.assign(1, m_board);
 }
 
 
@@ -37,7 +38,13 @@ bool Game::doMove(const Move &move) {
 		return false; // move was not in the valid moves list
 	}
 	
+	// captures and men moving can't be undone, so the positions before them won't be seen again
+	if (move.isJump() || !m_board.pieceAt(move.getStartPosition()).isCrowned()) {
+		m_history.clear();
+	}
+	
 	m_board = MoveGen::getBoardAfterMove(m_board, move);
+	m_history.push_back(m_board);
 	
 	// switch turns
 	if (m_turn == Turn::BLACK) {
@@ -53,20 +60,26 @@ bool Game::doMove(const Move &move) {
 
 
 // set board and update moves available
+// the position history starts again from the new board
 void Game::setBoard(const Board &board) {
 	if (!(board == m_board)) {
 		m_board = board;
 		m_moves = MoveGen::generateMoves(m_board, m_turn);
 	}
+	
+	m_history.assign(1, m_board);
 }
 
 
 // set turn and update moves available if different
+// the position history starts again from the new position
 void Game::setTurn(Turn turn) {
 	if (turn != m_turn) {
 		m_turn = turn;
 		m_moves = MoveGen::generateMoves(m_board, m_turn);
 	}
+	
+	m_history.assign(1, m_board);
 }
 
 
@@ -75,6 +88,12 @@ void Game::setMatchType(MatchType match_type) {
 }
 
 
+// sets how many plies in a row without a capture or a man moving draw the game, 0 for no limit
+void Game::setNoProgressLimit(int plies) {
+	m_no_progress_limit = plies;
+}
+
+
 const Board& Game::getBoard() const {
 	return m_board;
 }
@@ -95,8 +114,39 @@ MatchType Game::getMatchType() const {
 }
 
 
+// the game is over when the side to move has no moves, in which case it has lost, or when it is drawn
 bool Game::isOver() const {
-	return m_moves.empty();
+	return m_moves.empty() || isDraw();
+}
+
+
+// returns true if the current position has been reached three times with the same side to move,
+// or if the no progress limit has been reached
+bool Game::isDraw() const {
+	if (m_no_progress_limit > 0 && getPliesSinceProgress() >= m_no_progress_limit) {
+		return true;
+	}
+	
+	// the side to move alternates, so only every other position can be the same as the current one
+	int repetitions = 0;
+	for (int i = static_cast<int>(m_history.size()) - 1; i >= 0; i -= 2) {
+		if (m_history[i] == m_board) {
+			repetitions++;
+		}
+	}
+	
+	return repetitions >= REPETITIONS_FOR_DRAW;
+}
+
+
+// returns the number of plies since the last capture or man move, or since the position was set up
+int Game::getPliesSinceProgress() const {
+	return std::max(static_cast<int>(m_history.size()) - 1, 0);
+}
+
+
+const std::vector<Board>& Game::getPositionHistory() const {
+	return m_history;
 }
 
 
@@ -19,12 +19,16 @@ public:
 	void setBoard(const Board &board);
 	void setTurn(Turn turn);
 	void setMatchType(MatchType match_type);
+	void setNoProgressLimit(int plies);
 
 	const Board& getBoard() const;
 	Turn getTurn() const;
 	const std::vector<Move>& getAvailableMoves() const;
 	MatchType getMatchType() const;
 	bool isOver() const;
+	bool isDraw() const;
+	int getPliesSinceProgress() const;
+	const std::vector<Board>& getPositionHistory() const;
 	Player getPlayerType(Turn turn) const;
 	bool requiresEngine() const;
 
@@ -34,6 +38,14 @@ private:
 	MatchType m_match_type {};
 	
 	std::vector<Move> m_moves;
+
+	// positions reached since the last capture or man move, oldest first and ending with the current one
+	// none of the positions before that can ever be reached again
+	std::vector<Board> m_history;
+	int m_no_progress_limit = DEFAULT_NO_PROGRESS_LIMIT;
+
+	static constexpr int DEFAULT_NO_PROGRESS_LIMIT = 80; // 40 moves each
+	static constexpr int REPETITIONS_FOR_DRAW = 3;
 };
 
 
@@ -0,0 +1,161 @@
+#include "game/notation.h"
+
+#include "game/board.h"
+#include "game/move.h"
+#include "game/piece.h"
+#include "game/position.h"
+#include "game/turn.h"
+
+#include <cctype>
+#include <cstdlib>
+
+
+// returns the move written like "11-15" or "15x24x31"
+std::string Notation::getMoveString(const Move &move) {
+	std::string output;
+
+	for (int i = 0; i < move.getLength(); i++) {
+		if (i > 0) {
+			output += (move.isJump() ? 'x' : '-');
+		}
+		output += std::to_string(move.getPosition(i) + 1);
+	}
+
+	return output;
+}
+
+
+// returns the move in moves_available written as move_string, or nullptr if there isn't one
+const Move* Notation::findMove(const std::string &move_string, const std::vector<Move> &moves_available) {
+	for (const Move &move : moves_available) {
+		if (getMoveString(move) == move_string) {
+			return &move;
+		}
+	}
+	return nullptr;
+}
+
+
+// parses a position in FEN, eg. "B:W21,22,K30:B1-12"
+// the first field is the side to move, followed by a field listing each side's pieces,
+// with kings prefixed by K and runs of squares written as ranges
+// returns false and leaves board and turn unchanged if the FEN is invalid
+bool Notation::parseFen(const std::string &fen, Board *board, Turn *turn) {
+	std::string::size_type field_end = fen.find(':');
+	if (field_end != 1 || (fen[0] != 'B' && fen[0] != 'W')) {
+		return false;
+	}
+
+	Board parsed_board;
+	Turn parsed_turn = (fen[0] == 'B') ? Turn::BLACK : Turn::WHITE;
+
+	while (field_end != std::string::npos) {
+		std::string::size_type field_start = field_end + 1;
+		field_end = fen.find(':', field_start);
+
+		std::string field = fen.substr(field_start, field_end == std::string::npos ? std::string::npos : field_end - field_start);
+
+		// a trailing full stop is allowed by the PDN standard
+		if (field_end == std::string::npos && !field.empty() && field.back() == '.') {
+			field.pop_back();
+		}
+
+		if (!parseFenPieces(field, &parsed_board)) {
+			return false;
+		}
+	}
+
+	*board = parsed_board;
+	*turn = parsed_turn;
+
+	return true;
+}
+
+
+// returns the FEN of the position, listing squares individually
+std::string Notation::getFen(const Board &board, Turn turn) {
+	std::string output = (turn == Turn::BLACK) ? "B" : "W";
+
+	for (Turn side : {Turn::WHITE, Turn::BLACK}) {
+		output += (side == Turn::BLACK) ? ":B" : ":W";
+
+		bool first = true;
+
+		for (Position position : Position::ALL_POSITIONS) {
+			const Piece &piece = board.pieceAt(position);
+
+			if (piece.exists() && piece.belongsTo(side)) {
+				if (!first) {
+					output += ',';
+				}
+				if (piece.isCrowned()) {
+					output += 'K';
+				}
+				output += std::to_string(position + 1);
+				first = false;
+			}
+		}
+	}
+
+	return output;
+}
+
+
+// adds the pieces of a field such as "WK3,5-8" to board
+bool Notation::parseFenPieces(const std::string &field, Board *board) {
+	if (field.empty() || (field[0] != 'B' && field[0] != 'W')) {
+		return false;
+	}
+
+	const bool is_black = (field[0] == 'B');
+	std::string::size_type i = 1;
+
+	while (i < field.length()) {
+		bool is_king = false;
+		if (field[i] == 'K') {
+			is_king = true;
+			i++;
+		}
+
+		if (i >= field.length() || !std::isdigit(static_cast<unsigned char>(field[i]))) {
+			return false;
+		}
+
+		char *end;
+		int first_square = static_cast<int>(std::strtol(field.c_str() + i, &end, 10));
+		int last_square = first_square;
+		i = end - field.c_str();
+
+		if (i < field.length() && field[i] == '-') {
+			i++;
+			if (i >= field.length() || !std::isdigit(static_cast<unsigned char>(field[i]))) {
+				return false;
+			}
+			last_square = static_cast<int>(std::strtol(field.c_str() + i, &end, 10));
+			i = end - field.c_str();
+		}
+
+		if (first_square < 1 || last_square > 32 || first_square > last_square) {
+			return false;
+		}
+
+		for (int square = first_square; square <= last_square; square++) {
+			Piece::Type type;
+			if (is_black) {
+				type = is_king ? Piece::BLACK_KING : Piece::BLACK_MAN;
+			} else {
+				type = is_king ? Piece::WHITE_KING : Piece::WHITE_MAN;
+			}
+			board->pieceAt(Position(square - 1)) = type;
+		}
+
+		if (i < field.length()) {
+			if (field[i] != ',') {
+				return false;
+			}
+			i++;
+		}
+	}
+
+	return true;
+}
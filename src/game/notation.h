@@ -0,0 +1,29 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+
+class Board;
+class Move;
+enum class Turn;
+
+#include <string>
+#include <vector>
+
+
+// conversions to and from the text formats used outside the program
+// squares are numbered 1 to 32, which is position index + 1
+class Notation {
+public:
+	Notation() = delete;
+
+	static std::string getMoveString(const Move &move);
+	static const Move* findMove(const std::string &move_string, const std::vector<Move> &moves_available);
+	static bool parseFen(const std::string &fen, Board *board, Turn *turn);
+	static std::string getFen(const Board &board, Turn turn);
+
+private:
+	static bool parseFenPieces(const std::string &field, Board *board);
+};
+
+
+#endif // NOTATION_H
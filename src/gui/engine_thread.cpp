@@ -15,12 +15,19 @@ EngineThread::EngineThread(GuiGameData *gui_game_data, QObject *parent) :
 {
 	qRegisterMetaType<Game>("Game");
 	qRegisterMetaType<Move>("Move");
+	qRegisterMetaType<SearchInfo>("SearchInfo");
 
 	connect(&m_engine_thread_controller, &EngineThreadController::finishedProcessing, this, &EngineThread::makeMove);
+	connect(&m_engine_thread_controller, &EngineThreadController::analysisUpdated, this, &EngineThread::analysisUpdated);
 }
 
 
+// called whenever the position changes
 void EngineThread::makeMovePerhaps() {
+	if (m_analysing) {
+		setAnalysing(true); // of the new position
+	}
+
 	if (!m_game->isOver()) {
 		if (m_game->getPlayerType(m_game->getTurn()) == Player::COMPUTER) {
 			//Move best_move = m_engine.findBestMove(*m_game);
@@ -31,6 +38,18 @@ void EngineThread::makeMovePerhaps() {
 }
 
 
+// starts or stops analysing the current position
+void EngineThread::setAnalysing(bool analysing) {
+	m_analysing = analysing;
+
+	if (analysing && !m_game->isOver()) {
+		m_engine_thread_controller.startAnalysis(*m_game);
+	} else {
+		m_engine_thread_controller.stopAnalysis();
+	}
+}
+
+
 void EngineThread::makeMove(const Move &move) {
 	m_game->doMove(move);
 	*m_board = m_game->getBoard();
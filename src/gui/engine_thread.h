@@ -21,9 +21,11 @@ public:
 
 public slots:
 	void makeMovePerhaps();
+	void setAnalysing(bool analysing);
 
 signals:
 	void engineMoveMade();
+	void analysisUpdated(const SearchInfo &info);
 
 protected:
 	//void run() override; // not used to event loop is started by default
@@ -37,6 +39,8 @@ private:
 
 	Engine m_engine;
 	EngineThreadController m_engine_thread_controller;
+
+	bool m_analysing = false;
 };
 
 
@@ -9,6 +9,9 @@ EngineThreadController::EngineThreadController(Engine *engine) {
     connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
     connect(this, &EngineThreadController::operate, worker, &EngineThreadWorker::findBestMove);
     connect(worker, &EngineThreadWorker::bestMoveFound, this, &EngineThreadController::handleResults);
+    connect(this, &EngineThreadController::startAnalysis, worker, &EngineThreadWorker::startAnalysis);
+    connect(this, &EngineThreadController::stopAnalysis, worker, &EngineThreadWorker::stopAnalysis);
+    connect(worker, &EngineThreadWorker::analysisUpdated, this, &EngineThreadController::analysisUpdated);
     workerThread.start();
 }
 
@@ -9,6 +9,7 @@
 class Game;
 class Engine;
 class Move;
+struct SearchInfo;
 
 
 class EngineThreadController : public QObject {
@@ -27,6 +28,9 @@ public slots:
 signals:
 	void operate(const Game &game);
 	void finishedProcessing(const Move &move);
+	void startAnalysis(const Game &game);
+	void stopAnalysis();
+	void analysisUpdated(const SearchInfo &info);
 };
 
 
@@ -1,13 +1,85 @@
 #include "gui/engine_thread_worker.h"
 
 #include "game/game.h"
+#include "game/move.h"
+#include "game/player.h"
+#include "game/turn.h"
 #include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/conversion.h"
 
 #include <QThread>
 
 
+// how often the analysis is checked for updates
+static constexpr int ANALYSIS_POLL_INTERVAL_MS = 100;
+
+// the analysis only ever searches one position at a time, so it makes do with a small table
+static constexpr int ANALYSIS_HASH_SIZE_MB = 4;
+
+
+// the options of the game's engine, less the search tree file, which only the game's engine writes
+static EngineOptions getAnalysisOptions() {
+	EngineOptions options = Engine::getDefaultOptions();
+	options.record_tree_file.clear();
+	options.hash_size_mb = ANALYSIS_HASH_SIZE_MB;
+	return options;
+}
+
+
+EngineThreadWorker::EngineThreadWorker(Engine *engine) :
+	m_engine(engine),
+	m_ponderer(engine),
+	m_analysis_engine(getAnalysisOptions())
+{
+	m_analysis_timer.setInterval(ANALYSIS_POLL_INTERVAL_MS);
+	connect(&m_analysis_timer, &QTimer::timeout, this, &EngineThreadWorker::pollAnalysis);
+}
+
+
 void EngineThreadWorker::findBestMove(const Game &game) {
-	Move best_move = m_engine->findBestMove(game);
+	SearchInfo info;
+
+	// if the human played the expected reply, the search started on their time only has to finish
+	if (!m_ponderer.finish(game, &info)) {
+		info = m_engine->search(game, SearchLimits());
+	}
+
+	Move best_move = convertCompactMoveToNormalMove(info.best_move);
+
+	Game next_game = game;
+	if (best_move.exists() && next_game.doMove(best_move) && !next_game.isOver()
+			&& next_game.getPlayerType(next_game.getTurn()) == Player::HUMAN) {
+		m_ponderer.start(next_game, info.ponder_move, SearchLimits());
+	}
 
 	emit bestMoveFound(best_move);
 }
+
+
+// analyses the game's position until stopped or given another position
+void EngineThreadWorker::startAnalysis(const Game &game) {
+	m_analysis.start(game);
+	m_analysis_timer.start();
+}
+
+
+void EngineThreadWorker::stopAnalysis() {
+	m_analysis_timer.stop();
+	m_analysis.stop();
+}
+
+
+// passes on only the newest update, the older ones would just be drawn over straight away
+void EngineThreadWorker::pollAnalysis() {
+	SearchInfo info;
+	bool updated = false;
+
+	while (m_analysis.poll(&info)) {
+		updated = true;
+	}
+
+	if (updated) {
+		emit analysisUpdated(info);
+	}
+}
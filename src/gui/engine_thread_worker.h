@@ -3,8 +3,11 @@
 
 
 #include "engine/engine.h"
+#include "engine/ponderer.h"
+#include "engine/analysis.h"
 
 #include <QThread>
+#include <QTimer>
 
 
 class Game;
@@ -15,17 +18,28 @@ class EngineThreadWorker : public QObject {
 	Q_OBJECT
 
 public:
-	EngineThreadWorker(Engine *engine) : m_engine(engine)
-	{}
+	EngineThreadWorker(Engine *engine);
 
 public slots:
 	void findBestMove(const Game &game);
+	void startAnalysis(const Game &game);
+	void stopAnalysis();
 
 signals:
 	void bestMoveFound(const Move &best_move);
+	void analysisUpdated(const SearchInfo &info);
+
+private slots:
+	void pollAnalysis();
 
 private:
 	Engine *m_engine;
+	Ponderer m_ponderer; // searches the expected reply while the human is thinking
+
+	// analysis has an engine of its own so it can carry on while the computer is choosing its move
+	Engine m_analysis_engine;
+	Analysis m_analysis {&m_analysis_engine};
+	QTimer m_analysis_timer {this}; // a child so it moves to the worker's thread along with it
 };
 
 
@@ -1,11 +1,69 @@
 #include "gui/main_window.h"
 
 #include "gui/render_area.h"
+#include "gui/engine_thread.h"
+#include "engine/engine.h"
+#include "engine/conversion.h"
+#include "engine/score.h"
+#include "game/notation.h"
+
+#include <QAction>
+#include <QMenuBar>
+#include <QStatusBar>
 
 
 MainWindow::MainWindow() {
 	setWindowTitle(tr("Checkers Game"));
 	RenderArea *render_area = new RenderArea(this, &m_game_manager);
 	setCentralWidget(render_area);
+
+	m_analyse_action = menuBar()->addMenu(tr("&Engine"))->addAction(tr("&Analyse"));
+	m_analyse_action->setCheckable(true);
+	m_analyse_action->setShortcut(Qt::Key_A);
+	connect(m_analyse_action, &QAction::toggled, this, &MainWindow::toggleAnalysis);
+
+	connect(m_game_manager.getEngineThreadPtr(), &EngineThread::analysisUpdated,
+		this, &MainWindow::showAnalysis, Qt::QueuedConnection);
+
 	m_game_manager.startGame();
 }
+
+
+void MainWindow::toggleAnalysis(bool analysing) {
+	m_game_manager.getEngineThreadPtr()->setAnalysing(analysing);
+
+	if (analysing) {
+		statusBar()->showMessage(tr("Analysing..."));
+	} else {
+		statusBar()->clearMessage();
+	}
+}
+
+
+// shows the depth, score and best line of the analysis in the status bar
+// updates still on their way when the analysis is turned off are ignored
+void MainWindow::showAnalysis(const SearchInfo &info) {
+	if (!m_analyse_action->isChecked()) {
+		return;
+	}
+
+	QString line;
+	for (int i = 0; i < info.pv_length; i++) {
+		line += QLatin1Char(' ');
+		line += QString::fromStdString(Notation::getMoveString(convertCompactMoveToNormalMove(info.pv[i])));
+	}
+
+	QString score = QString::number(info.score);
+	if (isDecidedScore(info.score)) {
+		score = (info.score > 0 ? tr("win in %1") : tr("loss in %1")).arg(getPliesToEnd(info.score));
+	} else if (isTablebaseScore(info.score)) {
+		score = (info.score > 0) ? tr("tablebase win") : tr("tablebase loss");
+	} else if (isKnownResultScore(info.score)) {
+		score = (info.score > 0) ? tr("known win") : tr("known loss");
+	}
+
+	std::uint64_t nps = info.time_ms > 0 ? info.nodes * 1000 / info.time_ms : 0;
+
+	statusBar()->showMessage(tr("Depth %1  Score %2  %3 kN/s  %4")
+		.arg(info.depth).arg(score).arg(nps / 1000).arg(line.trimmed()));
+}
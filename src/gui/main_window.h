@@ -7,14 +7,23 @@
 #include <QMainWindow>
 
 
+class QAction;
+struct SearchInfo;
+
+
 class MainWindow : public QMainWindow {
 	Q_OBJECT
 
 public:
 	MainWindow();
 
+private slots:
+	void toggleAnalysis(bool analysing);
+	void showAnalysis(const SearchInfo &info);
+
 private:
 	GameManager m_game_manager;
+	QAction *m_analyse_action;
 };
 
 
@@ -0,0 +1,192 @@
+#include "perft/perft.h"
+
+#include "game/board.h"
+#include "game/move.h"
+#include "game/notation.h"
+#include "game/turn.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/bitboard_unmovegen.h"
+#include "engine/compact_move.h"
+#include "engine/conversion.h"
+
+#include <algorithm> // for std::max
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+static constexpr int DEFAULT_DEPTH = 8;
+
+
+static bool isSamePosition(const Bitboard &a, const Bitboard &b) {
+	return a.black_pieces == b.black_pieces && a.white_pieces == b.white_pieces && a.king_pieces == b.king_pieces;
+}
+
+
+static int countPosition(const Bitboard *positions, int num_positions, const Bitboard &position) {
+	int count = 0;
+	for (int i = 0; i < num_positions; i++) {
+		count += isSamePosition(positions[i], position);
+	}
+	return count;
+}
+
+
+/**
+ * Counts the positions reachable at each depth up to the one given after --perft,
+ * from the starting position or the one given after --fen.
+ * With --divide the count at the final depth is also broken down by first move.
+ * With --unmoves the positions before every position reached are also found with
+ * generateUnmoves() and checked against the moves generateMoves() finds from them.
+ * @return Zero, or one if the arguments are invalid or the unmoves disagree with the moves.
+ */
+int Perft::run(int argc, char *argv[]) {
+	int max_depth = DEFAULT_DEPTH;
+	std::string fen = "B:W21-32:B1-12";
+	bool divide = false;
+	bool check_unmoves = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--perft") == 0 && i + 1 < argc && argv[i + 1][0] != '-') {
+			max_depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--fen") == 0 && i + 1 < argc) {
+			fen = argv[++i];
+		} else if (std::strcmp(argv[i], "--divide") == 0) {
+			divide = true;
+		} else if (std::strcmp(argv[i], "--unmoves") == 0) {
+			check_unmoves = true;
+		}
+	}
+
+	Board board;
+	Turn turn;
+
+	if (!Notation::parseFen(fen, &board, &turn)) {
+		std::cerr << "Invalid FEN: " << fen << '\n';
+		return 1;
+	}
+
+	Bitboard bitboard = convertBoardToBitboard(board);
+	bool is_whites_turn = (turn == Turn::WHITE);
+
+	std::cout << std::setw(5) << "depth" << std::setw(16) << "positions"
+		<< std::setw(12) << "time (s)" << std::setw(14) << "positions/s" << '\n';
+
+	for (int depth = 1; depth <= max_depth; depth++) {
+		auto start = std::chrono::steady_clock::now();
+		std::uint64_t leaves = countLeaves(bitboard, is_whites_turn, depth);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << std::setw(5) << depth << std::setw(16) << leaves
+			<< std::setw(12) << std::fixed << std::setprecision(3) << seconds
+			<< std::setw(14) << std::setprecision(0) << (seconds > 0 ? leaves / seconds : 0.0) << '\n';
+	}
+
+	if (divide && max_depth > 0) {
+		printDivide(bitboard, is_whites_turn, max_depth);
+	}
+
+	if (check_unmoves && max_depth > 0) {
+		std::vector<Bitboard> previous_positions;
+		std::uint64_t mismatches = checkUnmoves(bitboard, is_whites_turn, max_depth, &previous_positions);
+
+		std::cout << "\nunmoves: " << mismatches << " positions disagree with the moves\n";
+		if (mismatches > 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Counts the positions reached after exactly depth plies.
+ */
+std::uint64_t Perft::countLeaves(const Bitboard &board, bool is_whites_turn, int depth) {
+	Bitboard next_positions[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, nullptr);
+
+	if (depth == 1) {
+		return moves_found;
+	}
+
+	std::uint64_t leaves = 0;
+	for (int i = 0; i < moves_found; i++) {
+		leaves += countLeaves(next_positions[i], !is_whites_turn, depth - 1);
+	}
+
+	return leaves;
+}
+
+
+/**
+ * Prints the number of positions at depth that follow each of the moves available.
+ */
+void Perft::printDivide(const Bitboard &board, bool is_whites_turn, int depth) {
+	Bitboard next_positions[MAX_MOVES];
+	CompactMove moves[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, moves);
+
+	std::cout << '\n';
+
+	for (int i = 0; i < moves_found; i++) {
+		std::uint64_t leaves = depth > 1 ? countLeaves(next_positions[i], !is_whites_turn, depth - 1) : 1;
+		std::cout << std::setw(10) << Notation::getMoveString(convertCompactMoveToNormalMove(moves[i]))
+			<< std::setw(16) << leaves << '\n';
+	}
+}
+
+
+/**
+ * Checks that every move from board, and every move in the tree below it down to depth plies, is undone
+ * by generateUnmoves() as many times as generateMoves() finds it, and that every position generateUnmoves()
+ * finds before each position reached leads to it by a move that many times.
+ * @return The number of positions reached where they disagree.
+ */
+std::uint64_t Perft::checkUnmoves(const Bitboard &board, bool is_whites_turn, int depth,
+		std::vector<Bitboard> *previous_positions) {
+	Bitboard next_positions[MAX_MOVES];
+	int moves_found = generateMoves(board, is_whites_turn, next_positions, nullptr);
+
+	// only undo captures as long as the longest one from board, so that kings don't go a long way round
+	const u32 their_pieces = is_whites_turn ? board.black_pieces : board.white_pieces;
+	int max_captures = 0;
+	for (int i = 0; i < moves_found; i++) {
+		const u32 their_pieces_after = is_whites_turn ? next_positions[i].black_pieces : next_positions[i].white_pieces;
+		max_captures = std::max(max_captures, popcount(their_pieces) - popcount(their_pieces_after));
+	}
+
+	std::uint64_t mismatches = 0;
+
+	for (int i = 0; i < moves_found; i++) {
+		const Bitboard &child = next_positions[i];
+		generateUnmoves(child, !is_whites_turn, max_captures, previous_positions);
+
+		bool agrees = countPosition(previous_positions->data(), static_cast<int>(previous_positions->size()), board)
+			== countPosition(next_positions, moves_found, child);
+
+		for (std::size_t j = 0; j < previous_positions->size() && agrees; j++) {
+			const Bitboard &previous = (*previous_positions)[j];
+			const int times_found = countPosition(previous_positions->data(), static_cast<int>(previous_positions->size()), previous);
+
+			Bitboard positions[MAX_MOVES];
+			int positions_found = generateMoves(previous, is_whites_turn, positions, nullptr);
+			agrees = countPosition(positions, positions_found, child) == times_found;
+		}
+
+		if (!agrees) {
+			mismatches++;
+		}
+
+		if (depth > 1) {
+			mismatches += checkUnmoves(child, !is_whites_turn, depth - 1, previous_positions);
+		}
+	}
+
+	return mismatches;
+}
@@ -0,0 +1,23 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+
+#include "engine/bitboard.h"
+
+#include <cstdint>
+#include <vector>
+
+
+class Perft {
+public:
+	int run(int argc, char *argv[]);
+
+private:
+	static std::uint64_t countLeaves(const Bitboard &board, bool is_whites_turn, int depth);
+	static void printDivide(const Bitboard &board, bool is_whites_turn, int depth);
+	static std::uint64_t checkUnmoves(const Bitboard &board, bool is_whites_turn, int depth,
+		std::vector<Bitboard> *previous_positions);
+};
+
+
+#endif // PERFT_H
@@ -0,0 +1,315 @@
+#include "protocol/protocol.h"
+
+#include "game/board.h"
+#include "game/matchtype.h"
+#include "game/move.h"
+#include "game/notation.h"
+#include "game/turn.h"
+#include "engine/conversion.h"
+#include "engine/score.h"
+
+#include <algorithm> // for std::max
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+
+Protocol::~Protocol() {
+	stopSearch();
+}
+
+
+/**
+ * Reads commands from stdin until quit is received or the input ends.
+ */
+int Protocol::run(int argc, char *argv[]) {
+	(void) argc; // the engine options were already read by main()
+	(void) argv;
+
+	m_game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+	m_engine.setInfoCallback([this](const SearchInfo &info) { printInfo(info); });
+
+	std::string line;
+
+	while (std::getline(std::cin, line)) {
+		if (!handleCommand(line)) {
+			break;
+		}
+	}
+
+	stopSearch();
+
+	return 0;
+}
+
+
+/**
+ * Carries out a single command.
+ * @param line The command and its arguments.
+ * @return False if the protocol should exit.
+ */
+bool Protocol::handleCommand(const std::string &line) {
+	std::istringstream arguments(line);
+	std::string command;
+
+	if (!(arguments >> command)) {
+		return true; // blank line
+	}
+
+	if (command == "quit") {
+		return false;
+	} else if (command == "stop") {
+		stopSearch();
+	} else if (command == "ponderhit") {
+		m_ponder = false;
+	} else if (command == "isready") {
+		send("readyok");
+	} else if (m_searching) {
+		send("error " + command + " is not allowed during a search");
+	} else if (command == "position") {
+		handlePosition(arguments);
+	} else if (command == "moves") {
+		handleMoves(arguments);
+	} else if (command == "go") {
+		handleGo(arguments);
+	} else if (command == "setoption") {
+		handleSetOption(arguments);
+	} else {
+		send("error unknown command " + command);
+	}
+
+	return true;
+}
+
+
+/**
+ * Sets up a new position: "startpos" or "fen FEN", optionally followed by "moves" and a list of moves.
+ * The current position is only replaced if the whole command is valid.
+ */
+void Protocol::handlePosition(std::istringstream &arguments) {
+	Game game;
+	game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+
+	std::string type;
+	arguments >> type;
+
+	if (type == "fen") {
+		std::string fen;
+		Board board;
+		Turn turn;
+
+		if (!(arguments >> fen) || !Notation::parseFen(fen, &board, &turn)) {
+			send("error invalid fen");
+			return;
+		}
+
+		game.setTurn(turn);
+		game.setBoard(board);
+	} else if (type != "startpos") {
+		send("error position needs startpos or fen");
+		return;
+	}
+
+	std::string keyword;
+	if (arguments >> keyword) {
+		if (keyword != "moves") {
+			send("error unexpected " + keyword);
+			return;
+		}
+		if (!applyMoves(arguments, &game)) {
+			return;
+		}
+	}
+
+	m_game = game;
+}
+
+
+/**
+ * Plays a list of moves on the current position.
+ */
+void Protocol::handleMoves(std::istringstream &arguments) {
+	Game game = m_game;
+
+	if (applyMoves(arguments, &game)) {
+		m_game = game;
+	}
+}
+
+
+/**
+ * Starts a search of the current position on another thread.
+ * The best move is sent when the search finishes or is stopped.
+ */
+void Protocol::handleGo(std::istringstream &arguments) {
+	SearchLimits limits;
+	bool ponder = false;
+	std::string name;
+
+	while (arguments >> name) {
+		if (name == "depth") {
+			arguments >> limits.depth;
+		} else if (name == "nodes") {
+			arguments >> limits.nodes;
+		} else if (name == "movetime") {
+			arguments >> limits.time_ms;
+		} else if (name == "infinite") {
+			limits.infinite = true;
+		} else if (name == "ponder") {
+			ponder = true;
+		} else {
+			send("error unknown search limit " + name);
+			return;
+		}
+
+		if (arguments.fail()) {
+			send("error missing value for " + name);
+			return;
+		}
+	}
+
+	// a position drawn by repetition can still be searched, it is up to the other program to end the game
+	if (m_game.getAvailableMoves().empty()) {
+		send("bestmove none");
+		return;
+	}
+
+	waitForSearch(); // joins the thread of the previous search, which has already finished
+
+	m_stop = false;
+	m_ponder = ponder;
+	m_limits = limits;
+	m_limits.stop = &m_stop;
+	m_limits.ponder = &m_ponder;
+	m_searching = true;
+
+	// only a search for a move to play takes it from the book, since analysis and pondering want a search
+	const bool may_use_book = (!limits.infinite && !ponder && m_multi_pv == 1);
+
+	m_search_thread = std::thread([this, may_use_book]() {
+		const Bitboard board = convertBoardToBitboard(m_game.getBoard());
+		const bool is_whites_turn = (m_game.getTurn() == Turn::WHITE);
+		SearchInfo book_info;
+		CompactMove best;
+
+		if (may_use_book && m_engine.probeBook(board, is_whites_turn, &book_info)) {
+			printInfo(book_info);
+			best = book_info.best_move;
+		} else {
+			std::vector<u64> history = Engine::getHistoryKeys(m_game);
+			history.pop_back(); // the position being searched
+
+			best = m_engine.searchMultiPv(board, is_whites_turn, m_limits, m_multi_pv, history).front().best_move;
+		}
+
+		Move best_move = convertCompactMoveToNormalMove(best);
+
+		// cleared first, so that a client can send its next command as soon as it reads the best move
+		m_searching = false;
+		send("bestmove " + (best_move.exists() ? Notation::getMoveString(best_move) : std::string("none")));
+	});
+}
+
+
+/**
+ * Sets an option: "name NAME value VALUE".
+ */
+void Protocol::handleSetOption(std::istringstream &arguments) {
+	std::string keyword, name, value_keyword;
+	int value;
+
+	if (!(arguments >> keyword >> name >> value_keyword >> value) || keyword != "name" || value_keyword != "value") {
+		send("error setoption needs name NAME value VALUE");
+		return;
+	}
+
+	if (name == "hash") {
+		m_engine.setHashSize(value);
+	} else if (name == "threads") {
+		if (value != 1) {
+			send("error threads is not supported"); // the search runs on one thread
+		}
+	} else if (name == "multipv") {
+		m_multi_pv = std::max(1, value);
+	} else {
+		send("error unknown option " + name);
+	}
+}
+
+
+/**
+ * Plays the moves that remain in arguments on game.
+ * @return False, after sending an error, if a move isn't legal.
+ */
+bool Protocol::applyMoves(std::istringstream &arguments, Game *game) {
+	std::string move_string;
+
+	while (arguments >> move_string) {
+		const Move *move = Notation::findMove(move_string, game->getAvailableMoves());
+
+		if (move == nullptr) {
+			send("error illegal move " + move_string);
+			return false;
+		}
+
+		game->doMove(Move(*move));
+	}
+
+	return true;
+}
+
+
+/**
+ * Stops the search if one is running and waits for it to send its best move.
+ */
+void Protocol::stopSearch() {
+	m_stop = true;
+	waitForSearch();
+}
+
+
+void Protocol::waitForSearch() {
+	if (m_search_thread.joinable()) {
+		m_search_thread.join();
+	}
+}
+
+
+/**
+ * Sends the progress of the search, called from the search thread.
+ */
+void Protocol::printInfo(const SearchInfo &info) {
+	if (info.partial) {
+		return; // only finished depths are reported
+	}
+
+	std::uint64_t nps = info.time_ms > 0 ? info.nodes * 1000 / info.time_ms : 0;
+	std::string pv;
+
+	for (int i = 0; i < info.pv_length; i++) {
+		pv += ' ' + Notation::getMoveString(convertCompactMoveToNormalMove(info.pv[i]));
+	}
+
+	std::string multi_pv = (m_multi_pv > 1) ? " multipv " + std::to_string(info.line + 1) : "";
+	std::string score = std::to_string(info.score);
+
+	if (isDecidedScore(info.score)) {
+		score = (info.score > 0 ? "win " : "loss ") + std::to_string(getPliesToEnd(info.score));
+	} else if (isTablebaseScore(info.score)) {
+		score = (info.score > 0) ? "tbwin" : "tbloss";
+	} else if (isKnownResultScore(info.score)) {
+		score = (info.score > 0) ? "knownwin" : "knownloss";
+	}
+
+	std::string tablebase_hits = (info.tablebase_hits > 0) ? " tbhits " + std::to_string(info.tablebase_hits) : "";
+
+	send("info depth " + std::to_string(info.depth) + multi_pv + " score " + score
+		+ " nodes " + std::to_string(info.nodes) + " time " + std::to_string(info.time_ms)
+		+ " nps " + std::to_string(nps) + tablebase_hits + " pv" + pv);
+}
+
+
+void Protocol::send(const std::string &line) {
+	std::lock_guard<std::mutex> lock(m_output_mutex);
+	std::cout << line << std::endl;
+}
@@ -0,0 +1,90 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+
+#include "game/game.h"
+#include "engine/engine.h"
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+/**
+ * Line based protocol for driving the engine from another program over stdin and stdout.
+ *
+ * Commands:
+ *   position startpos [moves M1 M2 ...]     set up the starting position, then play the moves
+ *   position fen FEN [moves M1 M2 ...]      set up a position given in FEN, eg. "B:W21-32:B1-12"
+ *   moves M1 M2 ...                         play moves on the current position
+ *   go [depth D] [nodes N] [movetime MS] [infinite] [ponder]
+ *                                           search the current position, without blocking
+ *                                           a position in the book (--book) is played from it
+ *                                           with an info line of depth 0, unless the search is
+ *                                           infinite, pondering or for more than one line
+ *   stop                                    end the search, its best move is still reported
+ *   ponderhit                               the move pondered on was played, the search now
+ *                                           follows its limits
+ *   setoption name NAME value VALUE         set an option, see below
+ *   isready                                 replies readyok once earlier commands are done
+ *   quit                                    stop any search and exit
+ *
+ * Options: "hash" (transposition table size in MiB, which also clears it, 0 for none), "multipv"
+ * (number of best moves to report, 1 by default) and "threads".
+ * The search is single threaded, so threads only accepts 1 and replies "error threads is not supported"
+ * to anything else.
+ *
+ * Replies:
+ *   info depth D [multipv K] score S nodes N time MS nps N [tbhits N] pv M1 M2 ...
+ *                                                     after each depth of a search, with one line per
+ *                                                     move numbered from 1 when multipv is above 1
+ *                                                     the score is "win P" or "loss P" when the game
+ *                                                     ends in P plies, "tbwin" or "tbloss" when
+ *                                                     the tablebases show it is won or lost, and
+ *                                                     "knownwin" or "knownloss" when they show a
+ *                                                     position with as many pieces as the root to be
+ *                                                     won or lost
+ *                                                     tbhits counts the positions found in the
+ *                                                     tablebases, when there were any
+ *   bestmove M                                        when a search ends, or "bestmove none"
+ *   readyok
+ *   error MESSAGE                                     when a command can't be carried out
+ *
+ * Moves are written as squares 1 to 32 joined by - or x, eg. "11-15" or "15x24x31".
+ */
+class Protocol {
+public:
+	~Protocol();
+
+	int run(int argc, char *argv[]);
+
+private:
+	bool handleCommand(const std::string &line);
+	void handlePosition(std::istringstream &arguments);
+	void handleMoves(std::istringstream &arguments);
+	void handleGo(std::istringstream &arguments);
+	void handleSetOption(std::istringstream &arguments);
+	bool applyMoves(std::istringstream &arguments, Game *game);
+	void stopSearch();
+	void waitForSearch();
+	void printInfo(const SearchInfo &info);
+	void send(const std::string &line);
+
+	Game m_game;
+	Engine m_engine;
+
+	std::thread m_search_thread;
+	std::atomic<bool> m_searching {false};
+	std::atomic<bool> m_stop {false};
+	std::atomic<bool> m_ponder {false};
+	SearchLimits m_limits;
+
+	int m_multi_pv = 1;
+
+	std::mutex m_output_mutex; // the search thread and the command loop both print
+};
+
+
+#endif // PROTOCOL_H
@@ -0,0 +1,301 @@
+#include "server/server.h"
+
+#include "game/board.h"
+#include "game/move.h"
+#include "game/notation.h"
+#include "game/turn.h"
+#include "engine/conversion.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <utility> // for std::pair
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+
+static const char *const DEFAULT_SOCKET_PATH = "checkers.sock";
+static const char *const START_FEN = "B:W21-32:B1-12";
+
+
+struct Server::Connection {
+	int fd;
+	std::uint64_t id;
+	std::mutex mutex; // guards the socket's output and games
+	std::set<std::uint32_t> games; // every game the client has asked about, cancelled when it disconnects
+	std::atomic<bool> finished {false}; // its thread has stopped serving it and can be joined
+
+	~Connection() {
+#ifndef _WIN32
+		close(fd);
+#endif
+	}
+};
+
+
+// the service keeps the games of different connections apart even if the clients use the same numbers
+static std::uint64_t getServiceGameId(std::uint64_t connection_id, std::uint32_t game) {
+	return (connection_id << 32) | game;
+}
+
+
+#ifdef _WIN32
+
+int Server::run(int argc, char *argv[]) {
+	std::cerr << "--serve needs unix domain sockets, which this build doesn't support\n";
+	return 1;
+}
+
+#else
+
+/**
+ * Listens on the socket given after --serve until the process is killed.
+ * --threads sets the size of the search pool, which defaults to the number of cores,
+ * and --min-depth the depth every search reaches whatever its deadline.
+ * @return One if the socket can't be opened.
+ */
+int Server::run(int argc, char *argv[]) {
+	std::string socket_path = DEFAULT_SOCKET_PATH;
+	int num_threads = 0;
+	int min_depth = EngineService::DEFAULT_MIN_DEPTH;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc && argv[i + 1][0] != '-') {
+			socket_path = argv[++i];
+		} else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--min-depth") == 0 && i + 1 < argc) {
+			min_depth = std::atoi(argv[++i]);
+		}
+	}
+
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		std::cerr << "Socket path is too long: " << socket_path << '\n';
+		return 1;
+	}
+	std::strcpy(address.sun_path, socket_path.c_str());
+
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path.c_str()); // left behind by an earlier run
+
+	if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+			|| listen(listen_fd, SOMAXCONN) != 0) {
+		std::perror(socket_path.c_str());
+		return 1;
+	}
+
+	m_service.reset(new EngineService(Engine::getDefaultOptions(), num_threads, 0, min_depth));
+
+	std::cerr << "Serving on " << socket_path << " with " << m_service->getNumThreads() << " threads\n";
+
+	// the threads of connections that have closed are joined as new ones arrive, so they don't pile up
+	std::vector<std::pair<std::thread, std::shared_ptr<Connection>>> connection_threads;
+	std::uint64_t next_connection_id = 1;
+	int fd;
+
+	while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0) {
+		for (auto it = connection_threads.begin(); it != connection_threads.end();) {
+			if (it->second->finished) {
+				it->first.join();
+				it = connection_threads.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+		connection->fd = fd;
+		connection->id = next_connection_id++;
+
+		connection_threads.emplace_back(std::thread(&Server::serveConnection, this, connection), connection);
+	}
+
+	std::perror("accept");
+	close(listen_fd);
+
+	for (auto &connection_thread : connection_threads) {
+		connection_thread.first.join();
+	}
+
+	return 1;
+}
+
+
+/**
+ * Reads commands from a client until it disconnects or sends quit.
+ * The client's unfinished games are then cancelled.
+ */
+void Server::serveConnection(std::shared_ptr<Connection> connection) {
+	std::string buffer;
+	char data[4096];
+	bool open = true;
+
+	while (open) {
+		ssize_t length = recv(connection->fd, data, sizeof(data), 0);
+		if (length <= 0) {
+			break;
+		}
+
+		buffer.append(data, length);
+
+		std::size_t line_end;
+		while (open && (line_end = buffer.find('\n')) != std::string::npos) {
+			open = handleCommand(connection, buffer.substr(0, line_end));
+			buffer.erase(0, line_end + 1);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(connection->mutex);
+
+	for (std::uint32_t game : connection->games) {
+		m_service->cancelGame(getServiceGameId(connection->id, game));
+	}
+
+	shutdown(connection->fd, SHUT_RDWR); // searches still finishing hold the connection open, but won't reply
+
+	connection->finished = true;
+}
+
+
+/**
+ * Carries out a single command.
+ * @return False if the connection should be closed.
+ */
+bool Server::handleCommand(const std::shared_ptr<Connection> &connection, const std::string &line) {
+	std::istringstream arguments(line);
+	std::string command;
+
+	if (!(arguments >> command)) {
+		return true; // blank line
+	}
+
+	if (command == "quit") {
+		return false;
+	} else if (command == "search") {
+		handleSearch(connection, arguments);
+	} else if (command == "cancel") {
+		std::uint32_t game;
+		if (arguments >> game) {
+			m_service->cancelGame(getServiceGameId(connection->id, game));
+		} else {
+			send(*connection, "error cancel needs a game");
+		}
+	} else if (command == "stats") {
+		ServiceStats stats = m_service->getStats();
+		char reply[192];
+		std::snprintf(reply, sizeof(reply), "stats completed %llu missed %llu degraded %llu p50 %.1f p99 %.1f depth %.1f",
+			static_cast<unsigned long long>(stats.completed), static_cast<unsigned long long>(stats.deadlines_missed),
+			static_cast<unsigned long long>(stats.degraded), stats.p50_latency_ms, stats.p99_latency_ms, stats.mean_depth);
+		send(*connection, reply);
+	} else {
+		send(*connection, "error unknown command " + command);
+	}
+
+	return true;
+}
+
+
+/**
+ * Queues a search: "GAME startpos|fen FEN" followed by any of the limits.
+ * The reply is sent from the worker thread that did the search.
+ */
+void Server::handleSearch(const std::shared_ptr<Connection> &connection, std::istringstream &arguments) {
+	std::uint32_t game;
+	std::string type, fen;
+
+	if (!(arguments >> game >> type)) {
+		send(*connection, "error search needs a game and a position");
+		return;
+	}
+
+	if (type == "startpos") {
+		fen = START_FEN;
+	} else if (type != "fen" || !(arguments >> fen)) {
+		send(*connection, "error position needs startpos or fen");
+		return;
+	}
+
+	Board board;
+	Turn turn;
+
+	if (!Notation::parseFen(fen, &board, &turn)) {
+		send(*connection, "error invalid fen");
+		return;
+	}
+
+	ServiceRequest request;
+	request.game_id = getServiceGameId(connection->id, game);
+	request.board = convertBoardToBitboard(board);
+	request.is_whites_turn = (turn == Turn::WHITE);
+
+	std::string name;
+
+	while (arguments >> name) {
+		if (name == "priority") {
+			arguments >> request.priority;
+		} else if (name == "deadline") {
+			arguments >> request.deadline_ms;
+		} else if (name == "depth") {
+			arguments >> request.limits.depth;
+		} else if (name == "nodes") {
+			arguments >> request.limits.nodes;
+		} else if (name == "movetime") {
+			arguments >> request.limits.time_ms;
+		} else {
+			send(*connection, "error unknown search option " + name);
+			return;
+		}
+
+		if (arguments.fail()) {
+			send(*connection, "error missing value for " + name);
+			return;
+		}
+	}
+
+	// the connection is kept alive by the request until its result has been sent
+	request.on_result = [connection, game](const SearchInfo &info) {
+		Move move = convertCompactMoveToNormalMove(info.best_move);
+
+		send(*connection, "bestmove " + std::to_string(game) + ' '
+			+ (move.exists() ? Notation::getMoveString(move) : std::string("none"))
+			+ " score " + std::to_string(info.score) + " depth " + std::to_string(info.depth)
+			+ " nodes " + std::to_string(info.nodes) + " time " + std::to_string(info.time_ms));
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(connection->mutex);
+		connection->games.insert(game);
+	}
+
+	m_service->submit(std::move(request));
+}
+
+
+void Server::send(Connection &connection, const std::string &line) {
+	std::lock_guard<std::mutex> lock(connection.mutex);
+
+	std::string data = line + '\n';
+	std::size_t sent = 0;
+
+	while (sent < data.size()) {
+		// MSG_NOSIGNAL so a client that has gone away doesn't kill the server with SIGPIPE
+		ssize_t length = ::send(connection.fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (length <= 0) {
+			return;
+		}
+		sent += length;
+	}
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+
+#include "engine/engine_service.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+
+
+/**
+ * Serves many games at once from one EngineService, listening on a local (unix domain) socket.
+ * Each connection sends line based commands and can have any number of games in progress.
+ *
+ * Commands:
+ *   search GAME startpos|fen FEN [priority P] [deadline MS] [depth D] [nodes N] [movetime MS]
+ *                          queue a search of a position for game GAME, a number chosen by the client
+ *   cancel GAME            drop the game's queued searches and stop the running one unreported
+ *   stats                  report the number of searches done, their latency and the mean depth they reached,
+ *                          degraded counting those started after their deadline that only reached the minimum depth
+ *   quit                   close the connection
+ *
+ * Replies:
+ *   bestmove GAME M score S depth D nodes N time MS
+ *   stats completed N missed N degraded N p50 MS p99 MS depth D
+ *   error MESSAGE
+ *
+ * Searches for the same game are run one after another in the order they were sent,
+ * and searches for different games may finish in any order.
+ */
+class Server {
+public:
+	int run(int argc, char *argv[]);
+
+private:
+	struct Connection;
+
+	void serveConnection(std::shared_ptr<Connection> connection);
+	bool handleCommand(const std::shared_ptr<Connection> &connection, const std::string &line);
+	void handleSearch(const std::shared_ptr<Connection> &connection, std::istringstream &arguments);
+
+	static void send(Connection &connection, const std::string &line);
+
+	std::unique_ptr<EngineService> m_service;
+};
+
+
+#endif // SERVER_H
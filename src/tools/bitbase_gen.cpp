@@ -0,0 +1,114 @@
+// solves the tables compiled into the engine and writes them out as a source file, run while building
+// (see src/engine/bitbases.h), so it is only built from the few engine sources it needs
+//
+// usage: checkers_bitbase_gen OUTPUT DIRECTORY [--pieces N]
+//   OUTPUT        the source file to write
+//   DIRECTORY     where the tables are solved, which must already exist, tables already there are kept
+//   --pieces N    most pieces on the board (default 4), zero compiles in no tables
+
+#include "engine/tablebase.h"
+#include "engine/tablebase_generator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_bitbase_gen OUTPUT DIRECTORY [--pieces N]\n";
+}
+
+
+// writes the bytes of a table file as the initialiser of an array
+static void writeBytes(std::ofstream &output, const std::vector<unsigned char> &bytes) {
+	char hex[8];
+
+	for (std::size_t i = 0; i < bytes.size(); i++) {
+		std::snprintf(hex, sizeof(hex), "0x%02x,", bytes[i]);
+		output << ((i % 16 == 0) ? "\n\t" : " ") << hex;
+	}
+	output << '\n';
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 3 || argv[1][0] == '-' || argv[2][0] == '-') {
+		printUsage();
+		return 1;
+	}
+
+	const std::string output_path = argv[1];
+	const std::string directory = argv[2];
+	int max_pieces = 4;
+
+	for (int i = 3; i < argc; i++) {
+		if (std::strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+			max_pieces = std::atoi(argv[++i]);
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	const std::vector<MaterialSignature> signatures = getSignaturesInOrder(max_pieces);
+	TablebaseGenerator generator(directory);
+
+	for (const MaterialSignature &signature : signatures) {
+		if (std::ifstream(getTablePath(directory, signature))) {
+			continue; // written by an earlier build, or along with its flipped signature
+		}
+
+		TablebaseStats stats;
+		if (!generator.generate(signature, &stats)) {
+			std::cerr << "Failed to generate " << getSignatureName(signature) << " in " << directory << "\n";
+			return 1;
+		}
+	}
+
+	// the output only gets its name once it is complete, so a failed build doesn't leave it half written
+	const std::string temporary_path = output_path + ".tmp";
+	std::ofstream output(temporary_path);
+	output << "// written by checkers_bitbase_gen while building, do not edit\n\n"
+		<< "#include \"engine/bitbases.h\"\n\n\n";
+
+	for (const MaterialSignature &signature : signatures) {
+		std::ifstream file(getTablePath(directory, signature), std::ios::binary);
+		const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		if (bytes.empty()) {
+			std::cerr << "Failed to read " << getTablePath(directory, signature) << "\n";
+			return 1;
+		}
+
+		output << "static const unsigned char table_" << getSignatureName(signature) << "[] = {";
+		writeBytes(output, bytes);
+		output << "};\n\n";
+	}
+
+	// an array can't be empty, so there is always a last entry that isn't counted
+	output << "\nstatic const BuiltInTable tables[] = {\n";
+	for (const MaterialSignature &signature : signatures) {
+		const std::string name = getSignatureName(signature);
+		output << "\t{\"" << name << "\", table_" << name << ", sizeof(table_" << name << ")},\n";
+	}
+	output << "\t{nullptr, nullptr, 0},\n"
+		<< "};\n\n"
+		<< "const BuiltInTable *const built_in_tables = tables;\n"
+		<< "const int num_built_in_tables = " << signatures.size() << ";\n";
+
+	output.close();
+	std::remove(output_path.c_str());
+
+	if (!output || std::rename(temporary_path.c_str(), output_path.c_str()) != 0) {
+		std::cerr << "Failed to write " << output_path << "\n";
+		std::remove(temporary_path.c_str());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+// builds an opening book for the engine's --book option: every position up to a given number of plies
+// from the start is searched, and the moves that score close to its best are stored with a weight
+// that is larger the closer they came, so the engine varies its openings without playing bad moves
+//
+// usage: checkers_bookgen OUTPUT [--plies N] [--depth N] [--lines N] [--margin N] [engine options]
+//   OUTPUT       the book file to write
+//   --plies N    plies from the starting position the book covers (default 6)
+//   --depth N    depth each position is searched to (default 11)
+//   --lines N    most moves stored for each position (default 3)
+//   --margin N   how far below the best score a move can be and still be stored (default 20)
+//
+// the engine options are those of checkers_cli, such as --weights and --nnue
+// a position reached by more than one order of moves is only searched once
+
+#include "engine/bitboard.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/conversion.h"
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/opening_book.h"
+#include "engine/zobrist.h"
+#include "game/game.h"
+#include "game/matchtype.h"
+#include "game/turn.h"
+
+#include <algorithm> // for std::find, std::max, std::min
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+struct BookSettings {
+	int plies = 6;
+	int depth = 11;
+	int lines = 3;
+	int margin = 20;
+};
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_bookgen OUTPUT [--plies N] [--depth N] [--lines N] [--margin N] [engine options]\n";
+}
+
+
+// adds the book moves of the position and of the positions they lead to, until plies_left runs out
+// searched holds the keys of the positions already added
+static void addPosition(Engine *engine, const Bitboard &board, bool is_whites_turn, int plies_left,
+		const BookSettings &settings, std::unordered_set<u64> *searched, std::vector<BookEntry> *entries) {
+	const u64 key = hashBitboard(board, is_whites_turn);
+	if (plies_left <= 0 || !searched->insert(key).second) {
+		return;
+	}
+
+	Bitboard next_positions[MAX_MOVES];
+	CompactMove moves[MAX_MOVES];
+	const int num_moves = generateMoves(board, is_whites_turn, next_positions, moves);
+	if (num_moves == 0) {
+		return;
+	}
+
+	SearchLimits limits;
+	limits.depth = settings.depth;
+	const std::vector<SearchInfo> lines = engine->searchMultiPv(board, is_whites_turn, limits, settings.lines);
+	const int best_score = lines.front().score;
+
+	for (const SearchInfo &line : lines) {
+		const int shortfall = best_score - line.score;
+		if (!line.best_move.exists() || shortfall > settings.margin) {
+			continue;
+		}
+
+		// the best move is played most often, and one right at the margin least often
+		const int weight = std::max(1, MAX_BOOK_WEIGHT * (settings.margin + 1 - shortfall) / (settings.margin + 1));
+		entries->push_back({key, line.best_move, weight, line.score});
+
+		const int index = static_cast<int>(std::find(moves, moves + num_moves, line.best_move) - moves);
+		addPosition(engine, next_positions[index], !is_whites_turn, plies_left - 1, settings, searched, entries);
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2 || argv[1][0] == '-') {
+		printUsage();
+		return 1;
+	}
+
+	const std::string output_path = argv[1];
+	BookSettings settings;
+	EngineOptions engine_options;
+
+	for (int i = 2; i < argc; i++) {
+		if (std::strcmp(argv[i], "--plies") == 0 && i + 1 < argc) {
+			settings.plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+			settings.depth = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+			settings.lines = std::min(std::max(1, std::atoi(argv[++i])), MAX_MOVES);
+		} else if (std::strcmp(argv[i], "--margin") == 0 && i + 1 < argc) {
+			settings.margin = std::max(0, std::atoi(argv[++i]));
+		} else if (!parseEngineOption(argc, argv, &i, &engine_options)) {
+			printUsage();
+			return 1;
+		}
+	}
+
+	Engine engine(engine_options);
+
+	Game game;
+	game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+
+	std::unordered_set<u64> searched;
+	std::vector<BookEntry> entries;
+	addPosition(&engine, convertBoardToBitboard(game.getBoard()), game.getTurn() == Turn::WHITE, settings.plies,
+		settings, &searched, &entries);
+
+	if (!OpeningBook::write(output_path, entries)) {
+		std::cerr << "Failed to write " << output_path << "\n";
+		return 1;
+	}
+
+	std::cout << "Wrote " << entries.size() << " moves from " << searched.size() << " positions to " << output_path << "\n";
+
+	return 0;
+}
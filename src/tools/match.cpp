@@ -0,0 +1,362 @@
+// plays a match between two engine configurations, A and B, and reports the Elo difference
+// games are played concurrently, each opening is played twice with the colours swapped,
+// and a sequential probability ratio test (SPRT) stops the match as soon as it is decided
+//
+// usage: checkers_match [--games N] [--threads N] [--openings FILE] [--opening-plies N] [--seed S]
+//                       [--depth D] [--nodes N] [--movetime MS] [--max-plies N] [--draw-plies N]
+//                       [--elo0 E] [--elo1 E] [--alpha X] [--beta X] [--save-positions FILE]
+//                       [--a-depth D] [--a-weights FILE] [--a-nnue FILE] [--a-no-exchange-pruning]
+//                       [--b-depth D] [--b-weights FILE] [--b-nnue FILE] [--b-no-exchange-pruning]
+//   --games N           most games to play, rounded up to whole pairs (default 2000)
+//   --threads N         games played at once (default: number of cores)
+//   --openings FILE     opening suite, one opening per line written like "11-15 23-19 8-11"
+//   --opening-plies N   length of the random openings used when there is no suite (default 6)
+//   --seed S            seed for the random openings (default 1)
+//   --depth D           search depth of both engines (default 6), 0 to search as deep as the other limits allow
+//   --nodes N           nodes each engine may search per move (default no limit)
+//   --movetime MS       time each engine may search per move (default no limit)
+//   --max-plies N       plies after which a game is drawn (default 300)
+//   --draw-plies N      a game is drawn once material has been level for this many plies (default 60)
+//   --elo0, --elo1      SPRT hypotheses: A is elo0 or elo1 stronger than B (default 0 and 5)
+//   --alpha, --beta     SPRT false positive and false negative rates (default 0.05)
+//   --save-positions F  write every position a move was played from, labelled with the result of
+//                       its game, to a position file for checkers_tuner
+//   --a-*, --b-*        settings for one engine only: search depth, evaluation weights, network,
+//                       and turning off the pruning of quiet moves that lose material
+
+#include "tools/self_play.h"
+
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/position_file.h"
+#include "game/game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct EngineConfig {
+	EngineOptions options;
+	SearchLimits limits;
+};
+
+
+// results from A's point of view
+struct MatchScore {
+	int wins = 0;
+	int draws = 0;
+	int losses = 0;
+
+	int getGames() const {
+		return wins + draws + losses;
+	}
+
+	double getScore() const {
+		return (wins + 0.5 * draws) / getGames();
+	}
+};
+
+
+enum class SprtResult {
+	CONTINUE,
+	ACCEPT_H0, // A is no better than elo0
+	ACCEPT_H1, // A is at least elo1 better
+};
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_match [--games N] [--threads N] [--openings FILE] [--opening-plies N] [--seed S]\n"
+		<< "                      [--depth D] [--nodes N] [--movetime MS] [--max-plies N] [--draw-plies N]\n"
+		<< "                      [--elo0 E] [--elo1 E] [--alpha X] [--beta X] [--save-positions FILE]\n"
+		<< "                      [--a-depth D] [--a-weights FILE] [--a-nnue FILE] [--a-no-exchange-pruning]\n"
+		<< "                      [--b-depth D] [--b-weights FILE] [--b-nnue FILE] [--b-no-exchange-pruning]\n";
+}
+
+
+static double eloToScore(double elo) {
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+
+static double scoreToElo(double score) {
+	return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+
+// returns the Elo difference and the half width of its 95% confidence interval
+static void computeElo(const MatchScore &score, double *elo, double *error) {
+	double games = score.getGames();
+	double mean = score.getScore();
+	double variance = (score.wins * std::pow(1.0 - mean, 2) + score.draws * std::pow(0.5 - mean, 2)
+		+ score.losses * std::pow(0.0 - mean, 2)) / games;
+	double margin = 1.96 * std::sqrt(variance / games);
+
+	// clamp so a clean sweep still gives a finite answer
+	double low = std::min(std::max(mean - margin, 1e-6), 1.0 - 1e-6);
+	double high = std::min(std::max(mean + margin, 1e-6), 1.0 - 1e-6);
+
+	*elo = scoreToElo(std::min(std::max(mean, 1e-6), 1.0 - 1e-6));
+	*error = (scoreToElo(high) - scoreToElo(low)) / 2.0;
+}
+
+
+// log likelihood ratio of elo1 over elo0, using the normal approximation to the trinomial distribution
+static double computeLlr(const MatchScore &score, double elo0, double elo1) {
+	if (score.wins == 0 || score.losses == 0) {
+		return 0.0; // the variance can't be estimated yet
+	}
+
+	double games = score.getGames();
+	double mean = score.getScore();
+	double variance = (score.wins * std::pow(1.0 - mean, 2) + score.draws * std::pow(0.5 - mean, 2)
+		+ score.losses * std::pow(0.0 - mean, 2)) / games;
+
+	double score0 = eloToScore(elo0);
+	double score1 = eloToScore(elo1);
+
+	return games * (score1 - score0) * (2.0 * mean - score0 - score1) / (2.0 * variance);
+}
+
+
+static bool loadOpenings(const std::string &path, std::vector<Game> *openings) {
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	std::string line;
+	int line_number = 0;
+
+	while (std::getline(file, line)) {
+		line_number++;
+
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		Game game;
+		if (!parseOpening(line, &game)) {
+			std::cerr << path << ':' << line_number << ": invalid opening\n";
+			return false;
+		}
+		openings->push_back(game);
+	}
+
+	return !openings->empty();
+}
+
+
+int main(int argc, char *argv[]) {
+	const char *openings_path = nullptr;
+	const char *positions_path = nullptr;
+	int max_games = 2000;
+	int num_threads = std::max(1u, std::thread::hardware_concurrency());
+	int opening_plies = 6;
+	std::uint32_t seed = 1;
+	double elo0 = 0.0;
+	double elo1 = 5.0;
+	double alpha = 0.05;
+	double beta = 0.05;
+
+	SelfPlaySettings settings;
+	settings.max_plies = 300;
+	settings.draw_plies = 60;
+
+	EngineConfig configs[2];
+	configs[0].limits.depth = 6;
+	configs[1].limits.depth = 6;
+
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+
+		if (std::strcmp(option, "--depth") == 0 && i + 1 < argc) {
+			configs[0].limits.depth = configs[1].limits.depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--nodes") == 0 && i + 1 < argc) {
+			configs[0].limits.nodes = configs[1].limits.nodes = std::strtoull(argv[++i], nullptr, 10);
+		} else if (std::strcmp(option, "--movetime") == 0 && i + 1 < argc) {
+			configs[0].limits.time_ms = configs[1].limits.time_ms = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--a-depth") == 0 && i + 1 < argc) {
+			configs[0].limits.depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--b-depth") == 0 && i + 1 < argc) {
+			configs[1].limits.depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--a-weights") == 0 && i + 1 < argc) {
+			configs[0].options.weights_file = argv[++i];
+		} else if (std::strcmp(option, "--b-weights") == 0 && i + 1 < argc) {
+			configs[1].options.weights_file = argv[++i];
+		} else if (std::strcmp(option, "--a-nnue") == 0 && i + 1 < argc) {
+			configs[0].options.network_file = argv[++i];
+		} else if (std::strcmp(option, "--b-nnue") == 0 && i + 1 < argc) {
+			configs[1].options.network_file = argv[++i];
+		} else if (std::strcmp(option, "--a-no-exchange-pruning") == 0) {
+			configs[0].options.exchange_pruning = false;
+		} else if (std::strcmp(option, "--b-no-exchange-pruning") == 0) {
+			configs[1].options.exchange_pruning = false;
+		} else if (std::strcmp(option, "--games") == 0 && i + 1 < argc) {
+			max_games = std::max(2, std::atoi(argv[++i]));
+		} else if (std::strcmp(option, "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(option, "--openings") == 0 && i + 1 < argc) {
+			openings_path = argv[++i];
+		} else if (std::strcmp(option, "--opening-plies") == 0 && i + 1 < argc) {
+			opening_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--seed") == 0 && i + 1 < argc) {
+			seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(option, "--max-plies") == 0 && i + 1 < argc) {
+			settings.max_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--draw-plies") == 0 && i + 1 < argc) {
+			settings.draw_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(option, "--elo0") == 0 && i + 1 < argc) {
+			elo0 = std::atof(argv[++i]);
+		} else if (std::strcmp(option, "--elo1") == 0 && i + 1 < argc) {
+			elo1 = std::atof(argv[++i]);
+		} else if (std::strcmp(option, "--alpha") == 0 && i + 1 < argc) {
+			alpha = std::atof(argv[++i]);
+		} else if (std::strcmp(option, "--beta") == 0 && i + 1 < argc) {
+			beta = std::atof(argv[++i]);
+		} else if (std::strcmp(option, "--save-positions") == 0 && i + 1 < argc) {
+			positions_path = argv[++i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	const int num_pairs = (max_games + 1) / 2;
+	std::vector<Game> openings;
+
+	if (openings_path != nullptr) {
+		if (!loadOpenings(openings_path, &openings)) {
+			std::cerr << "Could not load openings from " << openings_path << '\n';
+			return 1;
+		}
+	} else {
+		std::mt19937 rng(seed);
+		for (int pair = 0; pair < num_pairs; pair++) {
+			openings.push_back(randomOpening(rng, opening_plies));
+		}
+	}
+
+	PositionFileWriter positions_file;
+
+	if (positions_path != nullptr && !positions_file.open(positions_path)) {
+		std::cerr << "Could not open " << positions_path << '\n';
+		return 1;
+	}
+
+	const double lower_bound = std::log(beta / (1.0 - alpha));
+	const double upper_bound = std::log((1.0 - beta) / alpha);
+
+	std::printf("SPRT elo0 %.1f elo1 %.1f, bounds [%.2f, %.2f]\n", elo0, elo1, lower_bound, upper_bound);
+
+	MatchScore score;
+	SprtResult sprt_result = SprtResult::CONTINUE;
+	std::mutex score_mutex;
+	std::atomic<int> next_pair(0);
+	std::atomic<bool> stop(false);
+	std::vector<std::thread> workers;
+
+	for (int worker = 0; worker < num_threads; worker++) {
+		workers.emplace_back([&]() {
+			Engine engine_a(configs[0].options);
+			Engine engine_b(configs[1].options);
+
+			int pair;
+			while (!stop && (pair = next_pair++) < num_pairs) {
+				const Game &opening = openings[pair % openings.size()];
+				MatchScore pair_score;
+				std::vector<LabelledPosition> positions;
+				std::vector<LabelledPosition> *save_positions = (positions_path != nullptr) ? &positions : nullptr;
+
+				for (int a_is_black = 1; a_is_black >= 0; a_is_black--) {
+					SelfPlaySettings game_settings = settings;
+					GameResult result;
+
+					if (a_is_black) {
+						game_settings.black_limits = configs[0].limits;
+						game_settings.white_limits = configs[1].limits;
+						result = playGame(opening, engine_a, engine_b, game_settings, save_positions);
+					} else {
+						game_settings.black_limits = configs[1].limits;
+						game_settings.white_limits = configs[0].limits;
+						result = playGame(opening, engine_b, engine_a, game_settings, save_positions);
+					}
+
+					if (result == GameResult::DRAW) {
+						pair_score.draws++;
+					} else if ((result == GameResult::BLACK_WIN) == static_cast<bool>(a_is_black)) {
+						pair_score.wins++;
+					} else {
+						pair_score.losses++;
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(score_mutex);
+
+				for (const LabelledPosition &position : positions) {
+					positions_file.write(position);
+				}
+
+				if (stop) {
+					break; // the result is already decided, leave the totals as they were reported
+				}
+
+				score.wins += pair_score.wins;
+				score.draws += pair_score.draws;
+				score.losses += pair_score.losses;
+
+				double elo, error;
+				computeElo(score, &elo, &error);
+				double llr = computeLlr(score, elo0, elo1);
+
+				std::printf("games %5d  +%d =%d -%d  elo %+.1f +/- %.1f  llr %.2f\n",
+					score.getGames(), score.wins, score.draws, score.losses, elo, error, llr);
+				std::fflush(stdout);
+
+				if (llr >= upper_bound) {
+					sprt_result = SprtResult::ACCEPT_H1;
+					stop = true;
+				} else if (llr <= lower_bound) {
+					sprt_result = SprtResult::ACCEPT_H0;
+					stop = true;
+				}
+			}
+		});
+	}
+
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	if (positions_path != nullptr && !positions_file.close()) {
+		std::cerr << "Could not write " << positions_path << '\n';
+		return 1;
+	}
+
+	double elo, error;
+	computeElo(score, &elo, &error);
+
+	std::printf("\nfinal: %d games, +%d =%d -%d, score %.1f%%, elo %+.1f +/- %.1f\n",
+		score.getGames(), score.wins, score.draws, score.losses, 100.0 * score.getScore(), elo, error);
+
+	if (sprt_result == SprtResult::ACCEPT_H1) {
+		std::printf("SPRT: H1 accepted, A is stronger\n");
+	} else if (sprt_result == SprtResult::ACCEPT_H0) {
+		std::printf("SPRT: H0 accepted, A is not stronger\n");
+	} else {
+		std::printf("SPRT: inconclusive\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "tools/self_play.h"
+
+#include "engine/bitboard.h"
+#include "engine/conversion.h"
+#include "engine/engine.h"
+#include "game/game.h"
+#include "game/matchtype.h"
+#include "game/move.h"
+#include "game/notation.h"
+#include "game/turn.h"
+
+#include <sstream>
+#include <vector>
+
+
+// plays num_plies uniformly random moves from the starting position
+// openings that end the game are thrown away and tried again
+Game randomOpening(std::mt19937 &rng, int num_plies) {
+	Game game;
+
+	do {
+		game.newGame(MatchType::COMPUTER_VS_COMPUTER);
+
+		for (int ply = 0; ply < num_plies && !game.isOver(); ply++) {
+			const std::vector<Move> &moves = game.getAvailableMoves();
+			std::uniform_int_distribution<std::size_t> pick(0, moves.size() - 1);
+			game.doMove(moves[pick(rng)]);
+		}
+	} while (game.isOver());
+
+	return game;
+}
+
+
+// sets game to the starting position followed by the moves in line, written like "11-15 23-19 8-11"
+// returns false if a move isn't legal or the moves end the game
+bool parseOpening(const std::string &line, Game *game) {
+	game->newGame(MatchType::COMPUTER_VS_COMPUTER);
+
+	std::istringstream moves(line);
+	std::string move_string;
+
+	while (moves >> move_string) {
+		const Move *move = Notation::findMove(move_string, game->getAvailableMoves());
+		if (move == nullptr) {
+			return false;
+		}
+		game->doMove(Move(*move));
+	}
+
+	return !game->isOver();
+}
+
+
+// returns true if both sides have the same number of men and the same number of kings
+static bool isMaterialLevel(const Game &game) {
+	Bitboard board = convertBoardToBitboard(game.getBoard());
+	u32 men = ~board.king_pieces;
+
+	return popcount(board.black_pieces & men) == popcount(board.white_pieces & men)
+		&& popcount(board.black_pieces & board.king_pieces) == popcount(board.white_pieces & board.king_pieces);
+}
+
+
+// plays the game out, adding each position a move is played from to positions if it isn't null
+static GameResult playMoves(Game &game, Engine &black, Engine &white, const SelfPlaySettings &settings,
+		std::vector<LabelledPosition> *positions) {
+	int level_plies = 0;
+
+	for (int ply = 0; ply < settings.max_plies; ply++) {
+		if (game.isDraw()) {
+			return GameResult::DRAW;
+		} else if (game.isOver()) {
+			// the side to move has no moves left and has lost
+			return game.getTurn() == Turn::BLACK ? GameResult::WHITE_WIN : GameResult::BLACK_WIN;
+		}
+
+		if (positions != nullptr) {
+			LabelledPosition position;
+			position.board = convertBoardToBitboard(game.getBoard());
+			position.is_whites_turn = (game.getTurn() == Turn::WHITE);
+			positions->push_back(position);
+		}
+
+		if (game.getTurn() == Turn::BLACK) {
+			game.doMove(black.findBestMove(game, settings.black_limits));
+		} else {
+			game.doMove(white.findBestMove(game, settings.white_limits));
+		}
+
+		if (settings.draw_plies > 0) {
+			level_plies = isMaterialLevel(game) ? level_plies + 1 : 0;
+			if (level_plies >= settings.draw_plies) {
+				return GameResult::DRAW;
+			}
+		}
+	}
+
+	return GameResult::DRAW;
+}
+
+
+// plays the game out between two engines, black moving first if it is black's turn
+// if positions isn't null, each position a move was played from is added to it, labelled with the result
+GameResult playGame(Game game, Engine &black, Engine &white, const SelfPlaySettings &settings,
+		std::vector<LabelledPosition> *positions) {
+	const std::size_t first_position = (positions != nullptr) ? positions->size() : 0;
+	const GameResult result = playMoves(game, black, white, settings, positions);
+
+	if (positions != nullptr) {
+		LabelledPosition::Result label = LabelledPosition::DRAW;
+		if (result == GameResult::WHITE_WIN) {
+			label = LabelledPosition::WHITE_WIN;
+		} else if (result == GameResult::BLACK_WIN) {
+			label = LabelledPosition::BLACK_WIN;
+		}
+
+		for (std::size_t i = first_position; i < positions->size(); i++) {
+			(*positions)[i].result = label;
+		}
+	}
+
+	return result;
+}
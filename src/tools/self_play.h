@@ -0,0 +1,38 @@
+#ifndef SELF_PLAY_H
+#define SELF_PLAY_H
+
+
+#include "engine/position_file.h"
+#include "engine/search_limits.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+
+class Engine;
+class Game;
+
+
+enum class GameResult {
+	BLACK_WIN,
+	WHITE_WIN,
+	DRAW,
+};
+
+
+struct SelfPlaySettings {
+	SearchLimits black_limits; // applied to every move of that side
+	SearchLimits white_limits;
+	int max_plies = 200; // the game is drawn if it is still going after this many plies
+	int draw_plies = 0; // the game is drawn once material has been level for this many plies, 0 disables this
+};
+
+
+Game randomOpening(std::mt19937 &rng, int num_plies);
+bool parseOpening(const std::string &line, Game *game);
+GameResult playGame(Game game, Engine &black, Engine &white, const SelfPlaySettings &settings,
+	std::vector<LabelledPosition> *positions = nullptr);
+
+
+#endif // SELF_PLAY_H
@@ -0,0 +1,147 @@
+// measures the move latency of an EngineService hosting many games at once
+// every game plays itself, asking the service for its next move as soon as the last one arrives,
+// so the service is always fully loaded
+//
+// usage: checkers_service_load [--games N] [--threads N] [--plies N] [--deadline MS] [--depth D]
+//                              [--min-depth D] [--seed S]
+//   --games N       games hosted at once (default 64)
+//   --threads N     size of the service's search pool (default: number of cores)
+//   --plies N       moves played in each game, unless it ends first (default 40)
+//   --deadline MS   time each move is wanted in, 0 for none (default 100)
+//   --depth D       search depth of each move, 0 to search until the deadline (default 0)
+//   --min-depth D   depth every move is searched to even if that misses the deadline (default 6)
+//   --seed S        seed for the random openings (default 1)
+
+#include "tools/self_play.h"
+
+#include "engine/conversion.h"
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/engine_service.h"
+#include "game/game.h"
+#include "game/move.h"
+#include "game/turn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <vector>
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_service_load [--games N] [--threads N] [--plies N] [--deadline MS] [--depth D]\n"
+		<< "                             [--min-depth D] [--seed S]\n";
+}
+
+
+int main(int argc, char *argv[]) {
+	int num_games = 64;
+	int num_threads = 0;
+	int max_plies = 40;
+	int deadline_ms = 100;
+	int depth = 0;
+	int min_depth = EngineService::DEFAULT_MIN_DEPTH;
+	std::uint32_t seed = 1;
+	EngineOptions engine_options;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+			num_games = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--plies") == 0 && i + 1 < argc) {
+			max_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--deadline") == 0 && i + 1 < argc) {
+			deadline_ms = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+			depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--min-depth") == 0 && i + 1 < argc) {
+			min_depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (!parseEngineOption(argc, argv, &i, &engine_options)) {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (deadline_ms <= 0 && depth <= 0) {
+		std::cerr << "Needs a deadline or a depth\n";
+		return 1;
+	}
+
+	std::mt19937 rng(seed);
+	std::vector<Game> games;
+	std::vector<int> plies_played(num_games, 0);
+
+	for (int i = 0; i < num_games; i++) {
+		games.push_back(randomOpening(rng, 4));
+	}
+
+	std::mutex mutex;
+	std::condition_variable all_done;
+	int games_running = num_games;
+
+	EngineService service(engine_options, num_threads, 0, min_depth);
+
+	// asks for the next move of game i, whose result plays it and asks for the one after
+	std::function<void(int)> requestMove = [&](int i) {
+		ServiceRequest request;
+		request.game_id = i;
+		request.board = convertBoardToBitboard(games[i].getBoard());
+		request.is_whites_turn = (games[i].getTurn() == Turn::WHITE);
+		request.limits.depth = depth;
+		request.deadline_ms = deadline_ms;
+
+		request.on_result = [&, i](const SearchInfo &info) {
+			games[i].doMove(convertCompactMoveToNormalMove(info.best_move));
+
+			if (++plies_played[i] < max_plies && !games[i].isOver()) {
+				requestMove(i);
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--games_running == 0) {
+				all_done.notify_one();
+			}
+		};
+
+		service.submit(std::move(request));
+	};
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < num_games; i++) {
+		if (games[i].isOver()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			games_running--;
+		} else {
+			requestMove(i);
+		}
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		all_done.wait(lock, [&]() { return games_running == 0; });
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	ServiceStats stats = service.getStats();
+
+	std::printf("%d games, %d threads: %llu moves in %.2f s, p50 %.1f ms, p99 %.1f ms, %llu deadlines missed, "
+		"mean depth %.1f, %llu degraded\n",
+		num_games, service.getNumThreads(), static_cast<unsigned long long>(stats.completed), seconds,
+		stats.p50_latency_ms, stats.p99_latency_ms, static_cast<unsigned long long>(stats.deadlines_missed),
+		stats.mean_depth, static_cast<unsigned long long>(stats.degraded));
+
+	return 0;
+}
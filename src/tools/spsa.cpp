@@ -0,0 +1,334 @@
+// tunes the engine's tunable parameters (see Engine::getParameterInfo()) by playing games,
+// using simultaneous perturbation stochastic approximation (SPSA)
+//
+// every iteration perturbs all the parameters at once in a random direction, plays the engine
+// with the parameters nudged one way against the engine with them nudged the other way,
+// and moves the parameters towards whichever side scored better
+//
+// usage: checkers_spsa CHECKPOINT [--iterations N] [--pairs N] [--threads N] [--depth D]
+//                      [--opening-plies N] [--max-plies N] [--learning-rate X] [--seed S]
+//                      [--weights FILE] [--output FILE]
+//   CHECKPOINT          progress is saved here after every iteration, and picked up again
+//                       from here if the file already exists
+//   --iterations N      total iterations to run, including those of a resumed run (default 1000)
+//   --pairs N           colour reversed game pairs per iteration (default 8)
+//   --threads N         games played at once (default: number of cores)
+//   --depth D           search depth of every move (default 4)
+//   --opening-plies N   random plies played before the engines take over (default 6)
+//   --max-plies N       plies after which a game is drawn (default 200)
+//   --learning-rate X   size of the updates in parameter steps (default 1)
+//   --seed S            seed for the perturbations and openings of a new run (default 1)
+//   --weights FILE      evaluation weights to start a new run from (default: the built in weights)
+//   --output FILE       evaluation weights file loadable with --weights, written after every iteration
+
+#include "tools/self_play.h"
+
+#include "engine/engine.h"
+#include "engine/engine_options.h"
+#include "engine/evaluation.h"
+#include "game/game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// exponents from Spall's implementation guidelines
+static constexpr double LEARNING_RATE_DECAY = 0.602;
+static constexpr double PERTURBATION_DECAY = 0.101;
+
+
+struct Checkpoint {
+	int iteration = 0; // iterations completed
+	std::uint32_t seed = 1;
+	std::vector<double> values; // indexed like Engine::getParameterInfo(), kept unrounded between iterations
+};
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_spsa CHECKPOINT [--iterations N] [--pairs N] [--threads N] [--depth D]\n"
+		<< "                     [--opening-plies N] [--max-plies N] [--learning-rate X] [--seed S]\n"
+		<< "                     [--weights FILE] [--output FILE]\n";
+}
+
+
+// checkpoint layout: "iteration N", "seed S", then one "name value" line per parameter
+static bool loadCheckpoint(const std::string &path, Checkpoint *checkpoint) {
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::istringstream fields(line);
+		std::string name;
+
+		if (!(fields >> name) || name[0] == '#') {
+			continue;
+		}
+
+		if (name == "iteration") {
+			fields >> checkpoint->iteration;
+		} else if (name == "seed") {
+			fields >> checkpoint->seed;
+		} else {
+			int index = Engine::findParameter(name);
+			if (index < 0) {
+				std::cerr << "Unknown parameter in checkpoint: " << name << '\n';
+				return false;
+			}
+			fields >> checkpoint->values[index];
+		}
+
+		if (fields.fail()) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// writes to a temporary file first so an interrupted write can't lose the previous checkpoint
+static bool saveCheckpoint(const std::string &path, const Checkpoint &checkpoint) {
+	std::string temporary_path = path + ".tmp";
+	std::ofstream file(temporary_path);
+
+	// every digit a double needs, so a resumed run carries on from exactly the values it stopped at
+	file << std::setprecision(std::numeric_limits<double>::max_digits10);
+	file << "iteration " << checkpoint.iteration << '\n';
+	file << "seed " << checkpoint.seed << '\n';
+
+	for (int i = 0; i < Engine::getNumParameters(); i++) {
+		file << Engine::getParameterInfo(i).name << ' ' << checkpoint.values[i] << '\n';
+	}
+
+	file.close();
+
+	return !file.fail() && std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+
+// writes the parameters that are evaluation weights in the format read by EvalWeights::loadFromFile()
+static bool saveWeights(const std::string &path, const Engine &engine, const EvalWeights &base_weights) {
+	EvalWeights weights = base_weights;
+
+	for (int i = 0; i < Engine::getNumParameters(); i++) {
+		int term = findEvalTerm(Engine::getParameterInfo(i).name);
+		if (term >= 0) {
+			weights.values[term] = engine.getParameter(i);
+		}
+	}
+
+	return weights.saveToFile(path);
+}
+
+
+static void applyValues(Engine *engine, const std::vector<double> &values) {
+	for (int i = 0; i < Engine::getNumParameters(); i++) {
+		engine->setParameter(i, static_cast<int>(std::lround(values[i])));
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	const char *checkpoint_path = nullptr;
+	const char *output_path = nullptr;
+	int num_iterations = 1000;
+	int num_pairs = 8;
+	int num_threads = std::max(1u, std::thread::hardware_concurrency());
+	int opening_plies = 6;
+	double learning_rate = 1.0;
+	std::uint32_t seed = 1;
+	EngineOptions engine_options;
+	SelfPlaySettings settings;
+	settings.black_limits.depth = 4;
+	settings.white_limits.depth = 4;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+			num_iterations = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--pairs") == 0 && i + 1 < argc) {
+			num_pairs = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+			settings.black_limits.depth = settings.white_limits.depth = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--opening-plies") == 0 && i + 1 < argc) {
+			opening_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--max-plies") == 0 && i + 1 < argc) {
+			settings.max_plies = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--learning-rate") == 0 && i + 1 < argc) {
+			learning_rate = std::atof(argv[++i]);
+		} else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+			seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+			engine_options.weights_file = argv[++i];
+		} else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			output_path = argv[++i];
+		} else if (checkpoint_path == nullptr) {
+			checkpoint_path = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (checkpoint_path == nullptr) {
+		printUsage();
+		return 1;
+	}
+
+	const int num_parameters = Engine::getNumParameters();
+
+	// the engine built from the options provides the starting values and every weight that isn't tuned
+	Engine base_engine(engine_options);
+	EvalWeights base_weights = EvalWeights::defaults();
+	if (!engine_options.weights_file.empty()) {
+		base_weights.loadFromFile(engine_options.weights_file);
+	}
+
+	Checkpoint checkpoint;
+	checkpoint.seed = seed;
+	for (int i = 0; i < num_parameters; i++) {
+		checkpoint.values.push_back(base_engine.getParameter(i));
+	}
+
+	if (std::ifstream(checkpoint_path)) {
+		if (!loadCheckpoint(checkpoint_path, &checkpoint)) {
+			std::cerr << "Could not read checkpoint " << checkpoint_path << '\n';
+			return 1;
+		}
+		std::printf("resuming from iteration %d\n", checkpoint.iteration);
+	}
+
+	// spall suggests a stability constant of around a tenth of the iterations
+	const double stability = num_iterations / 10.0;
+
+	// each worker keeps its pair of engines for the whole run, only their parameters change
+	std::vector<std::unique_ptr<Engine>> plus_engines;
+	std::vector<std::unique_ptr<Engine>> minus_engines;
+	for (int worker = 0; worker < num_threads; worker++) {
+		plus_engines.push_back(std::unique_ptr<Engine>(new Engine(engine_options)));
+		minus_engines.push_back(std::unique_ptr<Engine>(new Engine(engine_options)));
+	}
+
+	while (checkpoint.iteration < num_iterations) {
+		const int k = checkpoint.iteration;
+
+		// each iteration gets its own generator so a resumed run plays exactly the same games
+		std::mt19937 rng(checkpoint.seed + static_cast<std::uint32_t>(k) * 7919u);
+
+		double perturbation = 1.0 / std::pow(k + 1.0, PERTURBATION_DECAY);
+		double step_size = learning_rate / std::pow(k + 1.0 + stability, LEARNING_RATE_DECAY);
+
+		std::vector<double> plus_values(num_parameters);
+		std::vector<double> minus_values(num_parameters);
+		std::vector<int> directions(num_parameters);
+
+		for (int i = 0; i < num_parameters; i++) {
+			const EngineParameter &parameter = Engine::getParameterInfo(i);
+			directions[i] = (rng() & 1) ? 1 : -1;
+			plus_values[i] = checkpoint.values[i] + perturbation * parameter.step * directions[i];
+			minus_values[i] = checkpoint.values[i] - perturbation * parameter.step * directions[i];
+		}
+
+		std::vector<Game> openings;
+		for (int pair = 0; pair < num_pairs; pair++) {
+			openings.push_back(randomOpening(rng, opening_plies));
+		}
+
+		// games are handed out to the workers one at a time, game 2n and 2n + 1 share an opening
+		// the tables are emptied before every game, so its result doesn't depend on which worker plays it
+		// or what that worker played before, and a resumed run plays the same games
+		std::atomic<int> next_game(0);
+		std::vector<double> plus_scores(num_threads, 0.0);
+		std::vector<std::thread> workers;
+
+		for (int worker = 0; worker < num_threads; worker++) {
+			workers.emplace_back([&, worker]() {
+				Engine &plus_engine = *plus_engines[worker];
+				Engine &minus_engine = *minus_engines[worker];
+				applyValues(&plus_engine, plus_values);
+				applyValues(&minus_engine, minus_values);
+
+				int game_index;
+				while ((game_index = next_game++) < 2 * num_pairs) {
+					const Game &opening = openings[game_index / 2];
+					bool plus_is_black = (game_index % 2 == 0);
+
+					plus_engine.clearHash();
+					minus_engine.clearHash();
+
+					GameResult result = plus_is_black
+						? playGame(opening, plus_engine, minus_engine, settings)
+						: playGame(opening, minus_engine, plus_engine, settings);
+
+					if (result == GameResult::DRAW) {
+						plus_scores[worker] += 0.5;
+					} else if ((result == GameResult::BLACK_WIN) == plus_is_black) {
+						plus_scores[worker] += 1.0;
+					}
+				}
+			});
+		}
+
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+
+		double plus_score = 0.0;
+		for (double score : plus_scores) {
+			plus_score += score;
+		}
+
+		// +1 if the plus side won every game, -1 if the minus side did
+		double outcome = (2.0 * plus_score - 2 * num_pairs) / (2 * num_pairs);
+
+		for (int i = 0; i < num_parameters; i++) {
+			const EngineParameter &parameter = Engine::getParameterInfo(i);
+			double value = checkpoint.values[i] + step_size * parameter.step * outcome * directions[i] / perturbation;
+			checkpoint.values[i] = std::min(std::max(value, static_cast<double>(parameter.min_value)),
+				static_cast<double>(parameter.max_value));
+		}
+
+		checkpoint.iteration++;
+
+		if (!saveCheckpoint(checkpoint_path, checkpoint)) {
+			std::cerr << "Could not write checkpoint " << checkpoint_path << '\n';
+			return 1;
+		}
+
+		applyValues(&base_engine, checkpoint.values);
+
+		if (output_path != nullptr && !saveWeights(output_path, base_engine, base_weights)) {
+			std::cerr << "Could not write " << output_path << '\n';
+			return 1;
+		}
+
+		std::printf("iteration %5d  score %5.1f/%d ", checkpoint.iteration, plus_score, 2 * num_pairs);
+		for (int i = 0; i < num_parameters; i++) {
+			std::printf(" %s %.1f", Engine::getParameterInfo(i).name, checkpoint.values[i]);
+		}
+		std::printf("\n");
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+// generates the endgame tablebases: the win, loss or draw value of every position with up to a
+// given number of pieces, one file per material signature (see src/engine/tablebase.cpp)
+//
+// usage: checkers_tbgen DIRECTORY [--pieces N] [--threads N]
+//        checkers_tbgen DIRECTORY --plan [--pieces N] [--slices N]
+//        checkers_tbgen DIRECTORY --work [--threads N]
+//        checkers_tbgen DIRECTORY --status
+//        checkers_tbgen DIRECTORY --release
+//   DIRECTORY     where the tables are written, which must already exist
+//   --pieces N    most pieces on the board (default 4)
+//   --threads N   worker threads (default: number of cores)
+//   --plan        split the work into jobs for --work instead of generating the tables
+//   --slices N    most slices each level of a signature is split into (default 16)
+//   --work        carry out planned jobs until there are none left, any number of processes on any
+//                 number of machines sharing DIRECTORY can do this at once
+//   --status      count the planned jobs that are done and running
+//   --release     free the jobs of workers that died on another machine, with no workers running
+//
+// the signatures are solved smallest first as each needs the tables its captures and crownings lead to,
+// and tables that already exist are kept, so an interrupted run picks up where it left off
+// the same goes for the jobs of an interrupted worker, which another worker on its machine picks up
+
+#include "engine/tablebase.h"
+#include "engine/tablebase_generator.h"
+#include "engine/tablebase_jobs.h"
+
+#include <algorithm> // for std::max
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_tbgen DIRECTORY [--pieces N] [--threads N]\n"
+		<< "       checkers_tbgen DIRECTORY --plan [--pieces N] [--slices N]\n"
+		<< "       checkers_tbgen DIRECTORY --work [--threads N]\n"
+		<< "       checkers_tbgen DIRECTORY --status\n"
+		<< "       checkers_tbgen DIRECTORY --release\n";
+}
+
+
+static double secondsSince(std::chrono::steady_clock::time_point start_time) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+
+// runs jobs until every job is done, waiting while the ones left need jobs other workers are running
+static int work(TablebaseJobs *jobs) {
+	while (true) {
+		auto start_time = std::chrono::steady_clock::now();
+
+		std::string description;
+		TablebaseJobs::Result result = jobs->runNextJob(&description);
+
+		if (result == TablebaseJobs::ALL_DONE) {
+			return 0;
+		} else if (result == TablebaseJobs::JOB_FAILED) {
+			std::cerr << "Failed: " << description << "\n";
+			return 1;
+		} else if (result == TablebaseJobs::PART_DAMAGED) {
+			std::cerr << "Damaged: " << description << ", making it again\n";
+			continue;
+		} else if (result == TablebaseJobs::NO_JOB_READY) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			continue;
+		}
+
+		std::printf("%-40s %.2f s\n", description.c_str(), secondsSince(start_time));
+		std::fflush(stdout);
+	}
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2 || argv[1][0] == '-') {
+		printUsage();
+		return 1;
+	}
+
+	const std::string directory = argv[1];
+	int max_pieces = 4;
+	int num_threads = 0;
+	int num_slices = 16;
+	bool plan = false;
+	bool run_jobs = false;
+	bool show_status = false;
+	bool release = false;
+
+	for (int i = 2; i < argc; i++) {
+		if (std::strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) {
+			max_pieces = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--slices") == 0 && i + 1 < argc) {
+			num_slices = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--plan") == 0) {
+			plan = true;
+		} else if (std::strcmp(argv[i], "--work") == 0) {
+			run_jobs = true;
+		} else if (std::strcmp(argv[i], "--status") == 0) {
+			show_status = true;
+		} else if (std::strcmp(argv[i], "--release") == 0) {
+			release = true;
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	TablebaseJobs jobs(directory, num_threads);
+
+	if (plan) {
+		int num_jobs;
+		if (!jobs.plan(max_pieces, num_slices, &num_jobs)) {
+			std::cerr << "Failed to write the jobs in " << directory << "\n";
+			return 1;
+		}
+
+		std::printf("%d jobs planned\n", num_jobs);
+		return 0;
+	} else if (run_jobs) {
+		return work(&jobs);
+	} else if (show_status) {
+		TablebaseJobs::Status status = jobs.getStatus();
+		std::printf("%d jobs, %d done, %d running\n", status.jobs, status.done, status.running);
+		return 0;
+	} else if (release) {
+		std::printf("%d jobs released\n", jobs.release());
+		return 0;
+	}
+
+	TablebaseGenerator generator(directory, num_threads);
+
+	for (const MaterialSignature &signature : getSignaturesInOrder(max_pieces)) {
+		const std::string name = getSignatureName(signature);
+
+		if (std::ifstream(getTablePath(directory, signature))) {
+			continue; // written by an earlier run, or along with its flipped signature
+		}
+
+		auto start_time = std::chrono::steady_clock::now();
+
+		TablebaseStats stats;
+		if (!generator.generate(signature, &stats)) {
+			std::cerr << "Failed to generate " << name << " in " << directory << "\n";
+			return 1;
+		}
+
+		std::printf("%-14s %12llu positions: %5.1f%% won, %5.1f%% drawn, %5.1f%% lost, %3d passes, %.2f s\n",
+			name.c_str(), static_cast<unsigned long long>(stats.positions),
+			100.0 * stats.wins / stats.positions, 100.0 * stats.draws / stats.positions,
+			100.0 * stats.losses / stats.positions, stats.passes, secondsSince(start_time));
+		std::fflush(stdout);
+	}
+
+	return 0;
+}
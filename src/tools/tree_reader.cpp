@@ -0,0 +1,232 @@
+// reads a search tree file written by SearchRecorder and prints
+// a summary of move ordering quality and the most expensive subtrees
+//
+// usage: checkers_tree_reader FILE [--top N] [--ply P]
+//   --top N  number of expensive subtrees to list (default 10)
+//   --ply P  only list subtrees rooted at this ply (default: any ply above 0)
+
+#include "engine/search_recorder.h"
+#include "engine/compact_move.h"
+#include "engine/conversion.h"
+#include "game/move.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional> // for std::greater
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+
+struct PlyStatistics {
+	std::uint64_t nodes_by_type[4] = {};
+	std::uint64_t nodes_with_moves = 0; // interior nodes where at least one move was searched
+	std::uint64_t best_move_first = 0;
+	std::uint64_t best_move_index_total = 0;
+	std::uint64_t cut_nodes = 0;
+	std::uint64_t cut_on_first_move = 0;
+	std::uint64_t moves_searched_at_cut_nodes = 0;
+};
+
+
+struct ExpensiveSubtree {
+	u32 time_us;
+	std::uint64_t sequence; // position in the file, used to keep ordering stable
+	SearchTreeNode node;
+
+	bool operator>(const ExpensiveSubtree &other) const {
+		if (time_us != other.time_us) {
+			return time_us > other.time_us;
+		}
+		return sequence < other.sequence;
+	}
+};
+
+
+static std::string getMoveString(const CompactMove &compact_move) {
+	if (!compact_move.exists()) {
+		return "(root)";
+	}
+
+	Move move = convertCompactMoveToNormalMove(compact_move);
+	std::string output;
+
+	for (int i = 0; i < move.getLength(); i++) {
+		if (i > 0) {
+			output += (move.isJump() ? 'x' : '-');
+		}
+		output += std::to_string(move.getPosition(i) + 1);
+	}
+
+	return output;
+}
+
+
+static const char* getTypeName(SearchTreeNode::Type type) {
+	switch (type) {
+		case SearchTreeNode::PV_NODE: return "pv";
+		case SearchTreeNode::CUT_NODE: return "cut";
+		case SearchTreeNode::ALL_NODE: return "all";
+		case SearchTreeNode::LEAF_NODE: return "leaf";
+	}
+	return "?";
+}
+
+
+static double percentage(std::uint64_t part, std::uint64_t whole) {
+	return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_tree_reader FILE [--top N] [--ply P]\n";
+}
+
+
+int main(int argc, char *argv[]) {
+	const char *path = nullptr;
+	int num_top = 10;
+	int only_ply = -1;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+			num_top = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--ply") == 0 && i + 1 < argc) {
+			only_ply = std::atoi(argv[++i]);
+		} else if (path == nullptr) {
+			path = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (path == nullptr) {
+		printUsage();
+		return 1;
+	}
+
+	std::ifstream file(path, std::ios::binary);
+	int max_ply;
+
+	if (!file || !SearchRecorder::readHeader(file, &max_ply)) {
+		std::cerr << "Not a search tree file: " << path << '\n';
+		return 1;
+	}
+
+	std::vector<PlyStatistics> plies(max_ply + 1);
+	std::priority_queue<ExpensiveSubtree, std::vector<ExpensiveSubtree>, std::greater<ExpensiveSubtree>> expensive;
+	std::uint64_t num_records = 0;
+	std::uint64_t num_searches = 0;
+	std::uint64_t total_search_time_us = 0;
+
+	SearchTreeNode node;
+	SearchRecorder::ReadResult read_result;
+
+	while ((read_result = SearchRecorder::readNode(file, &node)) == SearchRecorder::NODE_READ) {
+		num_records++;
+
+		if (node.ply > max_ply) {
+			continue; // corrupt record, ignore it rather than indexing out of range
+		}
+
+		PlyStatistics &stats = plies[node.ply];
+		stats.nodes_by_type[node.type]++;
+
+		if (node.moves_searched > 0) {
+			stats.nodes_with_moves++;
+			stats.best_move_index_total += node.best_move_index;
+			if (node.best_move_index == 0) {
+				stats.best_move_first++;
+			}
+
+			if (node.type == SearchTreeNode::CUT_NODE) {
+				stats.cut_nodes++;
+				stats.moves_searched_at_cut_nodes += node.moves_searched;
+				if (node.moves_searched == 1) {
+					stats.cut_on_first_move++;
+				}
+			}
+		}
+
+		if (node.ply == 0) {
+			num_searches++;
+			total_search_time_us += node.subtree_time_us;
+		}
+
+		bool listable = (only_ply < 0) ? node.ply > 0 : node.ply == only_ply;
+
+		if (listable && num_top > 0) {
+			expensive.push({node.subtree_time_us, num_records, node});
+			if (static_cast<int>(expensive.size()) > num_top) {
+				expensive.pop();
+			}
+		}
+	}
+
+	if (read_result == SearchRecorder::INVALID_RECORD) {
+		std::cerr << "Record " << (num_records + 1) << " is cut short or has an unknown node type: " << path << '\n';
+		return 1;
+	}
+
+	std::printf("%llu nodes recorded over %llu searches (max ply %d), %.3f s searching\n\n",
+		static_cast<unsigned long long>(num_records), static_cast<unsigned long long>(num_searches),
+		max_ply, total_search_time_us / 1e6);
+
+	std::printf("Move ordering by ply:\n");
+	std::printf("%4s %10s %8s %8s %8s %8s %11s %10s %10s %13s\n",
+		"ply", "nodes", "pv", "cut", "all", "leaf", "best first", "avg index", "cut first", "moves at cut");
+
+	for (int ply = 0; ply <= max_ply; ply++) {
+		const PlyStatistics &stats = plies[ply];
+
+		std::uint64_t total = 0;
+		for (std::uint64_t count : stats.nodes_by_type) {
+			total += count;
+		}
+		if (total == 0) {
+			continue;
+		}
+
+		double average_index = stats.nodes_with_moves > 0
+			? static_cast<double>(stats.best_move_index_total) / stats.nodes_with_moves : 0.0;
+		double moves_at_cut = stats.cut_nodes > 0
+			? static_cast<double>(stats.moves_searched_at_cut_nodes) / stats.cut_nodes : 0.0;
+
+		std::printf("%4d %10llu %8llu %8llu %8llu %8llu %10.1f%% %10.2f %9.1f%% %13.2f\n",
+			ply, static_cast<unsigned long long>(total),
+			static_cast<unsigned long long>(stats.nodes_by_type[SearchTreeNode::PV_NODE]),
+			static_cast<unsigned long long>(stats.nodes_by_type[SearchTreeNode::CUT_NODE]),
+			static_cast<unsigned long long>(stats.nodes_by_type[SearchTreeNode::ALL_NODE]),
+			static_cast<unsigned long long>(stats.nodes_by_type[SearchTreeNode::LEAF_NODE]),
+			percentage(stats.best_move_first, stats.nodes_with_moves), average_index,
+			percentage(stats.cut_on_first_move, stats.cut_nodes), moves_at_cut);
+	}
+
+	// pop the heap into a list sorted from most to least expensive
+	std::vector<ExpensiveSubtree> listed;
+	while (!expensive.empty()) {
+		listed.push_back(expensive.top());
+		expensive.pop();
+	}
+
+	if (!listed.empty()) {
+		std::printf("\nMost expensive subtrees:\n");
+		std::printf("%10s %10s %4s %5s %-14s %-4s %11s %11s %11s  %s\n",
+			"time (ms)", "nodes", "ply", "depth", "move", "type", "score", "alpha", "beta", "hash");
+	}
+
+	for (auto it = listed.rbegin(); it != listed.rend(); ++it) {
+		const SearchTreeNode &subtree = it->node;
+		std::printf("%10.3f %10u %4d %5d %-14s %-4s %11d %11d %11d  %016llx\n",
+			subtree.subtree_time_us / 1e3, subtree.subtree_nodes, subtree.ply, subtree.depth,
+			getMoveString(subtree.move).c_str(), getTypeName(subtree.type),
+			subtree.score, subtree.alpha, subtree.beta,
+			static_cast<unsigned long long>(subtree.hash));
+	}
+
+	return 0;
+}
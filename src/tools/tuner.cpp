@@ -0,0 +1,339 @@
+// tunes the evaluation weights to a file of labelled positions using Texel's method:
+// the weights are fitted so that a logistic function of the evaluation predicts the game results
+//
+// usage: checkers_tuner POSITIONS OUTPUT [--weights FILE] [--epochs N] [--threads N]
+//                       [--learning-rate X] [--scale K]
+//   --weights FILE      weights to start from (default: the built in weights)
+//   --epochs N          passes of gradient descent over the positions (default 500)
+//   --threads N         worker threads (default: number of cores)
+//   --learning-rate X   step size of the optimiser in weight units (default 1)
+//   --scale K           scaling of the logistic function (default: fitted to the starting weights)
+//
+// every position is resolved with a captures only search first, so the static evaluation
+// is only ever fitted to quiet positions. the features of the resolved positions are kept
+// in memory, which takes around 20 bytes per position.
+
+#include "engine/bitboard_masks.h"
+#include "engine/bitboard_movegen.h"
+#include "engine/evaluation.h"
+#include "engine/position_file.h"
+#include "engine/quiescence.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// the man weight is left alone so the other weights stay in the same units as the search expects
+static constexpr int ANCHOR_TERM = EVAL_MAN;
+
+static constexpr int READ_BATCH_SIZE = 1 << 16;
+
+
+struct TrainingSample {
+	std::int16_t features[NUM_EVAL_TERMS];
+	float target; // result from black's point of view: 1 for a win, 0.5 for a draw, 0 for a loss
+};
+
+
+struct BatchResult {
+	double loss = 0.0;
+	double gradient[NUM_EVAL_TERMS] = {};
+};
+
+
+static void printUsage() {
+	std::cerr << "usage: checkers_tuner POSITIONS OUTPUT [--weights FILE] [--epochs N] [--threads N]\n"
+		<< "                      [--learning-rate X] [--scale K]\n";
+}
+
+
+static double sigmoid(double eval, double scale) {
+	return 1.0 / (1.0 + std::pow(10.0, -scale * eval / 400.0));
+}
+
+
+static double dotProduct(const std::int16_t *features, const double *weights) {
+	double eval = 0.0;
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		eval += features[term] * weights[term];
+	}
+	return eval;
+}
+
+
+// splits count items into num_threads contiguous ranges and runs work(begin, end, thread_index) on each
+template <typename Work>
+static void runInParallel(std::size_t count, int num_threads, Work work) {
+	std::vector<std::thread> threads;
+	std::size_t per_thread = (count + num_threads - 1) / num_threads;
+
+	for (int i = 0; i < num_threads; i++) {
+		std::size_t begin = std::min(count, i * per_thread);
+		std::size_t end = std::min(count, begin + per_thread);
+		threads.emplace_back(work, begin, end, i);
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+
+// resolves captures in each position and keeps the features of the quiet position reached
+// positions where the side to move has lost once the captures are over are dropped,
+// since the evaluation has no say in those
+static void resolveBatch(const std::vector<LabelledPosition> &batch, const EvalWeights &weights,
+		int num_threads, std::vector<TrainingSample> *samples) {
+	std::vector<std::vector<TrainingSample>> resolved(num_threads);
+
+	runInParallel(batch.size(), num_threads, [&](std::size_t begin, std::size_t end, int thread_index) {
+		std::vector<TrainingSample> &output = resolved[thread_index];
+
+		for (std::size_t i = begin; i < end; i++) {
+			const LabelledPosition &position = batch[i];
+			QuietPosition quiet;
+
+			quiescence(position.board, position.is_whites_turn, -INT_MAX, INT_MAX, weights, &quiet);
+
+			u32 movables[NUM_DIRECTIONS];
+			findMovablePieces(quiet.board, quiet.is_whites_turn, movables);
+			if ((movables[0] | movables[1] | movables[2] | movables[3]) == 0) {
+				continue;
+			}
+
+			int features[NUM_EVAL_TERMS];
+			computeEvalFeatures(quiet.board, features);
+
+			TrainingSample sample;
+			for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+				sample.features[term] = static_cast<std::int16_t>(features[term]);
+			}
+			sample.target = static_cast<float>(position.result) / LabelledPosition::BLACK_WIN;
+
+			output.push_back(sample);
+		}
+	});
+
+	for (const std::vector<TrainingSample> &output : resolved) {
+		samples->insert(samples->end(), output.begin(), output.end());
+	}
+}
+
+
+// returns the mean cross entropy of the predicted results, and its gradient with respect to the weights if asked
+static BatchResult computeLoss(const std::vector<TrainingSample> &samples, const double *weights,
+		double scale, int num_threads, bool with_gradient) {
+	std::vector<BatchResult> partials(num_threads);
+	const double gradient_factor = scale * std::log(10.0) / 400.0;
+
+	runInParallel(samples.size(), num_threads, [&](std::size_t begin, std::size_t end, int thread_index) {
+		BatchResult &partial = partials[thread_index];
+
+		for (std::size_t i = begin; i < end; i++) {
+			const TrainingSample &sample = samples[i];
+			double predicted = sigmoid(dotProduct(sample.features, weights), scale);
+			double clamped = std::min(std::max(predicted, 1e-12), 1.0 - 1e-12);
+
+			partial.loss -= sample.target * std::log(clamped) + (1.0 - sample.target) * std::log(1.0 - clamped);
+
+			if (with_gradient) {
+				double error = (predicted - sample.target) * gradient_factor;
+				for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+					partial.gradient[term] += error * sample.features[term];
+				}
+			}
+		}
+	});
+
+	BatchResult total;
+
+	for (const BatchResult &partial : partials) {
+		total.loss += partial.loss;
+		for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+			total.gradient[term] += partial.gradient[term];
+		}
+	}
+
+	double count = std::max<std::size_t>(samples.size(), 1);
+	total.loss /= count;
+	for (double &value : total.gradient) {
+		value /= count;
+	}
+
+	return total;
+}
+
+
+// finds the scaling of the logistic function that best fits the starting weights,
+// narrowing in on the minimum loss with a golden section search
+static double fitScale(const std::vector<TrainingSample> &samples, const double *weights, int num_threads) {
+	const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+	double low = 0.01;
+	double high = 10.0;
+
+	for (int i = 0; i < 40; i++) {
+		double left = high - ratio * (high - low);
+		double right = low + ratio * (high - low);
+
+		if (computeLoss(samples, weights, left, num_threads, false).loss
+				< computeLoss(samples, weights, right, num_threads, false).loss) {
+			high = right;
+		} else {
+			low = left;
+		}
+	}
+
+	return (low + high) / 2.0;
+}
+
+
+int main(int argc, char *argv[]) {
+	const char *positions_path = nullptr;
+	const char *output_path = nullptr;
+	const char *weights_path = nullptr;
+	int num_epochs = 500;
+	int num_threads = std::max(1u, std::thread::hardware_concurrency());
+	double learning_rate = 1.0;
+	double scale = 0.0;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+			weights_path = argv[++i];
+		} else if (std::strcmp(argv[i], "--epochs") == 0 && i + 1 < argc) {
+			num_epochs = std::atoi(argv[++i]);
+		} else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			num_threads = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--learning-rate") == 0 && i + 1 < argc) {
+			learning_rate = std::atof(argv[++i]);
+		} else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+			scale = std::atof(argv[++i]);
+		} else if (positions_path == nullptr) {
+			positions_path = argv[i];
+		} else if (output_path == nullptr) {
+			output_path = argv[i];
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (positions_path == nullptr || output_path == nullptr) {
+		printUsage();
+		return 1;
+	}
+
+	EvalWeights initial_weights = EvalWeights::defaults();
+
+	if (weights_path != nullptr && !initial_weights.loadFromFile(weights_path)) {
+		std::cerr << "Could not load weights " << weights_path << '\n';
+		return 1;
+	}
+
+	PositionFileReader reader;
+
+	if (!reader.open(positions_path)) {
+		std::cerr << "Not a position file: " << positions_path << '\n';
+		return 1;
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<TrainingSample> samples;
+	std::vector<LabelledPosition> batch;
+	std::uint64_t num_read = 0;
+	LabelledPosition position;
+	PositionFileReader::ReadResult read_result;
+
+	while ((read_result = reader.read(&position)) == PositionFileReader::POSITION_READ) {
+		batch.push_back(position);
+		num_read++;
+
+		if (batch.size() == READ_BATCH_SIZE) {
+			resolveBatch(batch, initial_weights, num_threads, &samples);
+			batch.clear();
+		}
+	}
+
+	if (read_result == PositionFileReader::INVALID_RECORD) {
+		std::cerr << "Position " << (num_read + 1) << " of " << positions_path << " is invalid\n";
+		return 1;
+	}
+
+	resolveBatch(batch, initial_weights, num_threads, &samples);
+
+	double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+	std::printf("%llu positions read, %zu quiet positions kept (%.2f s)\n",
+		static_cast<unsigned long long>(num_read), samples.size(), load_seconds);
+
+	if (samples.empty()) {
+		std::cerr << "No positions to tune with\n";
+		return 1;
+	}
+
+	double weights[NUM_EVAL_TERMS];
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		weights[term] = initial_weights.values[term];
+	}
+
+	if (scale <= 0.0) {
+		scale = fitScale(samples, weights, num_threads);
+	}
+
+	std::printf("scale %.4f, starting loss %.6f\n", scale,
+		computeLoss(samples, weights, scale, num_threads, false).loss);
+
+	// adam keeps the step size in weight units, so terms whose features are rare still move
+	const double beta_1 = 0.9;
+	const double beta_2 = 0.999;
+	double moment_1[NUM_EVAL_TERMS] = {};
+	double moment_2[NUM_EVAL_TERMS] = {};
+
+	for (int epoch = 1; epoch <= num_epochs; epoch++) {
+		BatchResult result = computeLoss(samples, weights, scale, num_threads, true);
+
+		for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+			if (term == ANCHOR_TERM) {
+				continue;
+			}
+
+			moment_1[term] = beta_1 * moment_1[term] + (1.0 - beta_1) * result.gradient[term];
+			moment_2[term] = beta_2 * moment_2[term] + (1.0 - beta_2) * result.gradient[term] * result.gradient[term];
+
+			double corrected_1 = moment_1[term] / (1.0 - std::pow(beta_1, epoch));
+			double corrected_2 = moment_2[term] / (1.0 - std::pow(beta_2, epoch));
+
+			weights[term] -= learning_rate * corrected_1 / (std::sqrt(corrected_2) + 1e-12);
+		}
+
+		if (epoch % 50 == 0 || epoch == num_epochs) {
+			std::printf("epoch %5d  loss %.6f\n", epoch, result.loss);
+		}
+	}
+
+	EvalWeights tuned_weights;
+	for (int term = 0; term < NUM_EVAL_TERMS; term++) {
+		tuned_weights.values[term] = static_cast<int>(std::lround(weights[term]));
+		std::printf("%-10s %6d -> %6d\n", getEvalTermName(term),
+			initial_weights.values[term], tuned_weights.values[term]);
+	}
+
+	std::printf("final loss %.6f\n", computeLoss(samples, weights, scale, num_threads, false).loss);
+
+	if (!tuned_weights.saveToFile(output_path)) {
+		std::cerr << "Could not write " << output_path << '\n';
+		return 1;
+	}
+
+	return 0;
+}
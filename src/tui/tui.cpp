@@ -7,8 +7,15 @@
 #include "game/player.h"
 #include "game/matchtype.h"
 #include "game/coord.h"
+#include "engine/conversion.h"
+#include "engine/analysis.h"
+#include "engine/score.h"
 
 #include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
 #include <cassert>
 #include <iomanip> // for number padding
 #include <algorithm> // for std::min
@@ -21,12 +28,19 @@ int Tui::run(int argc, char *argv[]) {
 	printIntro();
 	
 	do {
-		m_game.newGame(askForMatchType());
+		MatchType match_type;
+		if (!askForMatchType(&match_type)) {
+			return 0;
+		}
+		
+		m_game.newGame(match_type);
 		printMatchType();
 		
 		while (!m_game.isOver()) {
 			printGameState();
-			doNextMove();
+			if (!doNextMove()) {
+				return 0;
+			}
 		}
 		
 		printGameState();
@@ -38,6 +52,21 @@ int Tui::run(int argc, char *argv[]) {
 }
 
 
+/**
+ * Reads a line of the user's input.
+ * @param line Set to the line, without its newline.
+ * @return False if the input has ended, after starting a new line so the prompt isn't left hanging.
+ */
+bool Tui::readLine(std::string *line) {
+	if (!std::getline(std::cin, *line)) {
+		std::cout << '\n';
+		return false;
+	}
+	
+	return true;
+}
+
+
 /**
  * Prints a welcome message.
  */
@@ -50,9 +79,10 @@ void Tui::printIntro() const {
 /**
  * Asks the user what match type they want this game to be.
  * Eg. Human vs Computer, Human vs Human, etc...
- * @return The match type the user chose.
+ * @param match_type Set to the match type the user chose.
+ * @return False if the input ended before a choice was made.
  */
-MatchType Tui::askForMatchType() const {
+bool Tui::askForMatchType(MatchType *match_type) const {
 	std::cout << "Please choose between the following match types:\n";
 	std::cout << "\t(1) Human vs Human\n";
 	std::cout << "\t(2) Human vs Computer\n";
@@ -63,17 +93,23 @@ MatchType Tui::askForMatchType() const {
 	while (true) {
 		std::cout << "Enter the number of your choice: ";
 		std::string choice;
-		std::getline(std::cin, choice);
+		if (!readLine(&choice)) {
+			return false;
+		}
 		
 		if (choice == "1") {
-			return MatchType::HUMAN_VS_HUMAN;
+			*match_type = MatchType::HUMAN_VS_HUMAN;
 		} else if (choice == "2") {
-			return MatchType::HUMAN_VS_COMPUTER;
+			*match_type = MatchType::HUMAN_VS_COMPUTER;
 		} else if (choice == "3") {
-			return MatchType::COMPUTER_VS_HUMAN;
+			*match_type = MatchType::COMPUTER_VS_HUMAN;
 		} else if (choice == "4") {
-			return MatchType::COMPUTER_VS_COMPUTER;
+			*match_type = MatchType::COMPUTER_VS_COMPUTER;
+		} else {
+			continue;
 		}
+		
+		return true;
 	}
 
 }
@@ -124,35 +160,49 @@ void Tui::printGameState() const {
 /**
  * Handles doing the next move.
  * The move is first queried (either from the user or engine) and then executed.
+ * @return False if the input ended before the user entered their move.
  */
-void Tui::doNextMove() {
+bool Tui::doNextMove() {
 	Move move;
 	
 	if (m_game.getPlayerType(m_game.getTurn()) == Player::HUMAN) {
-		move = askForMove();
+		if (!askForMove(&move)) {
+			return false;
+		}
 	} else {
 		move = getComputerMove();
 	}
 	
 	printMoveMade(m_game.getTurn(), move);
 	
+	const bool computer_moved = (m_game.getPlayerType(m_game.getTurn()) == Player::COMPUTER);
+	
 	bool move_successful = m_game.doMove(move);
 	
 	assert(move_successful);
 	
+	// the computer thinks on the human's time about the reply it expects
+	if (computer_moved && !m_game.isOver() && m_game.getPlayerType(m_game.getTurn()) == Player::HUMAN) {
+		m_ponderer.start(m_game, m_expected_reply, SearchLimits());
+	}
+	
 	std::cout << '\n';
+	
+	return true;
 }
 
 
 /**
  * Asks the user if they want to play again.
- * @return True if they want to play again, false otherwise.
+ * @return True if they want to play again, false otherwise or if the input ended.
  */
 bool Tui::askToPlayAgain() const {
 	while (true) {
 		std::cout << "Would you like to play again? ";
 		std::string input;
-		std::getline(std::cin, input);
+		if (!readLine(&input)) {
+			return false;
+		}
 		
 		if (input[0] == 'y' || input[0] == 'Y') {
 			std::cout << '\n';
@@ -259,22 +309,73 @@ void Tui::printMovesAvailable() const {
 
 /**
  * Asks the user to enter a move to do and verifies that it is valid.
- * @return The move chosen. It will always be one of the currently available moves.
+ * @param move Set to the move chosen. It will always be one of the currently available moves.
+ * @return False if the input ended before a valid move was entered.
  */
-Move Tui::askForMove() const {
+bool Tui::askForMove(Move *move) {
 	while (true) {
-		std::cout << "Please enter the move to do: ";
+		std::cout << "Please enter the move to do (or \"analyse\"): ";
 		std::string input;
-		std::getline(std::cin, input);
+		if (!readLine(&input)) {
+			return false;
+		}
+		
+		if (input == "analyse") {
+			analysePosition();
+			continue;
+		}
 		
 		std::vector<int> given_indexes = parseMoveString(input);
 		
 		const Move *matching_move = findMatchingMove(given_indexes, m_game.getAvailableMoves());
 		
 		if (matching_move != nullptr) {
-			return *matching_move;
+			*move = *matching_move;
+			return true;
+		}
+	}
+}
+
+
+/**
+ * Lets the engine analyse the current position until the user presses enter.
+ * The best line found so far is printed as the search deepens.
+ */
+void Tui::analysePosition() {
+	// the engine can't ponder and analyse at once, and the ponder would be for a different reply anyway
+	m_ponderer.stop();
+	
+	std::cout << "Analysing, press enter to stop\n";
+	
+	Analysis analysis(&m_engine);
+	analysis.start(m_game);
+	
+	std::atomic<bool> done {false};
+	
+	std::thread printer([&analysis, &done]() {
+		SearchInfo info;
+		
+		while (!done) {
+			while (analysis.poll(&info)) {
+				std::cout << getAnalysisString(info) << '\n';
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
 		}
+	});
+	
+	std::string input;
+	std::getline(std::cin, input);
+	
+	analysis.stop();
+	done = true;
+	printer.join();
+	
+	SearchInfo info;
+	while (analysis.poll(&info)) {
+		std::cout << getAnalysisString(info) << '\n';
 	}
+	
+	std::cout << '\n';
 }
 
 
@@ -286,9 +387,18 @@ Move Tui::askForMove() const {
 Move Tui::getComputerMove() {
 	std::cout << "The computer is thinking...";
 	std::cout.flush();
-	Move move = m_engine.findBestMove(m_game);
+	
+	SearchInfo info;
+	
+	// if the human played the expected reply the search started on their time only has to finish
+	if (!m_ponderer.finish(m_game, &info)) {
+		info = m_engine.search(m_game, SearchLimits());
+	}
+	
+	m_expected_reply = info.ponder_move;
+	
 	std::cout << '\n';
-	return move;
+	return convertCompactMoveToNormalMove(info.best_move);
 }
 
 
@@ -303,11 +413,17 @@ void Tui::printMoveMade(Turn turn, const Move &move) const {
 
 
 /**
- * Prints the winner of the game.
+ * Prints the winner of the game, or that it is drawn.
  * Should only be called when the game is over.
  */
 void Tui::printWinner() const {
 	assert(m_game.isOver());
+	
+	if (m_game.isDraw()) {
+		std::cout << "The game is a draw!\n";
+		return;
+	}
+	
 	std::cout << (m_game.getTurn() == Turn::WHITE ? "Black" : "White") << " wins!\n";
 }
 
@@ -332,6 +448,37 @@ std::string Tui::getMoveString(const Move &move) {
 }
 
 
+/**
+ * Formats an analysis update as a single line.
+ * @param info The update, with the best line found at its depth.
+ * @return The depth, score, search speed and best line.
+ */
+std::string Tui::getAnalysisString(const SearchInfo &info) {
+	std::ostringstream output;
+	
+	std::string score = std::to_string(info.score);
+	if (isDecidedScore(info.score)) {
+		score = (info.score > 0 ? "win " : "loss ") + std::to_string(getPliesToEnd(info.score));
+	} else if (isTablebaseScore(info.score)) {
+		score = (info.score > 0) ? "tbwin" : "tbloss";
+	} else if (isKnownResultScore(info.score)) {
+		score = (info.score > 0) ? "knownwin" : "knownloss";
+	}
+	
+	output << "depth " << std::setw(2) << info.depth << (info.partial ? '+' : ' ')
+		<< " score " << std::setw(8) << score
+		<< " nodes " << std::setw(10) << info.nodes
+		<< " nps " << std::setw(8) << (info.time_ms > 0 ? info.nodes * 1000 / info.time_ms : 0)
+		<< "  ";
+	
+	for (int i = 0; i < info.pv_length; i++) {
+		output << ' ' << getMoveString(convertCompactMoveToNormalMove(info.pv[i]));
+	}
+	
+	return output.str();
+}
+
+
 /**
  * Parses the given move string into a list of position index integers.
  * All characters that aren't numbers are considered separators.
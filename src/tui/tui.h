@@ -4,6 +4,8 @@
 
 #include "game/game.h"
 #include "engine/engine.h"
+#include "engine/ponderer.h"
+#include "engine/compact_move.h"
 
 #include <vector>
 #include <string>
@@ -19,26 +21,33 @@ public:
 
 private:
 	void printIntro() const;
-	MatchType askForMatchType() const;
+	bool askForMatchType(MatchType *match_type) const;
 	void printMatchType() const;
 	void printGameState() const;
-	void doNextMove();
+	bool doNextMove();
 	bool askToPlayAgain() const;
 	void printOutro() const;
 	void printBoard() const;
 	void printTurn() const;
 	void printMovesAvailable() const;
-	Move askForMove() const;
+	bool askForMove(Move *move);
+	void analysePosition();
 	Move getComputerMove();
 	void printMoveMade(Turn turn, const Move &move) const;
 	void printWinner() const;
 
+	static bool readLine(std::string *line);
 	static std::string getMoveString(const Move &move);
+	static std::string getAnalysisString(const SearchInfo &info);
 	static std::vector<int> parseMoveString(const std::string &input);
 	static const Move* findMatchingMove(const std::vector<int> &position_indexes, const std::vector<Move> &moves_available);
 
 	Game m_game;
 	Engine m_engine;
+
+	// searches while a human is thinking about their reply to the computer
+	Ponderer m_ponderer {&m_engine};
+	CompactMove m_expected_reply; // to the computer's last move
 };
 
 